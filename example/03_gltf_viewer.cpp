@@ -1,15 +1,19 @@
 #include "common/Application.h"
+#include "common/ClusteredLighting.h"
 #include "common/RsmTechnique.h"
 #include "common/SceneLoader.h"
+#include "common/TiledDeferredShading.h"
 
 #include <Fwog/BasicTypes.h>
 #include <Fwog/Buffer.h>
+#include <Fwog/Context.h>
 #include <Fwog/DebugMarker.h>
 #include <Fwog/Pipeline.h>
 #include <Fwog/Rendering.h>
 #include <Fwog/Shader.h>
 #include <Fwog/Texture.h>
 #include <Fwog/Timer.h>
+#include <Fwog/UploadRing.h>
 
 #ifdef FWOG_FSR2_ENABLE
   #include "src/ffx-fsr2-api/ffx_fsr2.h"
@@ -20,6 +24,7 @@
 #include <GLFW/glfw3.h>
 
 #include <stb_image.h>
+#include <stb_include.h>
 
 #include <imgui.h>
 #include <imgui_internal.h>
@@ -30,31 +35,43 @@
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 
+#include <algorithm>
 #include <array>
+#include <bit>
 #include <charconv>
+#include <cmath>
 #include <cstring>
 #include <exception>
 #include <optional>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 /* 03_gltf_viewer
  *
  * A simple model viewer for glTF scene files. This example build upon 02_deferred, which implements deferred rendering
- * and reflective shadow maps (RSM). Also implemented in this example are point lights.
+ * and reflective shadow maps (RSM). Also implemented in this example are point lights, which are culled in one of two
+ * ways so each pixel only shades the lights that can affect it:
+ * - Clustered::ClusteredLighting assigns them to clusters of the view frustum, which the shading pass looks up.
+ * - Tiled::TiledDeferredShading shades in compute shaders. It culls lights per screen tile, classifies tiles by the
+ *   lighting they need, and dispatches a specialized shader for each class.
  *
- * The app has three optional arguments that must appear in order.
+ * The light count can be changed in the UI, and a benchmark can be run that measures light culling and shading time
+ * with 16 to 65536 lights with each culling mode. The benchmark scales the light radius with the count, so that the
+ * lights cover the same volume at every step.
+ *
+ * The app has four optional arguments that must appear in order.
  * If a later option is used, the previous options must be use used as well.
  *
  * Options
  * Filename (string) : name of the glTF file you wish to view.
  * Scale (real)      : uniform scale factor in case the model is tiny or huge. Default: 1.0
  * Binary (int)      : whether the input file is binary glTF. Default: false
+ * Compress (string) : block-compress PNG and JPEG images with the given quality: none, fast, normal, or high.
+ *                     Default: none
  *
  * If no options are specified, the default scene will be loaded.
- *
- * TODO: add clustered light culling
  */
 
 static glm::uint pcg_hash(glm::uint seed)
@@ -106,6 +123,7 @@ struct ShadingUniforms
   glm::mat4 sunView;
   glm::mat4 sunProj;
   glm::vec2 random;
+  uint32_t useClusteredLighting;
 };
 
 struct ShadowUniforms
@@ -132,6 +150,15 @@ struct alignas(16) Light
   // uint32_t type; // 0 = point, 1 = spot
 };
 
+static std::string LoadFileWithInclude(std::string_view path, std::string_view includeDir)
+{
+  char error[256] = {};
+  char* included = stb_include_string(Application::LoadFile(path).data(), nullptr, includeDir.data(), "", error);
+  std::string includedStr = included;
+  free(included);
+  return includedStr;
+}
+
 static constexpr std::array<Fwog::VertexInputBindingDescription, 3> sceneInputBindingDescs{
   Fwog::VertexInputBindingDescription{
     .location = 0,
@@ -183,8 +210,8 @@ static Fwog::GraphicsPipeline CreateShadowPipeline()
 static Fwog::GraphicsPipeline CreateShadingPipeline()
 {
   auto vs = Fwog::Shader(Fwog::PipelineStage::VERTEX_SHADER, Application::LoadFile("shaders/FullScreenTri.vert.glsl"));
-  auto fs =
-    Fwog::Shader(Fwog::PipelineStage::FRAGMENT_SHADER, Application::LoadFile("shaders/ShadeDeferredPbr.frag.glsl"));
+  auto fs = Fwog::Shader(Fwog::PipelineStage::FRAGMENT_SHADER,
+                         LoadFileWithInclude("shaders/ShadeDeferredPbr.frag.glsl", "shaders"));
 
   return Fwog::GraphicsPipeline({
     .vertexShader = &vs,
@@ -230,12 +257,23 @@ private:
   void OnRender(double dt) override;
   void OnGui(double dt) override;
 
+  // Replaces the point lights with lightCount randomly placed lights
+  void CreateLights();
+
+  void StartLightBenchmark();
+  void UpdateLightBenchmark();
+
+  // Lights that were left out of full light lists in a recent frame
+  [[nodiscard]] uint32_t GetDroppedLightCount() const;
+
   // constants
   static constexpr int gShadowmapWidth = 2048;
   static constexpr int gShadowmapHeight = 2048;
 
   double illuminationTime = 0;
   double fsr2Time = 0;
+  double lightCullingTime = 0;
+  double shadingTime = 0;
 
   // scene parameters
   float sunPosition = -1.127f;
@@ -284,7 +322,6 @@ private:
   Fwog::TypedBuffer<GlobalUniforms> globalUniformsBuffer;
   Fwog::TypedBuffer<ShadingUniforms> shadingUniformsBuffer;
   Fwog::TypedBuffer<ShadowUniforms> shadowUniformsBuffer;
-  Fwog::TypedBuffer<Utility::GpuMaterial> materialUniformsBuffer;
   Fwog::TypedBuffer<glm::mat4> rsmUniforms;
 
   Fwog::GraphicsPipeline scenePipeline;
@@ -295,9 +332,59 @@ private:
 
   // Scene
   Utility::Scene scene;
+  size_t geometryMoveCount = 0; // Allocations moved by the last defragmentation
   std::optional<Fwog::TypedBuffer<Light>> lightBuffer;
+
+  // Point lights
+  uint32_t lightCount = 256;
+  float lightRadius = 1.0f;
+  float lightIntensity = 1.0f;
+  glm::vec3 lightAreaExtent = {5, 2, 5};
+  enum class LightCullingMode
+  {
+    NONE,
+    CLUSTERED,
+    TILED,
+  };
+  LightCullingMode lightCullingMode = LightCullingMode::CLUSTERED;
+  std::optional<Clustered::ClusteredLighting> clusteredLighting;
+  std::optional<Tiled::TiledDeferredShading> tiledShading;
+
+  // Each step of the benchmark renders a number of frames with a light count and light culling mode
+  struct LightBenchmarkStep
+  {
+    uint32_t lightCount;
+    LightCullingMode cullingMode;
+    float lightRadius;
+  };
+
+  struct LightBenchmarkResult
+  {
+    LightBenchmarkStep step;
+    double lightCullingTime;
+    double shadingTime;
+    uint32_t droppedLights; // The most that were dropped in a measured frame
+  };
+
+  struct LightBenchmark
+  {
+    std::vector<LightBenchmarkStep> steps;
+    size_t stepIndex = 0;
+    uint32_t frame = 0;
+    double lightCullingTimeSum = 0;
+    double shadingTimeSum = 0;
+    uint32_t droppedLights = 0;
+
+    // Restored when the benchmark finishes
+    LightBenchmarkStep originalSettings;
+  };
+  std::optional<LightBenchmark> lightBenchmark;
+  std::vector<LightBenchmarkResult> lightBenchmarkResults;
   std::optional<Fwog::TypedBuffer<ObjectUniforms>> meshUniformBuffer;
 
+  // Per-frame material uniforms are streamed through this instead of being updated in place between draws
+  std::optional<Fwog::UploadRing> uploadRing;
+
   // Post processing
   std::optional<Fwog::Texture> noiseTexture;
 
@@ -339,7 +426,6 @@ GltfViewerApplication::GltfViewerApplication(const Application::CreateInfo& crea
     globalUniformsBuffer(Fwog::BufferStorageFlag::DYNAMIC_STORAGE),
     shadingUniformsBuffer(Fwog::BufferStorageFlag::DYNAMIC_STORAGE),
     shadowUniformsBuffer(shadowUniforms, Fwog::BufferStorageFlag::DYNAMIC_STORAGE),
-    materialUniformsBuffer(Fwog::BufferStorageFlag::DYNAMIC_STORAGE),
     rsmUniforms(Fwog::BufferStorageFlag::DYNAMIC_STORAGE),
     // Create the pipelines used in the application
     scenePipeline(CreateScenePipeline()),
@@ -383,37 +469,130 @@ GltfViewerApplication::GltfViewerApplication(const Application::CreateInfo& crea
     meshUniforms.push_back({scene.meshes[i].transform});
   }
 
-  //////////////////////////////////////// Clustered rendering stuff
-  std::vector<Light> lights;
-  // lights.push_back(Light{ .position = { 3, 2, 0, 0 }, .intensity = { .2f, .8f, 1.0f }, .invRadius = 1.0f / 4.0f });
-  // lights.push_back(Light{ .position = { 3, -2, 0, 0 }, .intensity = { .7f, .8f, 0.1f }, .invRadius = 1.0f / 2.0f });
-  // lights.push_back(Light{ .position = { 3, 2, 0, 0 }, .intensity = { 1.2f, .8f, .1f }, .invRadius = 1.0f / 6.0f });
-
   meshUniformBuffer.emplace(meshUniforms, Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
 
-  lightBuffer.emplace(lights, Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
-
-  // clusterTexture({.imageType = Fwog::ImageType::TEX_3D,
-  //                                      .format = Fwog::Format::R16G16_UINT,
-  //                                      .extent = {16, 9, 24},
-  //                                      .mipLevels = 1,
-  //                                      .arrayLayers = 1,
-  //                                      .sampleCount = Fwog::SampleCount::SAMPLES_1},
-  //                                     "Cluster Texture");
-
-  //// atomic counter + uint array
-  // clusterIndicesBuffer = Fwog::Buffer(sizeof(uint32_t) + sizeof(uint32_t) * 10000);
-  // const uint32_t zero = 0; // what it says on the tin
-  // clusterIndicesBuffer.ClearSubData(0,
-  //                                   clusterIndicesBuffer.Size(),
-  //                                   Fwog::Format::R32_UINT,
-  //                                   Fwog::UploadFormat::R,
-  //                                   Fwog::UploadType::UINT,
-  //                                   &zero);
+  // Each material's uniforms are uploaded once per frame
+  const auto uniformAlignment = static_cast<size_t>(Fwog::GetDeviceProperties().limits.uniformBufferOffsetAlignment);
+  const auto materialStride = (sizeof(Utility::GpuMaterial) + uniformAlignment - 1) / uniformAlignment * uniformAlignment;
+  uploadRing.emplace(std::max<size_t>(scene.materials.size(), 1) * materialStride);
+
+  clusteredLighting.emplace();
+  tiledShading.emplace();
+  CreateLights();
 
   OnWindowResize(windowWidth, windowHeight);
 }
 
+void GltfViewerApplication::CreateLights()
+{
+  // Use a fixed seed so the lights don't move when their count changes and benchmark results are comparable
+  glm::uint lightSeed = pcg_hash(1234);
+
+  std::vector<Light> lights;
+  lights.reserve(lightCount);
+  for (uint32_t i = 0; i < lightCount; i++)
+  {
+    const auto position = glm::vec3{rng(lightSeed) * 2 - 1, rng(lightSeed), rng(lightSeed) * 2 - 1} * lightAreaExtent;
+    const auto color = glm::vec3{rng(lightSeed), rng(lightSeed), rng(lightSeed)};
+    lights.push_back(Light{
+      .position = glm::vec4(position, 0),
+      .intensity = color * lightIntensity,
+      .invRadius = 1.0f / lightRadius,
+    });
+  }
+
+  lightBuffer.emplace(lights);
+}
+
+void GltfViewerApplication::StartLightBenchmark()
+{
+  // Shading every light for every pixel takes seconds per frame with tens of thousands of lights
+  constexpr uint32_t maxUnculledLights = 4096;
+
+  lightBenchmark.emplace();
+  lightBenchmark->originalSettings = {lightCount, lightCullingMode, lightRadius};
+  for (uint32_t count = 16; count <= 65536; count *= 2)
+  {
+    // Keep the total volume of the lights constant, so every step lights each pixel with about as many lights as the
+    // current settings do. With a fixed radius, the light lists of dense steps would be truncated and the culling modes
+    // would skip work that the unculled mode does
+    const auto radius = lightRadius * std::cbrt(static_cast<float>(lightCount) / count);
+    lightBenchmark->steps.push_back({count, LightCullingMode::CLUSTERED, radius});
+    lightBenchmark->steps.push_back({count, LightCullingMode::TILED, radius});
+    if (count <= maxUnculledLights)
+    {
+      lightBenchmark->steps.push_back({count, LightCullingMode::NONE, radius});
+    }
+  }
+
+  lightBenchmarkResults.clear();
+}
+
+void GltfViewerApplication::UpdateLightBenchmark()
+{
+  // Timer queries are read a few frames late, so the first frames of each step measure the previous one
+  constexpr uint32_t warmupFrames = 10;
+  constexpr uint32_t measuredFrames = 60;
+
+  if (!lightBenchmark)
+  {
+    return;
+  }
+
+  auto& benchmark = *lightBenchmark;
+  if (benchmark.frame == 0)
+  {
+    const auto& step = benchmark.steps[benchmark.stepIndex];
+    lightCount = step.lightCount;
+    lightCullingMode = step.cullingMode;
+    lightRadius = step.lightRadius;
+    CreateLights();
+  }
+  else if (benchmark.frame > warmupFrames)
+  {
+    benchmark.lightCullingTimeSum += lightCullingTime;
+    benchmark.shadingTimeSum += shadingTime;
+    benchmark.droppedLights = std::max(benchmark.droppedLights, GetDroppedLightCount());
+  }
+
+  if (++benchmark.frame <= warmupFrames + measuredFrames)
+  {
+    return;
+  }
+
+  lightBenchmarkResults.push_back({
+    .step = benchmark.steps[benchmark.stepIndex],
+    .lightCullingTime = benchmark.lightCullingTimeSum / measuredFrames,
+    .shadingTime = benchmark.shadingTimeSum / measuredFrames,
+    .droppedLights = benchmark.droppedLights,
+  });
+
+  benchmark.stepIndex++;
+  benchmark.frame = 0;
+  benchmark.lightCullingTimeSum = 0;
+  benchmark.shadingTimeSum = 0;
+  benchmark.droppedLights = 0;
+
+  if (benchmark.stepIndex == benchmark.steps.size())
+  {
+    lightCount = benchmark.originalSettings.lightCount;
+    lightCullingMode = benchmark.originalSettings.cullingMode;
+    lightRadius = benchmark.originalSettings.lightRadius;
+    CreateLights();
+    lightBenchmark.reset();
+  }
+}
+
+uint32_t GltfViewerApplication::GetDroppedLightCount() const
+{
+  switch (lightCullingMode)
+  {
+  case LightCullingMode::CLUSTERED: return clusteredLighting->GetStats().droppedLights;
+  case LightCullingMode::TILED: return tiledShading->GetStats().droppedLights;
+  default: return 0;
+  }
+}
+
 void GltfViewerApplication::OnWindowResize(uint32_t newWidth, uint32_t newHeight)
 {
 #ifdef FWOG_FSR2_ENABLE
@@ -471,6 +650,9 @@ void GltfViewerApplication::OnWindowResize(uint32_t newWidth, uint32_t newHeight
     frame.rsm->SetResolution(renderWidth, renderHeight);
   }
 
+  clusteredLighting->SetResolution(renderWidth, renderHeight);
+  tiledShading->SetResolution(renderWidth, renderHeight);
+
   // create debug views
   frame.gAlbedoSwizzled = frame.gAlbedo->CreateSwizzleView({.a = Fwog::ComponentSwizzle::ONE});
   frame.gNormalSwizzled = frame.gNormal->CreateSwizzleView({.a = Fwog::ComponentSwizzle::ONE});
@@ -507,12 +689,15 @@ static glm::vec2 GetJitterOffset(uint32_t frameIndex, uint32_t renderWidth, uint
 
 void GltfViewerApplication::OnRender([[maybe_unused]] double dt)
 {
+  UpdateLightBenchmark();
+
   std::swap(frame.gDepth, frame.gDepthPrev);
   std::swap(frame.gNormal, frame.gNormalPrev);
 
   shadingUniforms.sunDir = glm::normalize(glm::rotate(sunPosition, glm::vec3{1, 0, 0}) *
                                           glm::rotate(sunPosition2, glm::vec3(0, 1, 0)) * glm::vec4{-.1, -.3, -.6, 0});
   shadingUniforms.sunStrength = glm::vec4{sunStrength * sunColor, 0};
+  shadingUniforms.useClusteredLighting = lightCullingMode == LightCullingMode::CLUSTERED;
 
 #ifdef FWOG_FSR2_ENABLE
   const float fsr2LodBias = fsr2Enable ? log2(float(renderWidth) / float(windowWidth)) - 1.0 : 0;
@@ -563,6 +748,15 @@ void GltfViewerApplication::OnRender([[maybe_unused]] double dt)
   shadingUniforms.sunViewProj = shadingUniforms.sunProj * shadingUniforms.sunView;
   shadingUniformsBuffer.UpdateData(shadingUniforms);
 
+  uploadRing->BeginFrame();
+
+  std::vector<Fwog::UploadRingAllocation> materialAllocations;
+  materialAllocations.reserve(scene.materials.size());
+  for (const auto& material : scene.materials)
+  {
+    materialAllocations.push_back(uploadRing->AllocateUniform(material.gpuMaterial));
+  }
+
   // Render scene geometry to the g-buffer
   {
     Fwog::RenderColorAttachment gAlbedoAttachment{
@@ -598,14 +792,14 @@ void GltfViewerApplication::OnRender([[maybe_unused]] double dt)
     });
     Fwog::Cmd::BindGraphicsPipeline(scenePipeline);
     Fwog::Cmd::BindUniformBuffer(0, globalUniformsBuffer);
-    Fwog::Cmd::BindUniformBuffer(2, materialUniformsBuffer);
 
     Fwog::Cmd::BindStorageBuffer(1, *meshUniformBuffer);
     for (uint32_t i = 0; i < static_cast<uint32_t>(scene.meshes.size()); i++)
     {
       const auto& mesh = scene.meshes[i];
       const auto& material = scene.materials[mesh.materialIdx];
-      materialUniformsBuffer.UpdateData(material.gpuMaterial);
+      const auto& materialAllocation = materialAllocations[mesh.materialIdx];
+      Fwog::Cmd::BindUniformBuffer(2, materialAllocation.GetBuffer(), materialAllocation.offset, materialAllocation.size);
       if (material.gpuMaterial.flags & Utility::MaterialFlagBit::HAS_BASE_COLOR_TEXTURE)
       {
         const auto& textureSampler = material.albedoTextureSampler.value();
@@ -613,9 +807,15 @@ void GltfViewerApplication::OnRender([[maybe_unused]] double dt)
         sampler.lodBias = fsr2LodBias; 
         Fwog::Cmd::BindSampledImage(0, textureSampler.texture, Fwog::Sampler(sampler));
       }
-      Fwog::Cmd::BindVertexBuffer(0, mesh.vertexBuffer, 0, sizeof(Utility::Vertex));
-      Fwog::Cmd::BindIndexBuffer(mesh.indexBuffer, Fwog::IndexType::UNSIGNED_INT);
-      Fwog::Cmd::DrawIndexed(static_cast<uint32_t>(mesh.indexBuffer.Size()) / sizeof(uint32_t), 1, 0, 0, i);
+      const auto& vertices = mesh.vertexAllocation;
+      const auto& indices = mesh.indexAllocation;
+      Fwog::Cmd::BindVertexBuffer(0, *vertices.buffer, vertices.offset, sizeof(Utility::Vertex));
+      Fwog::Cmd::BindIndexBuffer(*indices.buffer, Fwog::IndexType::UNSIGNED_INT);
+      Fwog::Cmd::DrawIndexed(static_cast<uint32_t>(indices.size / sizeof(Utility::index_t)),
+                             1,
+                             static_cast<uint32_t>(indices.offset / sizeof(Utility::index_t)),
+                             0,
+                             i);
     }
   }
   Fwog::EndRendering();
@@ -647,22 +847,28 @@ void GltfViewerApplication::OnRender([[maybe_unused]] double dt)
     Fwog::Cmd::BindGraphicsPipeline(rsmScenePipeline);
     Fwog::Cmd::BindUniformBuffer(0, rsmUniforms);
     Fwog::Cmd::BindUniformBuffer(1, shadingUniformsBuffer);
-    Fwog::Cmd::BindUniformBuffer(2, materialUniformsBuffer);
 
     Fwog::Cmd::BindStorageBuffer(1, *meshUniformBuffer, 0);
     for (uint32_t i = 0; i < static_cast<uint32_t>(scene.meshes.size()); i++)
     {
       const auto& mesh = scene.meshes[i];
       const auto& material = scene.materials[mesh.materialIdx];
-      materialUniformsBuffer.UpdateData(material.gpuMaterial);
+      const auto& materialAllocation = materialAllocations[mesh.materialIdx];
+      Fwog::Cmd::BindUniformBuffer(2, materialAllocation.GetBuffer(), materialAllocation.offset, materialAllocation.size);
       if (material.gpuMaterial.flags & Utility::MaterialFlagBit::HAS_BASE_COLOR_TEXTURE)
       {
         const auto& textureSampler = material.albedoTextureSampler.value();
         Fwog::Cmd::BindSampledImage(0, textureSampler.texture, Fwog::Sampler(textureSampler.sampler));
       }
-      Fwog::Cmd::BindVertexBuffer(0, mesh.vertexBuffer, 0, sizeof(Utility::Vertex));
-      Fwog::Cmd::BindIndexBuffer(mesh.indexBuffer, Fwog::IndexType::UNSIGNED_INT);
-      Fwog::Cmd::DrawIndexed(static_cast<uint32_t>(mesh.indexBuffer.Size()) / sizeof(uint32_t), 1, 0, 0, i);
+      const auto& vertices = mesh.vertexAllocation;
+      const auto& indices = mesh.indexAllocation;
+      Fwog::Cmd::BindVertexBuffer(0, *vertices.buffer, vertices.offset, sizeof(Utility::Vertex));
+      Fwog::Cmd::BindIndexBuffer(*indices.buffer, Fwog::IndexType::UNSIGNED_INT);
+      Fwog::Cmd::DrawIndexed(static_cast<uint32_t>(indices.size / sizeof(Utility::index_t)),
+                             1,
+                             static_cast<uint32_t>(indices.offset / sizeof(Utility::index_t)),
+                             0,
+                             i);
     }
   }
   Fwog::EndRendering();
@@ -698,29 +904,49 @@ void GltfViewerApplication::OnRender([[maybe_unused]] double dt)
                                        frame.gMotion.value());
   }
 
-  // clear cluster indices atomic counter
-  // clusterIndicesBuffer.ClearSubData(0, sizeof(uint32_t), Fwog::Format::R32_UINT, Fwog::UploadFormat::R, Fwog::UploadType::UINT, &zero);
-
-  // record active clusters
-  // TODO
-
-  // light culling+cluster assignment
-
-  //
+  // Assign point lights to clusters or tiles
+  if (lightCullingMode != LightCullingMode::NONE)
+  {
+    static Fwog::TimerQueryAsync timer(5);
+    if (auto t = timer.PopTimestamp())
+    {
+      lightCullingTime = *t / 10e5;
+    }
+    Fwog::TimerScoped scopedTimer(timer);
+    if (lightCullingMode == LightCullingMode::CLUSTERED)
+    {
+      clusteredLighting->CullLights(mainCamera.GetViewMatrix(),
+                                    projJittered,
+                                    cameraNear,
+                                    cameraFar,
+                                    frame.gDepth.value(),
+                                    *lightBuffer,
+                                    lightCount);
+    }
+    else
+    {
+      tiledShading->ClassifyTiles(mainCamera.GetViewMatrix(),
+                                  projJittered,
+                                  shadingUniforms.sunDir,
+                                  frame.gNormal.value(),
+                                  frame.gDepth.value(),
+                                  *lightBuffer,
+                                  lightCount);
+    }
+  }
+  else
+  {
+    lightCullingTime = 0;
+  }
 
-  // shading pass (full screen tri)
+  static Fwog::TimerQueryAsync shadingTimer(5);
+  if (auto t = shadingTimer.PopTimestamp())
+  {
+    shadingTime = *t / 10e5;
+  }
 
-  Fwog::RenderColorAttachment shadingColorAttachment{
-    .texture = &frame.colorHdrRenderRes.value(),
-    .loadOp = Fwog::AttachmentLoadOp::CLEAR,
-    .clearValue = {.1f, .3f, .5f, 0.0f},
-  };
-  Fwog::BeginRendering({
-    .name = "Shading",
-    .colorAttachments = {&shadingColorAttachment, 1},
-  });
+  auto bindShadingResources = [&]
   {
-    Fwog::Cmd::BindGraphicsPipeline(shadingPipeline);
     Fwog::Cmd::BindSampledImage(0, *frame.gAlbedo, nearestSampler);
     Fwog::Cmd::BindSampledImage(1, *frame.gNormal, nearestSampler);
     Fwog::Cmd::BindSampledImage(2, *frame.gDepth, nearestSampler);
@@ -730,10 +956,40 @@ void GltfViewerApplication::OnRender([[maybe_unused]] double dt)
     Fwog::Cmd::BindUniformBuffer(0, globalUniformsBuffer);
     Fwog::Cmd::BindUniformBuffer(1, shadingUniformsBuffer);
     Fwog::Cmd::BindUniformBuffer(2, shadowUniformsBuffer);
-    Fwog::Cmd::BindStorageBuffer(0, *lightBuffer);
-    Fwog::Cmd::Draw(3, 1, 0, 0);
+  };
+
+  if (lightCullingMode == LightCullingMode::TILED)
+  {
+    // shading pass (compute, one dispatch per tile class)
+    Fwog::BeginCompute("Shading");
+    {
+      Fwog::TimerScoped scopedTimer(shadingTimer);
+      bindShadingResources();
+      tiledShading->ShadeTiles(frame.colorHdrRenderRes.value(), *lightBuffer, {.1f, .3f, .5f});
+    }
+    Fwog::EndCompute();
+  }
+  else
+  {
+    // shading pass (full screen tri)
+    Fwog::RenderColorAttachment shadingColorAttachment{
+      .texture = &frame.colorHdrRenderRes.value(),
+      .loadOp = Fwog::AttachmentLoadOp::CLEAR,
+      .clearValue = {.1f, .3f, .5f, 0.0f},
+    };
+    Fwog::BeginRendering({
+      .name = "Shading",
+      .colorAttachments = {&shadingColorAttachment, 1},
+    });
+    {
+      Fwog::TimerScoped scopedTimer(shadingTimer);
+      Fwog::Cmd::BindGraphicsPipeline(shadingPipeline);
+      bindShadingResources();
+      clusteredLighting->BindForShading(*lightBuffer);
+      Fwog::Cmd::Draw(3, 1, 0, 0);
+    }
+    Fwog::EndRendering();
   }
-  Fwog::EndRendering();
 
 #ifdef FWOG_FSR2_ENABLE
   if (fsr2Enable)
@@ -830,6 +1086,8 @@ void GltfViewerApplication::OnRender([[maybe_unused]] double dt)
     }
   }
   Fwog::EndRendering();
+
+  uploadRing->EndFrame();
 }
 
 void GltfViewerApplication::OnGui([[maybe_unused]] double dt)
@@ -919,6 +1177,108 @@ void GltfViewerApplication::OnGui([[maybe_unused]] double dt)
     ImGui::SliderFloat("Light Spread", &shadowUniforms.sourceAngleRad, 0.001f, 0.3f);
   }
 
+  ImGui::Separator();
+
+  ImGui::Text("Geometry");
+  if (scene.geometryHeap)
+  {
+    const auto heapStats = scene.geometryHeap->GetStats();
+    ImGui::Text("%u allocations in %u blocks", heapStats.allocationCount, heapStats.blockCount);
+    ImGui::Text("Used: %.1f / %.1f MiB", heapStats.usedBytes / 1048576.0, heapStats.totalBytes / 1048576.0);
+    ImGui::Text("Fragmentation: %.2f", heapStats.fragmentation);
+    if (ImGui::Button("Defragment Geometry"))
+    {
+      geometryMoveCount = Utility::DefragmentGeometry(scene);
+    }
+    ImGui::SameLine();
+    ImGui::Text("Moved %zu allocations", geometryMoveCount);
+  }
+
+  ImGui::Separator();
+
+  ImGui::Text("Point Lights");
+  ImGui::Text("Light Culling: %f ms", lightCullingTime);
+  ImGui::Text("Shading: %f ms", shadingTime);
+  if (lightCullingMode == LightCullingMode::CLUSTERED)
+  {
+    const auto& clusterStats = clusteredLighting->GetStats();
+    ImGui::Text("Visible Clusters: %u / %u", clusterStats.visibleClusters, Clustered::ClusteredLighting::clusterCount);
+    ImGui::Text("Light Indices: %u", clusterStats.lightIndices);
+    ImGui::Text("Dropped Lights: %u", clusterStats.droppedLights);
+  }
+  else if (lightCullingMode == LightCullingMode::TILED)
+  {
+    const auto& tileStats = tiledShading->GetStats().tilesPerClass;
+    ImGui::Text("Tiles: %u", tiledShading->GetTileCount());
+    ImGui::Text("Ambient Only: %u", tileStats[0]);
+    ImGui::Text("Sun: %u", tileStats[Tiled::TileClass::SUN_LIT]);
+    ImGui::Text("Local Lights: %u", tileStats[Tiled::TileClass::LOCAL_LIGHTS]);
+    ImGui::Text("Sun + Local Lights: %u", tileStats[Tiled::TileClass::SUN_LIT | Tiled::TileClass::LOCAL_LIGHTS]);
+    ImGui::Text("Dropped Lights: %u", tiledShading->GetStats().droppedLights);
+  }
+
+  ImGui::BeginDisabled(lightBenchmark.has_value());
+  int cullingMode = static_cast<int>(lightCullingMode);
+  ImGui::RadioButton("No Culling", &cullingMode, static_cast<int>(LightCullingMode::NONE));
+  ImGui::SameLine();
+  ImGui::RadioButton("Clustered", &cullingMode, static_cast<int>(LightCullingMode::CLUSTERED));
+  ImGui::SameLine();
+  ImGui::RadioButton("Tiled", &cullingMode, static_cast<int>(LightCullingMode::TILED));
+  lightCullingMode = static_cast<LightCullingMode>(cullingMode);
+  int lightCountLog2 = std::bit_width(lightCount) - 1;
+  if (ImGui::SliderInt("Light Count", &lightCountLog2, 4, 16, std::to_string(1u << lightCountLog2).c_str()))
+  {
+    lightCount = 1u << lightCountLog2;
+    CreateLights();
+  }
+  bool lightsChanged = false;
+  lightsChanged |= ImGui::SliderFloat("Light Radius", &lightRadius, 0.1f, 5.0f);
+  lightsChanged |= ImGui::SliderFloat("Light Intensity", &lightIntensity, 0.0f, 10.0f);
+  lightsChanged |= ImGui::SliderFloat3("Light Area", &lightAreaExtent[0], 0.5f, 20.0f);
+  if (lightsChanged)
+  {
+    CreateLights();
+  }
+  if (ImGui::Button("Run Light Benchmark"))
+  {
+    StartLightBenchmark();
+  }
+  ImGui::EndDisabled();
+
+  if (lightBenchmark)
+  {
+    ImGui::Text("Benchmarking: step %zu / %zu", lightBenchmark->stepIndex + 1, lightBenchmark->steps.size());
+  }
+
+  constexpr const char* cullingModeNames[] = {"None", "Clustered", "Tiled"};
+  if (!lightBenchmarkResults.empty() && ImGui::BeginTable("Light Benchmark", 6, ImGuiTableFlags_Borders))
+  {
+    ImGui::TableSetupColumn("Lights");
+    ImGui::TableSetupColumn("Radius");
+    ImGui::TableSetupColumn("Mode");
+    ImGui::TableSetupColumn("Culling (ms)");
+    ImGui::TableSetupColumn("Shading (ms)");
+    ImGui::TableSetupColumn("Dropped");
+    ImGui::TableHeadersRow();
+    for (const auto& result : lightBenchmarkResults)
+    {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::Text("%u", result.step.lightCount);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", result.step.lightRadius);
+      ImGui::TableNextColumn();
+      ImGui::Text("%s", cullingModeNames[static_cast<int>(result.step.cullingMode)]);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", result.lightCullingTime);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", result.shadingTime);
+      ImGui::TableNextColumn();
+      ImGui::Text("%u", result.droppedLights);
+    }
+    ImGui::EndTable();
+  }
+
   ImGui::BeginTabBar("tabbed");
   if (ImGui::BeginTabItem("G-Buffers"))
   {
@@ -1019,6 +1379,26 @@ int main(int argc, const char* const* argv)
         throw std::runtime_error("Binary should be 0 or 1");
       }
     }
+    if (argc > 4)
+    {
+      const auto quality = std::string_view(argv[4]);
+      if (quality == "fast")
+      {
+        Utility::SetImageCompression(Utility::BcQuality::FAST);
+      }
+      else if (quality == "normal")
+      {
+        Utility::SetImageCompression(Utility::BcQuality::NORMAL);
+      }
+      else if (quality == "high")
+      {
+        Utility::SetImageCompression(Utility::BcQuality::HIGH);
+      }
+      else if (quality != "none")
+      {
+        throw std::runtime_error("Compress should be none, fast, normal, or high");
+      }
+    }
   }
   catch (std::exception& e)
   {
@@ -668,9 +668,15 @@ void VolumetricApplication::OnRender([[maybe_unused]] double dt)
         const auto& textureSampler = material.albedoTextureSampler.value();
         Fwog::Cmd::BindSampledImage(0, textureSampler.texture, Fwog::Sampler(textureSampler.sampler));
       }
-      Fwog::Cmd::BindVertexBuffer(0, mesh.vertexBuffer, 0, sizeof(Utility::Vertex));
-      Fwog::Cmd::BindIndexBuffer(mesh.indexBuffer, Fwog::IndexType::UNSIGNED_INT);
-      Fwog::Cmd::DrawIndexed(static_cast<uint32_t>(mesh.indexBuffer.Size()) / sizeof(uint32_t), 1, 0, 0, i);
+      const auto& vertices = mesh.vertexAllocation;
+      const auto& indices = mesh.indexAllocation;
+      Fwog::Cmd::BindVertexBuffer(0, *vertices.buffer, vertices.offset, sizeof(Utility::Vertex));
+      Fwog::Cmd::BindIndexBuffer(*indices.buffer, Fwog::IndexType::UNSIGNED_INT);
+      Fwog::Cmd::DrawIndexed(static_cast<uint32_t>(indices.size / sizeof(Utility::index_t)),
+                             1,
+                             static_cast<uint32_t>(indices.offset / sizeof(Utility::index_t)),
+                             0,
+                             i);
     }
     Fwog::EndRendering();
   }
@@ -704,9 +710,15 @@ void VolumetricApplication::OnRender([[maybe_unused]] double dt)
     for (uint32_t i = 0; i < static_cast<uint32_t>(scene.meshes.size()); i++)
     {
       const auto& mesh = scene.meshes[i];
-      Fwog::Cmd::BindVertexBuffer(0, mesh.vertexBuffer, 0, sizeof(Utility::Vertex));
-      Fwog::Cmd::BindIndexBuffer(mesh.indexBuffer, Fwog::IndexType::UNSIGNED_INT);
-      Fwog::Cmd::DrawIndexed(static_cast<uint32_t>(mesh.indexBuffer.Size()) / sizeof(uint32_t), 1, 0, 0, i);
+      const auto& vertices = mesh.vertexAllocation;
+      const auto& indices = mesh.indexAllocation;
+      Fwog::Cmd::BindVertexBuffer(0, *vertices.buffer, vertices.offset, sizeof(Utility::Vertex));
+      Fwog::Cmd::BindIndexBuffer(*indices.buffer, Fwog::IndexType::UNSIGNED_INT);
+      Fwog::Cmd::DrawIndexed(static_cast<uint32_t>(indices.size / sizeof(Utility::index_t)),
+                             1,
+                             static_cast<uint32_t>(indices.offset / sizeof(Utility::index_t)),
+                             0,
+                             i);
     }
     Fwog::EndRendering();
   }
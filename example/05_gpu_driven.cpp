@@ -1,7 +1,10 @@
 #include "common/Application.h"
+#include "common/HiZCulling.h"
 #include "common/SceneLoader.h"
 
 #include <Fwog/Buffer.h>
+#include <Fwog/Context.h>
+#include <Fwog/MemoryUsage.h>
 #include <Fwog/Pipeline.h>
 #include <Fwog/Rendering.h>
 #include <Fwog/Shader.h>
@@ -20,20 +23,28 @@
 #define STB_INCLUDE_LINE_GLSL
 #include <stb_include.h>
 
+#include <algorithm>
 #include <array>
 #include <charconv>
 #include <exception>
 #include <iostream>
+#include <ranges>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
 /* 05_gpu_driven
  *
- * A basic GPU-driven renderer. Occlusion culling is performed by rendering object bounding boxes with early fragment
- * tests enabled. If any fragments are drawn, then the object is potentially visible and is marked to be rendered.
- * Then, the entire scene is drawn in a single draw call using DrawIndexedIndirect and bindless textures (taking
- * care not to invoke undefined behavior).
+ * A basic GPU-driven renderer. Objects are culled on the GPU by Culling::HiZCuller, which tests their bounding boxes
+ * against the view frustum and a hierarchical depth buffer (Hi-Z), and compacts the draw commands of visible objects
+ * into persistent Fwog::IndirectDrawLists. Culling happens in two phases: objects that were visible last frame are
+ * drawn first, then a Hi-Z pyramid is built from their depth and used to find (and draw) objects that have just become
+ * visible. This avoids the one-frame lag that testing against the previous frame's depth would have.
+ *
+ * Each phase draws the scene in a single draw call using DrawIndexedIndirectCount and bindless textures (taking
+ * care not to invoke undefined behavior). Drivers without bindless textures sample texture arrays instead, which
+ * Utility::PackTextureArrays creates from the materials' textures. No buffers are allocated or uploaded after startup,
+ * aside from the per-frame uniforms.
  *
  * The app has the same options as 03_gltf_viewer.
  *
@@ -53,11 +64,10 @@
  * - Dynamic uniform buffers
  * - Memory barriers
  * + Indirect drawing
+ * + Indirect draw count
+ * + Compute shaders
  * + Bindless textures
- *
- * TODO: frustum culling
- * TODO: hi-z occlusion culling
- * TODO: disocclusion fixup pass
+ * + Texture arrays
  */
 
 struct alignas(16) ObjectUniforms
@@ -118,12 +128,24 @@ constexpr std::array<Fwog::VertexInputBindingDescription, 3> sceneInputBindingDe
   },
 };
 
-Fwog::GraphicsPipeline CreateScenePipeline()
+// textureArrayCount is the size of the array of texture arrays that are bound when bindless textures are unsupported
+Fwog::GraphicsPipeline CreateScenePipeline(uint32_t textureArrayCount)
 {
   auto vs = Fwog::Shader(Fwog::PipelineStage::VERTEX_SHADER,
                          LoadFileWithInclude("shaders/gpu_driven/SceneForward.vert.glsl", "shaders/gpu_driven"));
-  auto fs = Fwog::Shader(Fwog::PipelineStage::FRAGMENT_SHADER,
-                         LoadFileWithInclude("shaders/gpu_driven/SceneForward.frag.glsl", "shaders/gpu_driven"));
+
+  // Without bindless textures, materials reference a layer of a texture array instead
+  std::string fsSource;
+  if (Fwog::GetDeviceProperties().features.bindlessTextures)
+  {
+    fsSource = LoadFileWithInclude("shaders/gpu_driven/SceneForward.frag.glsl", "shaders/gpu_driven");
+  }
+  else
+  {
+    fsSource = LoadFileWithInclude("shaders/gpu_driven/SceneForwardArrays.frag.glsl", "shaders/gpu_driven");
+    fsSource.insert(fsSource.find('\n') + 1, "#define MAX_TEXTURE_ARRAYS " + std::to_string(textureArrayCount) + "\n");
+  }
+  auto fs = Fwog::Shader(Fwog::PipelineStage::FRAGMENT_SHADER, fsSource);
 
   return Fwog::GraphicsPipeline({
     .name = "Generic material",
@@ -151,23 +173,6 @@ Fwog::GraphicsPipeline CreateBoundingBoxDebugPipeline()
   });
 }
 
-Fwog::GraphicsPipeline CreateBoundingBoxCullingPipeline()
-{
-  auto vs = Fwog::Shader(Fwog::PipelineStage::VERTEX_SHADER,
-                         LoadFileWithInclude("shaders/gpu_driven/BoundingBox.vert.glsl", "shaders/gpu_driven"));
-  auto fs = Fwog::Shader(Fwog::PipelineStage::FRAGMENT_SHADER,
-                         LoadFileWithInclude("shaders/gpu_driven/CullVisibility.frag.glsl", "shaders/gpu_driven"));
-
-  return Fwog::GraphicsPipeline({
-    .name = "Culling bounding boxes",
-    .vertexShader = &vs,
-    .fragmentShader = &fs,
-    .inputAssemblyState = {.topology = Fwog::PrimitiveTopology::TRIANGLE_STRIP},
-    .rasterizationState = {.polygonMode = Fwog::PolygonMode::FILL, .cullMode = Fwog::CullMode::NONE},
-    .depthState = {.depthTestEnable = true, .depthWriteEnable = false, .depthCompareOp = Fwog::CompareOp::LESS},
-  });
-}
-
 class GpuDrivenApplication final : public Application
 {
 public:
@@ -199,22 +204,20 @@ private:
   };
   Frame frame{};
 
-  Fwog::GraphicsPipeline scenePipeline;
+  std::optional<Fwog::GraphicsPipeline> scenePipeline; // Created once the number of texture arrays is known
   Fwog::GraphicsPipeline boundingBoxDebugPipeline;
-  Fwog::GraphicsPipeline boundingBoxCullingPipeline;
 
   Fwog::TypedBuffer<GlobalUniforms> globalUniformsBuffer;
 
   // Scene
   Utility::SceneBindless scene;
-  std::vector<Fwog::DrawIndexedIndirectCommand> drawCommands;
-  std::optional<Fwog::TypedBuffer<Fwog::DrawIndexedIndirectCommand>> drawCommandsBuffer;
+  std::optional<Culling::HiZCuller> culler;
   std::optional<Fwog::TypedBuffer<Utility::Vertex>> vertexBuffer;
   std::optional<Fwog::TypedBuffer<Utility::index_t>> indexBuffer;
   std::optional<Fwog::TypedBuffer<ObjectUniforms>> meshUniformBuffer;
   std::optional<Fwog::TypedBuffer<BoundingBox>> boundingBoxesBuffer;
-  std::optional<Fwog::Buffer> objectIndicesBuffer; // Unused
   std::optional<Fwog::TypedBuffer<Utility::GpuMaterialBindless>> materialsBuffer;
+  std::vector<Fwog::Sampler> textureArraySamplers; // Parallel to scene.textureArrays
 };
 
 GpuDrivenApplication::GpuDrivenApplication(const Application::CreateInfo& createInfo,
@@ -222,11 +225,12 @@ GpuDrivenApplication::GpuDrivenApplication(const Application::CreateInfo& create
                                            float scale,
                                            bool binary)
   : Application(createInfo),
-    scenePipeline(CreateScenePipeline()),
     boundingBoxDebugPipeline(CreateBoundingBoxDebugPipeline()),
-    boundingBoxCullingPipeline(CreateBoundingBoxCullingPipeline()),
     globalUniformsBuffer(Fwog::BufferStorageFlag::DYNAMIC_STORAGE)
 {
+  // The g-buffer is recreated when the window is resized, possibly while the GPU is still using it
+  Fwog::SetDeferredDestructionEnabled(true);
+
   bool success = false;
 
   if (!filename)
@@ -243,39 +247,58 @@ GpuDrivenApplication::GpuDrivenApplication(const Application::CreateInfo& create
     throw std::runtime_error("Failed to load scene");
   }
 
+  // Texture arrays are split by sampler, format, and size, so a scene can need more of them than there are texture
+  // units. Materials that use the arrays that can't be bound fall back to their base color factor
+  const auto maxTextureArrays = static_cast<uint32_t>(Fwog::GetDeviceProperties().limits.maxTextureImageUnits);
+  if (scene.textureArrays.size() > maxTextureArrays)
+  {
+    uint32_t untexturedCount = 0;
+    for (auto& material : scene.materials)
+    {
+      if ((material.flags & Utility::MaterialFlagBit::HAS_BASE_COLOR_TEXTURE) &&
+          material.baseColorTextureIndex >= maxTextureArrays)
+      {
+        material.flags &= ~Utility::MaterialFlagBit::HAS_BASE_COLOR_TEXTURE;
+        material.baseColorTextureIndex = 0;
+        untexturedCount++;
+      }
+    }
+
+    std::cout << "The scene's textures need " << scene.textureArrays.size() << " texture arrays, but only "
+              << maxTextureArrays << " can be bound. " << untexturedCount << " materials are drawn without a texture\n";
+    scene.textureArrays.erase(scene.textureArrays.begin() + maxTextureArrays, scene.textureArrays.end());
+    scene.textureArraySamplers.erase(scene.textureArraySamplers.begin() + maxTextureArrays,
+                                     scene.textureArraySamplers.end());
+  }
+
+  // GLSL arrays can't be empty
+  scenePipeline = CreateScenePipeline(std::max(static_cast<uint32_t>(scene.textureArrays.size()), 1u));
+
+  for (const auto& samplerState : scene.textureArraySamplers)
+  {
+    textureArraySamplers.emplace_back(samplerState);
+  }
+
   std::vector<ObjectUniforms> meshUniforms;
   std::vector<BoundingBox> boundingBoxes;
-  std::vector<uint32_t> objectIndices = {static_cast<uint32_t>(scene.meshes.size())};
-
-  int curObjectIndex = 0;
   for (const auto& mesh : scene.meshes)
   {
-    // The mesh uniforms are indexed with gl_DrawID (each mesh gets one set of uniforms).
+    // The mesh uniforms are indexed with the draw's base instance (each mesh gets one set of uniforms).
     meshUniforms.push_back(ObjectUniforms{.model = mesh.transform, .materialIdx = mesh.materialIdx});
-    // Each mesh has a bounding box which is used as its cheap-to-draw proxy volume for occlusion culling.
+    // Each mesh has a bounding box, which is drawn when viewing bounding boxes.
     boundingBoxes.push_back(BoundingBox{
       .offset = mesh.boundingBox.offset,
       .halfExtent = mesh.boundingBox.halfExtent,
     });
-    // Initialize the indirect draw command. Note that the instance count is initialized to 0.
-    // The other draw parameters depend on the mesh's location in the one big vertex buffer.
-    drawCommands.push_back(Fwog::DrawIndexedIndirectCommand{
-      .indexCount = mesh.indexCount,
-      .instanceCount = 0,
-      .firstIndex = mesh.startIndex,
-      .vertexOffset = mesh.startVertex,
-      .firstInstance = 0,
-    });
-    // Currently unused.
-    objectIndices.push_back(curObjectIndex++);
   }
 
-  drawCommandsBuffer = Fwog::TypedBuffer<Fwog::DrawIndexedIndirectCommand>(drawCommands);
-  vertexBuffer = Fwog::TypedBuffer<Utility::Vertex>(scene.vertices);
-  indexBuffer = Fwog::TypedBuffer<Utility::index_t>(scene.indices);
+  // The culler creates an indirect draw command for each mesh from its location in the one big vertex buffer
+  culler.emplace(scene.meshes);
+
+  vertexBuffer = Fwog::TypedBuffer<Utility::Vertex>(scene.vertices, Fwog::BufferStorageFlag::NONE, "Scene vertices");
+  indexBuffer = Fwog::TypedBuffer<Utility::index_t>(scene.indices, Fwog::BufferStorageFlag::NONE, "Scene indices");
   meshUniformBuffer = Fwog::TypedBuffer<ObjectUniforms>(meshUniforms);
   boundingBoxesBuffer = Fwog::TypedBuffer<BoundingBox>(boundingBoxes);
-  objectIndicesBuffer = Fwog::Buffer(std::span(objectIndices));
   materialsBuffer = Fwog::TypedBuffer<Utility::GpuMaterialBindless>(scene.materials);
 
   mainCamera.position = {0, 1.5, 2};
@@ -288,6 +311,7 @@ void GpuDrivenApplication::OnWindowResize(uint32_t newWidth, uint32_t newHeight)
 {
   frame.gAlbedo = Fwog::CreateTexture2D({newWidth, newHeight}, Fwog::Format::R8G8B8A8_SRGB);
   frame.gDepth = Fwog::CreateTexture2D({newWidth, newHeight}, Fwog::Format::D32_FLOAT);
+  culler->SetResolution(newWidth, newHeight);
 }
 
 void GpuDrivenApplication::OnUpdate([[maybe_unused]] double dt) {}
@@ -305,21 +329,27 @@ void GpuDrivenApplication::OnRender([[maybe_unused]] double dt)
   mainCameraUniforms.cameraPos = glm::vec4(mainCamera.position, 0.0);
   globalUniformsBuffer.UpdateData(mainCameraUniforms);
 
+  // Objects are culled on the GPU, so the texture of any material may be sampled
+  scene.textureTable->MarkAllUsed();
+  scene.textureTable->Commit();
+
   Fwog::RenderDepthStencilAttachment gDepthAttachment{
     .texture = &frame.gDepth.value(),
     .loadOp = Fwog::AttachmentLoadOp::CLEAR,
     .clearValue = {.depth = 1.0f},
   };
 
-  // Scene pass. Draw everything that was marked visible in the previous frame's culling pass.
+  Fwog::RenderColorAttachment gColorAttachment{
+    .texture = &frame.gAlbedo.value(),
+    .loadOp = Fwog::AttachmentLoadOp::CLEAR,
+    .clearValue = {.1f, .3f, .5f, 0.0f},
+  };
+
+  // Draws the objects in a draw list produced by the culler
+  auto drawScene = [&](const char* name, const Fwog::IndirectDrawList<Fwog::DrawIndexedIndirectCommand>& drawList)
   {
-    Fwog::RenderColorAttachment gColorAttachment{
-      .texture = &frame.gAlbedo.value(),
-      .loadOp = Fwog::AttachmentLoadOp::CLEAR,
-      .clearValue = {.1f, .3f, .5f, 0.0f},
-    };
     Fwog::BeginRendering({
-      .name = "Scene",
+      .name = name,
       .colorAttachments = std::span(&gColorAttachment, 1),
       .depthAttachment = &gDepthAttachment,
       .stencilAttachment = nullptr,
@@ -331,51 +361,44 @@ void GpuDrivenApplication::OnRender([[maybe_unused]] double dt)
     Fwog::Cmd::BindStorageBuffer(0, meshUniformBuffer.value());
     Fwog::Cmd::BindStorageBuffer(1, materialsBuffer.value());
     Fwog::Cmd::BindStorageBuffer(2, boundingBoxesBuffer.value());
-    Fwog::Cmd::BindStorageBuffer(3, objectIndicesBuffer.value());
+    Fwog::Cmd::BindStorageBuffer(4, scene.textureTable->GetBuffer());
+    for (uint32_t i = 0; i < scene.textureArrays.size(); i++)
+    {
+      Fwog::Cmd::BindSampledImage(i, scene.textureArrays[i].GetSampledTexture(), textureArraySamplers[i]);
+    }
 
-    Fwog::Cmd::BindGraphicsPipeline(scenePipeline);
+    Fwog::Cmd::BindGraphicsPipeline(scenePipeline.value());
     Fwog::Cmd::BindVertexBuffer(0, vertexBuffer.value(), 0, sizeof(Utility::Vertex));
     Fwog::Cmd::BindIndexBuffer(indexBuffer.value(), Fwog::IndexType::UNSIGNED_INT);
-    Fwog::Cmd::DrawIndexedIndirect(drawCommandsBuffer.value(), 0, static_cast<uint32_t>(scene.meshes.size()), 0);
-
-    if (config.viewBoundingBoxes)
-    {
-      Fwog::Cmd::BindGraphicsPipeline(boundingBoxDebugPipeline);
-      Fwog::Cmd::Draw(14, static_cast<uint32_t>(scene.meshes.size()), 0, 0);
-    }
+    drawList.Draw();
+  };
 
-    Fwog::EndRendering();
+  // Early phase. Draw everything that was visible last frame and is still in the frustum.
+  if (!config.freezeCulling)
+  {
+    culler->CullEarly(mainCameraUniforms.viewProj);
   }
+  drawScene("Scene (early)", culler->GetEarlyDrawList());
+  Fwog::EndRendering();
 
-  // Draw culling boxes. If any fragment is visible, objects have their instance count set to 1.
-  // This pass comes after the scene pass because it relies on a depth buffer to have already been created.
-  // That means objects will become visible exactly 1 frame after being disoccluded. This is generally not
-  // noticeable unless at low framerates.
+  // Late phase. Draw everything that was not visible last frame, but is not occluded by what was just drawn.
   if (!config.freezeCulling)
   {
-    gDepthAttachment.loadOp = Fwog::AttachmentLoadOp::LOAD;
-    Fwog::BeginRendering({.name = "Occlusion culling", .depthAttachment = &gDepthAttachment});
-
-    // Re-upload the draw commands buffer to reset the instance counts to 0 for culling.
-    // Ideally, this would be a compute pass where the draw commands are completely regenerated (e.g., with frustum 
-    // culling), or the instance counts are reset to 0.
-    drawCommandsBuffer = Fwog::TypedBuffer<Fwog::DrawIndexedIndirectCommand>(drawCommands);
-
-    Fwog::Cmd::BindUniformBuffer(0, globalUniformsBuffer);
-    Fwog::Cmd::BindStorageBuffer(0, meshUniformBuffer.value());
-    Fwog::Cmd::BindStorageBuffer(1, materialsBuffer.value());
-    Fwog::Cmd::BindStorageBuffer(2, boundingBoxesBuffer.value());
-    Fwog::Cmd::BindStorageBuffer(3, objectIndicesBuffer.value());
-    Fwog::Cmd::BindStorageBuffer(4, drawCommandsBuffer.value());
-
-    // Draw visible bounding boxes.
-    Fwog::Cmd::BindGraphicsPipeline(boundingBoxCullingPipeline);
-    // TODO: upgrade to indirect draw after frustum culling is added.
-    Fwog::Cmd::Draw(24, static_cast<uint32_t>(scene.meshes.size()), 0, 0);
+    culler->BuildHiZ(frame.gDepth.value());
+    culler->CullLate(mainCameraUniforms.viewProj);
+  }
+  gColorAttachment.loadOp = Fwog::AttachmentLoadOp::LOAD;
+  gDepthAttachment.loadOp = Fwog::AttachmentLoadOp::LOAD;
+  drawScene("Scene (late)", culler->GetLateDrawList());
 
-    Fwog::EndRendering();
+  if (config.viewBoundingBoxes)
+  {
+    Fwog::Cmd::BindGraphicsPipeline(boundingBoxDebugPipeline);
+    Fwog::Cmd::Draw(14, static_cast<uint32_t>(scene.meshes.size()), 0, 0);
   }
 
+  Fwog::EndRendering();
+
   Fwog::BlitTextureToSwapchain(frame.gAlbedo.value(),
                                {},
                                {},
@@ -389,7 +412,32 @@ void GpuDrivenApplication::OnGui(double dt)
   ImGui::Begin("Options");
   ImGui::Text("Framerate: %.0f Hertz", 1 / dt);
   ImGui::Checkbox("Freeze culling", &config.freezeCulling);
+  ImGui::Checkbox("Frustum culling", &culler->frustumCulling);
+  ImGui::Checkbox("Occlusion culling", &culler->occlusionCulling);
   ImGui::Checkbox("View bounding boxes", &config.viewBoundingBoxes);
+
+  // Estimated from the parameters of live resources, so this can be compared against a budget on any driver
+  const auto memoryUsage = Fwog::GetMemoryUsage();
+  ImGui::Text("Buffers: %u (%.1f MiB)", memoryUsage.bufferCount, memoryUsage.bufferBytes / 1048576.0);
+  ImGui::Text("Textures: %u (%.1f MiB), %u views",
+              memoryUsage.textureCount,
+              memoryUsage.textureBytes / 1048576.0,
+              memoryUsage.textureViewCount);
+  if (const auto deviceMemory = Fwog::QueryDeviceMemoryInfo())
+  {
+    ImGui::Text("Available video memory: %.0f MiB", deviceMemory->availableBytes / 1048576.0);
+  }
+  if (ImGui::TreeNode("Largest resources"))
+  {
+    for (const auto& resource : memoryUsage.resources | std::views::take(10))
+    {
+      ImGui::Text("%s (%u): %.1f MiB",
+                  resource.name.empty() ? "Unnamed" : resource.name.c_str(),
+                  resource.count,
+                  resource.bytes / 1048576.0);
+    }
+    ImGui::TreePop();
+  }
   ImGui::End();
 }
 
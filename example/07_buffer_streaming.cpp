@@ -0,0 +1,215 @@
+#include "common/Application.h"
+
+#include <Fwog/BasicTypes.h>
+#include <Fwog/Buffer.h>
+#include <Fwog/FrameContext.h>
+#include <Fwog/Pipeline.h>
+#include <Fwog/Rendering.h>
+#include <Fwog/Shader.h>
+#include <Fwog/Timer.h>
+
+#include <imgui.h>
+
+#include <chrono>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+/* 07_buffer_streaming
+ *
+ * This example is a benchmark that streams a large amount of data from the CPU to the GPU every frame through a
+ * persistently mapped buffer. It compares two mapping modes:
+ *
+ * - Coherent (BufferStorageFlag::MAP_MEMORY): writes become visible to the GPU automatically.
+ * - Explicit flush (BufferStorageFlag::MAP_MEMORY | MAP_NON_COHERENT): writes must be flushed with
+ *   Buffer::FlushMappedRange, but the driver is free to place the buffer in cached memory.
+ *
+ * CPU write throughput is measured around the memcpy (plus the flush for the non-coherent mode). GPU read throughput
+ * is measured with a timer query around a compute shader that reads every byte of the streamed region.
+ *
+ * Each frame in flight has its own pair of buffers, managed by a Fwog::FrameContext, so the CPU never waits on the GPU
+ * unless it gets more than framesInFlight frames ahead. The number of times the CPU had to wait is displayed.
+ */
+
+////////////////////////////////////// Globals
+const char* gReadComputeSource = R"(
+#version 460 core
+
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 0) readonly buffer StreamedData { uvec4 data[]; };
+layout(std430, binding = 1) buffer Result { uint checksum; };
+
+void main()
+{
+  uint i = gl_GlobalInvocationID.x;
+  if (i >= data.length())
+  {
+    return;
+  }
+
+  uvec4 v = data[i];
+
+  // Make the result depend on the data so the reads can't be optimized away
+  if ((v.x ^ v.y ^ v.z ^ v.w) == 0xFFFFFFFFu)
+  {
+    atomicAdd(checksum, 1);
+  }
+}
+)";
+
+class BufferStreamingApplication final : public Application
+{
+public:
+  BufferStreamingApplication(const Application::CreateInfo& createInfo);
+
+  void OnRender(double dt) override;
+
+  void OnGui(double dt) override;
+
+private:
+  static constexpr uint32_t framesInFlight = 3;
+
+  // Persistently mapped buffers that are written by the CPU and read by the GPU in a single frame
+  struct StreamingFrame
+  {
+    Fwog::Buffer coherentBuffer;
+    Fwog::Buffer explicitFlushBuffer;
+  };
+
+  void CreateStreamingBuffers();
+
+  int regionSizeMiB = 64;
+  bool useExplicitFlush = false;
+
+  std::vector<std::byte> sourceData;
+  std::optional<Fwog::FrameContext<StreamingFrame, framesInFlight>> frames;
+  Fwog::TypedBuffer<uint32_t> resultBuffer;
+  Fwog::ComputePipeline readPipeline;
+  Fwog::TimerQueryAsync gpuTimer{5};
+
+  // Exponential moving averages, in seconds
+  double cpuWriteTime = 0;
+  double gpuReadTime = 0;
+};
+
+static Fwog::ComputePipeline CreateReadPipeline()
+{
+  auto shader = Fwog::Shader(Fwog::PipelineStage::COMPUTE_SHADER, gReadComputeSource);
+  return Fwog::ComputePipeline({.shader = &shader});
+}
+
+BufferStreamingApplication::BufferStreamingApplication(const Application::CreateInfo& createInfo)
+  : Application(createInfo),
+    resultBuffer(Fwog::BufferStorageFlag::DYNAMIC_STORAGE),
+    readPipeline(CreateReadPipeline())
+{
+  CreateStreamingBuffers();
+}
+
+void BufferStreamingApplication::CreateStreamingBuffers()
+{
+  const auto regionSize = static_cast<size_t>(regionSizeMiB) * 1024 * 1024;
+
+  sourceData.resize(regionSize);
+  for (size_t i = 0; i < sourceData.size(); i++)
+  {
+    sourceData[i] = static_cast<std::byte>(i * 2654435761u >> 24);
+  }
+
+  // Release the old buffers before creating new ones to avoid a spike in memory usage
+  frames.reset();
+  frames.emplace(
+    [regionSize](uint32_t)
+    {
+      return StreamingFrame{
+        .coherentBuffer = Fwog::Buffer(regionSize, Fwog::BufferStorageFlag::MAP_MEMORY),
+        .explicitFlushBuffer =
+          Fwog::Buffer(regionSize, Fwog::BufferStorageFlag::MAP_MEMORY | Fwog::BufferStorageFlag::MAP_NON_COHERENT),
+      };
+    });
+  cpuWriteTime = 0;
+  gpuReadTime = 0;
+}
+
+void BufferStreamingApplication::OnRender([[maybe_unused]] double dt)
+{
+  // Wait until the GPU has finished reading this frame's buffers framesInFlight frames ago
+  if (!frames->BeginFrame())
+  {
+    return;
+  }
+
+  auto& stream = useExplicitFlush ? frames->Current().explicitFlushBuffer : frames->Current().coherentBuffer;
+
+  const auto cpuStart = std::chrono::steady_clock::now();
+  std::memcpy(stream.GetMappedPointer(), sourceData.data(), stream.Size());
+  stream.FlushMappedRange();
+  const auto cpuEnd = std::chrono::steady_clock::now();
+  cpuWriteTime = 0.9 * cpuWriteTime + 0.1 * std::chrono::duration<double>(cpuEnd - cpuStart).count();
+
+  if (auto t = gpuTimer.PopTimestamp())
+  {
+    gpuReadTime = 0.9 * gpuReadTime + 0.1 * (*t / 1e9);
+  }
+
+  Fwog::BeginCompute("Read Streamed Data");
+  {
+    Fwog::TimerScoped scopedTimer(gpuTimer);
+    Fwog::Cmd::BindComputePipeline(readPipeline);
+    Fwog::Cmd::BindStorageBuffer(0, stream);
+    Fwog::Cmd::BindStorageBuffer(1, resultBuffer);
+    Fwog::Cmd::DispatchInvocations(static_cast<uint32_t>(stream.Size() / 16), 1, 1);
+  }
+  Fwog::EndCompute();
+
+  frames->EndFrame();
+
+  Fwog::BeginSwapchainRendering(Fwog::SwapchainRenderInfo{
+    .viewport = Fwog::Viewport{.drawRect{.offset = {0, 0}, .extent = {windowWidth, windowHeight}}},
+    .colorLoadOp = Fwog::AttachmentLoadOp::CLEAR,
+    .clearColorValue = {.1f, .1f, .1f, 1.0f},
+  });
+  Fwog::EndRendering();
+}
+
+void BufferStreamingApplication::OnGui(double dt)
+{
+  constexpr double bytesPerGiB = 1024.0 * 1024.0 * 1024.0;
+  const double regionBytes = static_cast<double>(regionSizeMiB) * 1024.0 * 1024.0;
+
+  ImGui::Begin("Buffer Streaming");
+  ImGui::Text("Framerate: %.0f Hertz", 1 / dt);
+  ImGui::Text("CPU write: %.3f ms (%.2f GiB/s)", cpuWriteTime * 1000, regionBytes / bytesPerGiB / cpuWriteTime);
+  ImGui::Text("GPU read: %.3f ms (%.2f GiB/s)", gpuReadTime * 1000, regionBytes / bytesPerGiB / gpuReadTime);
+  const auto& stats = frames->GetStats();
+  ImGui::Text("CPU stalls: %llu / %llu frames (%.3f ms last)",
+              static_cast<unsigned long long>(stats.stallCount),
+              static_cast<unsigned long long>(stats.frameCount),
+              stats.lastStallNanoseconds / 1e6);
+  if (ImGui::Checkbox("Explicit flush (non-coherent)", &useExplicitFlush))
+  {
+    cpuWriteTime = 0;
+    gpuReadTime = 0;
+  }
+  if (ImGui::SliderInt("Bytes per frame (MiB)", &regionSizeMiB, 1, 128))
+  {
+    CreateStreamingBuffers();
+  }
+  ImGui::End();
+}
+
+int main()
+{
+  auto appInfo = Application::CreateInfo{
+    .name = "Buffer Streaming",
+    .maximize = false,
+    .decorate = true,
+    .vsync = false,
+  };
+  auto app = BufferStreamingApplication(appInfo);
+
+  app.Run();
+
+  return 0;
+}
@@ -0,0 +1,324 @@
+#include "common/Application.h"
+
+#include <Fwog/BasicTypes.h>
+#include <Fwog/Buffer.h>
+#include <Fwog/ParallelPrimitives.h>
+#include <Fwog/Readback.h>
+#include <Fwog/Rendering.h>
+#include <Fwog/Timer.h>
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+/* 08_parallel_primitives
+ *
+ * This example tests and benchmarks Fwog::PrefixSum, Fwog::StreamCompaction, and Fwog::RadixSort. Each primitive is
+ * run on random data and its output is compared with a reference computed on the CPU. The element counts cover the
+ * edge cases of the kernels: no elements, one element, counts that are not a multiple of the tile size, and many tiles.
+ * Radix sort is run with key widths that need an odd and an even number of passes, as the sorted pairs end up in the
+ * scratch buffers after an odd number of passes.
+ *
+ * Each case is then run a few more times with a timer query around it, and its throughput in elements per second is
+ * printed to stdout and shown in the UI. The timer waits for the GPU before each run, so the times include the
+ * submission of the commands, but not any other work. Build in release mode to get meaningful numbers, as PrefixSum
+ * waits for the GPU to check the sum in debug builds.
+ */
+
+class ParallelPrimitivesApplication final : public Application
+{
+public:
+  ParallelPrimitivesApplication(const Application::CreateInfo& createInfo);
+
+  void OnRender(double dt) override;
+
+  void OnGui(double dt) override;
+
+private:
+  struct TestResult
+  {
+    std::string name;
+    uint32_t count;
+    bool passed;
+    double elementsPerSecond;
+  };
+
+  void RunTests();
+  void TestPrefixSum(uint32_t count);
+  void TestStreamCompaction(uint32_t count, bool writeIndices);
+  void TestRadixSort(uint32_t count, uint32_t keyBits);
+  void AddResult(std::string name, uint32_t count, bool passed, double seconds);
+
+  std::vector<uint32_t> RandomValues(uint32_t count, uint32_t maxValue);
+
+  static constexpr uint32_t timedRuns = 10;
+
+  Fwog::PrefixSum prefixSum;
+  Fwog::StreamCompaction streamCompaction;
+  Fwog::RadixSort radixSort;
+  std::mt19937 rng;
+  std::vector<TestResult> results;
+};
+
+// Buffers can't be empty, so they always have room for at least one element
+static Fwog::TypedBuffer<uint32_t> CreateBuffer(std::span<const uint32_t> data)
+{
+  if (data.empty())
+  {
+    return Fwog::TypedBuffer<uint32_t>(size_t{1});
+  }
+  return Fwog::TypedBuffer<uint32_t>(data);
+}
+
+static std::vector<uint32_t> ReadBuffer(const Fwog::Buffer& buffer, uint32_t count)
+{
+  if (count == 0)
+  {
+    return {};
+  }
+
+  Fwog::MemoryBarrier(Fwog::MemoryBarrierBit::BUFFER_UPDATE_BIT);
+  auto readback = Fwog::ReadbackBuffer(buffer, 0, sizeof(uint32_t) * static_cast<uint64_t>(count));
+  readback.Wait();
+  const auto data = readback.DataAs<uint32_t>();
+  return {data.begin(), data.end()};
+}
+
+// Returns the GPU time of run, in seconds
+template<class F>
+static double TimeGpu(F&& run)
+{
+  auto timer = Fwog::TimerQuery();
+  timer.GetTimestamp();
+  run();
+  return timer.GetTimestamp() / 1e9;
+}
+
+ParallelPrimitivesApplication::ParallelPrimitivesApplication(const Application::CreateInfo& createInfo)
+  : Application(createInfo)
+{
+  RunTests();
+}
+
+std::vector<uint32_t> ParallelPrimitivesApplication::RandomValues(uint32_t count, uint32_t maxValue)
+{
+  auto distribution = std::uniform_int_distribution<uint32_t>(0, maxValue);
+  auto values = std::vector<uint32_t>(count);
+  std::ranges::generate(values, [&] { return distribution(rng); });
+  return values;
+}
+
+void ParallelPrimitivesApplication::RunTests()
+{
+  // The kernels process tiles of workgroupSize * itemsPerInvocation elements
+  constexpr auto info = Fwog::ParallelPrimitivesInfo{};
+  constexpr uint32_t tileSize = info.workgroupSize * info.itemsPerInvocation;
+  constexpr uint32_t counts[] = {0, 1, tileSize - 1, tileSize, tileSize + 1, 100'003, 1 << 22};
+
+  results.clear();
+  rng.seed(1234);
+
+  for (auto count : counts)
+  {
+    TestPrefixSum(count);
+  }
+
+  for (auto count : counts)
+  {
+    TestStreamCompaction(count, false);
+    TestStreamCompaction(count, true);
+  }
+
+  // 8 and 24 bit keys take an odd number of passes, 16 and 32 bit keys take an even number
+  for (uint32_t keyBits : {8, 16, 24, 32})
+  {
+    for (auto count : counts)
+    {
+      TestRadixSort(count, keyBits);
+    }
+  }
+
+  const auto failures =
+    static_cast<size_t>(std::ranges::count_if(results, [](const TestResult& result) { return !result.passed; }));
+  printf("%zu / %zu tests passed\n", results.size() - failures, results.size());
+}
+
+void ParallelPrimitivesApplication::AddResult(std::string name, uint32_t count, bool passed, double seconds)
+{
+  const auto elementsPerSecond = seconds > 0 ? count * static_cast<double>(timedRuns) / seconds : 0.0;
+  printf("%-28s %9u elements: %s, %8.1f M elements/s\n",
+         name.c_str(),
+         count,
+         passed ? "passed" : "FAILED",
+         elementsPerSecond / 1e6);
+  results.push_back({std::move(name), count, passed, elementsPerSecond});
+}
+
+void ParallelPrimitivesApplication::TestPrefixSum(uint32_t count)
+{
+  // Small values keep the sum below the 2^30 limit of the scan
+  const auto input = RandomValues(count, 15);
+  auto expected = std::vector<uint32_t>(count);
+  std::exclusive_scan(input.begin(), input.end(), expected.begin(), 0u);
+
+  const auto inputBuffer = CreateBuffer(input);
+  auto outputBuffer = CreateBuffer(input);
+  prefixSum.ExclusiveScan(inputBuffer, outputBuffer, count);
+  const bool passed = ReadBuffer(outputBuffer, count) == expected;
+
+  double seconds = 0;
+  for (uint32_t i = 0; i < timedRuns; i++)
+  {
+    seconds += TimeGpu([&] { prefixSum.ExclusiveScan(inputBuffer, outputBuffer, count); });
+  }
+
+  AddResult("PrefixSum", count, passed, seconds);
+}
+
+void ParallelPrimitivesApplication::TestStreamCompaction(uint32_t count, bool writeIndices)
+{
+  constexpr uint32_t dispatchGroupSize = 64;
+
+  const auto values = RandomValues(count, UINT32_MAX);
+  const auto flags = RandomValues(count, 1);
+  auto expected = std::vector<uint32_t>();
+  for (uint32_t i = 0; i < count; i++)
+  {
+    if (flags[i] != 0)
+    {
+      expected.push_back(writeIndices ? i : values[i]);
+    }
+  }
+
+  const auto valuesBuffer = CreateBuffer(values);
+  const auto flagsBuffer = CreateBuffer(flags);
+  auto outputBuffer = CreateBuffer(values);
+  auto resultBuffer = Fwog::TypedBuffer<Fwog::CompactionResult>();
+  const auto run = [&]
+  {
+    if (writeIndices)
+    {
+      streamCompaction.CompactIndices(flagsBuffer, outputBuffer, resultBuffer, count, dispatchGroupSize);
+    }
+    else
+    {
+      streamCompaction.Compact(valuesBuffer, flagsBuffer, outputBuffer, resultBuffer, count, dispatchGroupSize);
+    }
+  };
+
+  run();
+  const auto expectedCount = static_cast<uint32_t>(expected.size());
+  const auto result = ReadBuffer(resultBuffer, sizeof(Fwog::CompactionResult) / sizeof(uint32_t));
+  const bool passed = result[3] == expectedCount &&
+                      result[0] == (expectedCount + dispatchGroupSize - 1) / dispatchGroupSize &&
+                      ReadBuffer(outputBuffer, expectedCount) == expected;
+
+  double seconds = 0;
+  for (uint32_t i = 0; i < timedRuns; i++)
+  {
+    seconds += TimeGpu(run);
+  }
+
+  AddResult(writeIndices ? "StreamCompaction (indices)" : "StreamCompaction", count, passed, seconds);
+}
+
+void ParallelPrimitivesApplication::TestRadixSort(uint32_t count, uint32_t keyBits)
+{
+  const auto keys = RandomValues(count, keyBits == 32 ? UINT32_MAX : (1u << keyBits) - 1);
+  auto values = std::vector<uint32_t>(count);
+  std::iota(values.begin(), values.end(), 0u);
+
+  // Sorting the indices by key also checks that the sort is stable
+  auto expectedValues = values;
+  std::ranges::stable_sort(expectedValues, {}, [&](uint32_t i) { return keys[i]; });
+  auto expectedKeys = std::vector<uint32_t>(count);
+  std::ranges::transform(expectedValues, expectedKeys.begin(), [&](uint32_t i) { return keys[i]; });
+
+  // The sort is in place, so the unsorted pairs are copied in before every run
+  const auto sourceKeysBuffer = CreateBuffer(keys);
+  const auto sourceValuesBuffer = CreateBuffer(values);
+  auto keysBuffer = CreateBuffer(keys);
+  auto valuesBuffer = CreateBuffer(values);
+  const auto reset = [&]
+  {
+    Fwog::MemoryBarrier(Fwog::MemoryBarrierBit::BUFFER_UPDATE_BIT);
+    Fwog::CopyBuffer({.source = sourceKeysBuffer, .target = keysBuffer});
+    Fwog::CopyBuffer({.source = sourceValuesBuffer, .target = valuesBuffer});
+  };
+
+  radixSort.SortPairs(keysBuffer, valuesBuffer, count, keyBits);
+  const bool passed =
+    ReadBuffer(keysBuffer, count) == expectedKeys && ReadBuffer(valuesBuffer, count) == expectedValues;
+
+  double seconds = 0;
+  for (uint32_t i = 0; i < timedRuns; i++)
+  {
+    reset();
+    seconds += TimeGpu([&] { radixSort.SortPairs(keysBuffer, valuesBuffer, count, keyBits); });
+  }
+
+  AddResult("RadixSort (" + std::to_string(keyBits) + "-bit keys)", count, passed, seconds);
+}
+
+void ParallelPrimitivesApplication::OnRender([[maybe_unused]] double dt)
+{
+  Fwog::BeginSwapchainRendering(Fwog::SwapchainRenderInfo{
+    .viewport = Fwog::Viewport{.drawRect{.offset = {0, 0}, .extent = {windowWidth, windowHeight}}},
+    .colorLoadOp = Fwog::AttachmentLoadOp::CLEAR,
+    .clearColorValue = {.1f, .1f, .1f, 1.0f},
+  });
+  Fwog::EndRendering();
+}
+
+void ParallelPrimitivesApplication::OnGui([[maybe_unused]] double dt)
+{
+  ImGui::Begin("Parallel Primitives");
+  if (ImGui::Button("Run Again"))
+  {
+    RunTests();
+  }
+
+  if (ImGui::BeginTable("Results", 4, ImGuiTableFlags_Borders))
+  {
+    ImGui::TableSetupColumn("Primitive");
+    ImGui::TableSetupColumn("Elements");
+    ImGui::TableSetupColumn("Result");
+    ImGui::TableSetupColumn("M elements/s");
+    ImGui::TableHeadersRow();
+    for (const auto& result : results)
+    {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::Text("%s", result.name.c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%u", result.count);
+      ImGui::TableNextColumn();
+      ImGui::Text("%s", result.passed ? "Passed" : "FAILED");
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f", result.elementsPerSecond / 1e6);
+    }
+    ImGui::EndTable();
+  }
+  ImGui::End();
+}
+
+int main()
+{
+  auto appInfo = Application::CreateInfo{
+    .name = "Parallel Primitives",
+    .maximize = false,
+    .decorate = true,
+    .vsync = true,
+  };
+  auto app = ParallelPrimitivesApplication(appInfo);
+
+  app.Run();
+
+  return 0;
+}
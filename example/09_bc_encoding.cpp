@@ -0,0 +1,137 @@
+#include "common/BlockCompression.h"
+
+#include <Fwog/BasicTypes.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <span>
+#include <vector>
+
+/* 09_bc_encoding
+ *
+ * This example is a command-line benchmark of the CPU block-compression encoder in common/BlockCompression.h, which
+ * the glTF loader uses when image compression is enabled. It encodes an image with every supported format and quality
+ * preset on a single thread, and prints the throughput in MPixels/s and the PSNR of the decoded result.
+ *
+ * Usage: 09_bc_encoding [image]
+ *
+ * Any image that stb_image can load may be given. Otherwise, a synthetic 509x263 image is used. It has smooth
+ * gradients, a high-frequency pattern, noise, and an alpha channel that is opaque on the left half, and its extent is
+ * not a multiple of the block size.
+ */
+
+struct Image
+{
+  uint32_t width;
+  uint32_t height;
+  std::vector<std::byte> rgba;
+};
+
+static Image CreateSyntheticImage()
+{
+  constexpr uint32_t width = 509;
+  constexpr uint32_t height = 263;
+
+  auto rng = std::mt19937(1);
+  auto noise = std::uniform_int_distribution<int>(-6, 6);
+  const auto channel = [](int value) { return static_cast<std::byte>(std::clamp(value, 0, 255)); };
+
+  auto image = Image{width, height, std::vector<std::byte>(width * height * 4)};
+  for (uint32_t y = 0; y < height; y++)
+  {
+    for (uint32_t x = 0; x < width; x++)
+    {
+      auto* texel = &image.rgba[(y * width + x) * 4];
+      texel[0] = channel(static_cast<int>(127 + 120 * std::sin(x * 0.05)) + noise(rng));
+      texel[1] = channel(static_cast<int>(y * 255 / height) + noise(rng));
+      texel[2] = channel(static_cast<int>((x ^ y) & 255) / 4 + noise(rng) + 60);
+      texel[3] = x < width / 2 ? std::byte{255} : static_cast<std::byte>((x * 3) & 255);
+    }
+  }
+  return image;
+}
+
+int main(int argc, const char* const* argv)
+{
+  // Each case is encoded repeatedly for at least this long, so short runs aren't dominated by timer resolution
+  constexpr double minSeconds = 0.5;
+
+  struct FormatInfo
+  {
+    Fwog::Format format;
+    const char* name;
+    uint32_t channelCount; // The channels that PSNR is measured over
+  };
+
+  constexpr FormatInfo formats[] = {
+    {Fwog::Format::BC1_RGB_UNORM, "BC1", 3},
+    {Fwog::Format::BC3_RGBA_UNORM, "BC3", 4},
+    {Fwog::Format::BC4_R_UNORM, "BC4", 1},
+    {Fwog::Format::BC5_RG_UNORM, "BC5", 2},
+  };
+
+  constexpr Utility::BcQuality qualities[] = {
+    Utility::BcQuality::FAST,
+    Utility::BcQuality::NORMAL,
+    Utility::BcQuality::HIGH,
+  };
+  constexpr const char* qualityNames[] = {"fast", "normal", "high"};
+
+  Image image;
+  if (argc > 1)
+  {
+    int x, y, comp;
+    auto* pixels = stbi_load(argv[1], &x, &y, &comp, 4);
+    if (!pixels)
+    {
+      printf("Failed to load %s: %s\n", argv[1], stbi_failure_reason());
+      return 1;
+    }
+    const auto* bytes = reinterpret_cast<const std::byte*>(pixels);
+    image = {static_cast<uint32_t>(x), static_cast<uint32_t>(y), {bytes, bytes + static_cast<size_t>(x) * y * 4}};
+    stbi_image_free(pixels);
+  }
+  else
+  {
+    image = CreateSyntheticImage();
+  }
+
+  printf("Image: %ux%u\n", image.width, image.height);
+  printf("%-7s %-8s %12s %10s\n", "Format", "Quality", "MPixels/s", "PSNR (dB)");
+
+  const auto pixelCount = static_cast<double>(image.width) * image.height;
+  for (const auto& [format, name, channelCount] : formats)
+  {
+    auto encoded = std::vector<std::byte>(Utility::GetBcImageSize(format, image.width, image.height));
+    auto decoded = std::vector<std::byte>(image.rgba.size());
+
+    for (auto quality : qualities)
+    {
+      uint32_t runs = 0;
+      double seconds = 0;
+      while (seconds < minSeconds)
+      {
+        const auto start = std::chrono::steady_clock::now();
+        Utility::EncodeBc(format, image.rgba, image.width, image.height, encoded, quality);
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        runs++;
+      }
+
+      Utility::DecodeBc(format, encoded, image.width, image.height, decoded);
+      printf("%-7s %-8s %12.1f %10.2f\n",
+             name,
+             qualityNames[static_cast<int>(quality)],
+             pixelCount * runs / seconds / 1e6,
+             Utility::ComputePsnr(image.rgba, decoded, channelCount));
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,245 @@
+#include "common/Application.h"
+
+#include <Fwog/BasicTypes.h>
+#include <Fwog/MipmapGenerator.h>
+#include <Fwog/Readback.h>
+#include <Fwog/Rendering.h>
+#include <Fwog/Texture.h>
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+/* 10_mipmap_generation
+ *
+ * This example tests Fwog::MipmapGenerator on chains that are generated in a single dispatch and on chains that are
+ * too large for it. In a single dispatch, the last workgroup to finish reduces one 64x64 tile of the sixth generated
+ * level into the rest of the chain, so chains whose sixth generated level is larger than that must be generated in
+ * several dispatches. The cases cover non-power-of-two extents, a base level of 8192 or more with a truncated chain,
+ * and a base level other than zero.
+ *
+ * Each case fills the base level of an R32_FLOAT texture with random values, clears the other levels, and generates
+ * the chain. The sixth generated level is then copied into the base level of a second texture whose chain is short
+ * enough that it is always generated in one dispatch of the multi-pass path. The levels after the sixth generated level
+ * of the first texture must match the generated levels of the second one exactly, as both are reduced by the same
+ * code. The results are printed to stdout and shown in the UI.
+ */
+
+class MipmapGenerationApplication final : public Application
+{
+public:
+  MipmapGenerationApplication(const Application::CreateInfo& createInfo);
+
+  void OnRender(double dt) override;
+
+  void OnGui(double dt) override;
+
+private:
+  struct TestCase
+  {
+    Fwog::Extent2D extent;
+    uint32_t mipLevels;
+    uint32_t baseLevel;
+  };
+
+  struct TestResult
+  {
+    std::string name;
+    bool passed;
+  };
+
+  void RunTests();
+  void TestChain(const TestCase& testCase, Fwog::MipmapFilter filter);
+
+  Fwog::MipmapGenerator mipmapGenerator;
+  std::mt19937 rng;
+  std::vector<TestResult> results;
+};
+
+// The number of levels after the base level that each workgroup of the reduction writes
+static constexpr uint32_t levelsPerTile = 6;
+
+static Fwog::Extent2D LevelExtent(Fwog::Extent2D extent, uint32_t level)
+{
+  return {std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u)};
+}
+
+static constexpr uint32_t FullChainLevels(Fwog::Extent2D extent)
+{
+  uint32_t levels = 1;
+  while ((std::max(extent.width, extent.height) >> levels) > 0)
+  {
+    levels++;
+  }
+  return levels;
+}
+
+static Fwog::Texture CreateTexture(Fwog::Extent2D extent, uint32_t mipLevels)
+{
+  return Fwog::Texture(Fwog::TextureCreateInfo{
+    .imageType = Fwog::ImageType::TEX_2D,
+    .format = Fwog::Format::R32_FLOAT,
+    .extent = {extent.width, extent.height, 1},
+    .mipLevels = mipLevels,
+    .arrayLayers = 1,
+    .sampleCount = Fwog::SampleCount::SAMPLES_1,
+  });
+}
+
+static std::vector<float> ReadLevel(const Fwog::Texture& texture, uint32_t level)
+{
+  const auto extent = LevelExtent({texture.Extent().width, texture.Extent().height}, level);
+  auto readback = Fwog::ReadbackTexture({
+    .sourceTexture = texture,
+    .level = level,
+    .extent = {extent.width, extent.height, 1},
+  });
+  readback.Wait();
+  const auto data = readback.DataAs<float>();
+  return {data.begin(), data.end()};
+}
+
+MipmapGenerationApplication::MipmapGenerationApplication(const Application::CreateInfo& createInfo)
+  : Application(createInfo)
+{
+  RunTests();
+}
+
+void MipmapGenerationApplication::RunTests()
+{
+  constexpr TestCase testCases[] = {
+    // The sixth generated level is 62x46, so this is generated in a single dispatch if the device supports it
+    {{4000, 3000}, FullChainLevels({4000, 3000}), 0},
+    // The sixth generated level is 93x93
+    {{6000, 6000}, FullChainLevels({6000, 6000}), 0},
+    // A truncated chain of a base level wider than 8192. The sixth generated level is 140x1
+    {{9000, 40}, 13, 0},
+    // The chain from level 1 has 13 levels, and its sixth generated level is 93x1
+    {{12000, 50}, FullChainLevels({12000, 50}), 1},
+  };
+
+  results.clear();
+  rng.seed(1234);
+
+  for (const auto& testCase : testCases)
+  {
+    TestChain(testCase, Fwog::MipmapFilter::BOX);
+    TestChain(testCase, Fwog::MipmapFilter::MAX);
+  }
+
+  const auto failures =
+    static_cast<size_t>(std::ranges::count_if(results, [](const TestResult& result) { return !result.passed; }));
+  printf("%zu / %zu tests passed\n", results.size() - failures, results.size());
+}
+
+void MipmapGenerationApplication::TestChain(const TestCase& testCase, Fwog::MipmapFilter filter)
+{
+  const auto [extent, mipLevels, baseLevel] = testCase;
+
+  auto texture = CreateTexture(extent, mipLevels);
+
+  // Texels that are never written keep this value
+  constexpr float cleared = -1.0f;
+  for (uint32_t level = 0; level < mipLevels; level++)
+  {
+    const auto levelExtent = LevelExtent(extent, level);
+    texture.ClearImage({
+      .level = level,
+      .extent = {levelExtent.width, levelExtent.height, 1},
+      .data = &cleared,
+    });
+  }
+
+  const auto baseExtent = LevelExtent(extent, baseLevel);
+  auto distribution = std::uniform_real_distribution<float>(0, 1);
+  auto texels = std::vector<float>(static_cast<size_t>(baseExtent.width) * baseExtent.height);
+  std::ranges::generate(texels, [&] { return distribution(rng); });
+  texture.UpdateImage({
+    .level = baseLevel,
+    .extent = {baseExtent.width, baseExtent.height, 1},
+    .pixels = texels.data(),
+  });
+
+  mipmapGenerator.Generate(texture, {.filter = filter, .baseLevel = baseLevel});
+
+  // The reference chain starts at the sixth generated level, so it has at most seven levels
+  const uint32_t splitLevel = baseLevel + levelsPerTile;
+  const auto splitExtent = LevelExtent(extent, splitLevel);
+  auto reference = CreateTexture(splitExtent, mipLevels - splitLevel);
+  Fwog::MemoryBarrier(Fwog::MemoryBarrierBit::TEXTURE_UPDATE_BIT);
+  Fwog::CopyTexture({
+    .source = texture,
+    .target = reference,
+    .sourceLevel = splitLevel,
+    .extent = {splitExtent.width, splitExtent.height, 1},
+  });
+  mipmapGenerator.Generate(reference, {.filter = filter});
+
+  Fwog::MemoryBarrier(Fwog::MemoryBarrierBit::TEXTURE_UPDATE_BIT);
+  bool passed = true;
+  for (uint32_t level = splitLevel + 1; level < mipLevels; level++)
+  {
+    passed = passed && ReadLevel(texture, level) == ReadLevel(reference, level - splitLevel);
+  }
+
+  auto name = std::to_string(extent.width) + "x" + std::to_string(extent.height) + ", " + std::to_string(mipLevels) +
+              " levels from level " + std::to_string(baseLevel);
+  name += filter == Fwog::MipmapFilter::BOX ? ", box" : ", max";
+  printf("%-44s %s\n", name.c_str(), passed ? "passed" : "FAILED");
+  results.push_back({std::move(name), passed});
+}
+
+void MipmapGenerationApplication::OnRender([[maybe_unused]] double dt)
+{
+  Fwog::BeginSwapchainRendering(Fwog::SwapchainRenderInfo{
+    .viewport = Fwog::Viewport{.drawRect{.offset = {0, 0}, .extent = {windowWidth, windowHeight}}},
+    .colorLoadOp = Fwog::AttachmentLoadOp::CLEAR,
+    .clearColorValue = {.1f, .1f, .1f, 1.0f},
+  });
+  Fwog::EndRendering();
+}
+
+void MipmapGenerationApplication::OnGui([[maybe_unused]] double dt)
+{
+  ImGui::Begin("Mipmap Generation");
+  if (ImGui::Button("Run Again"))
+  {
+    RunTests();
+  }
+
+  if (ImGui::BeginTable("Results", 2, ImGuiTableFlags_Borders))
+  {
+    ImGui::TableSetupColumn("Chain");
+    ImGui::TableSetupColumn("Result");
+    ImGui::TableHeadersRow();
+    for (const auto& result : results)
+    {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::Text("%s", result.name.c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%s", result.passed ? "Passed" : "FAILED");
+    }
+    ImGui::EndTable();
+  }
+  ImGui::End();
+}
+
+int main()
+{
+  auto appInfo = Application::CreateInfo{
+    .name = "Mipmap Generation",
+    .maximize = false,
+    .decorate = true,
+    .vsync = true,
+  };
+  auto app = MipmapGenerationApplication(appInfo);
+
+  app.Run();
+
+  return 0;
+}
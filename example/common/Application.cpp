@@ -250,6 +250,9 @@ void Application::Draw(double dt)
   }
 
   glfwSwapBuffers(window);
+
+  // Does nothing unless deferred destruction was enabled by the application
+  Fwog::ProcessDeferredDestruction();
 }
 
 void Application::Run()
@@ -0,0 +1,603 @@
+#include "BlockCompression.h"
+
+#include <Fwog/Config.h>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/mat3x3.hpp>
+#include <glm/vec3.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace Utility
+{
+  namespace
+  {
+    enum class BlockKind
+    {
+      NONE,
+      BC1,
+      BC3,
+      BC4,
+      BC5,
+    };
+
+    BlockKind GetBlockKind(Fwog::Format format)
+    {
+      switch (format)
+      {
+      case Fwog::Format::BC1_RGB_UNORM: //[[fallthrough]]
+      case Fwog::Format::BC1_RGB_SRGB: return BlockKind::BC1;
+      case Fwog::Format::BC3_RGBA_UNORM: //[[fallthrough]]
+      case Fwog::Format::BC3_RGBA_SRGB: return BlockKind::BC3;
+      case Fwog::Format::BC4_R_UNORM: return BlockKind::BC4;
+      case Fwog::Format::BC5_RG_UNORM: return BlockKind::BC5;
+      default: return BlockKind::NONE;
+      }
+    }
+
+    size_t GetBlockSize(BlockKind kind)
+    {
+      return kind == BlockKind::BC1 || kind == BlockKind::BC4 ? 8 : 16;
+    }
+
+    // 4x4 RGBA texels in row-major order
+    using Block = std::array<std::array<uint8_t, 4>, 16>;
+
+    Block LoadBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY)
+    {
+      Block block;
+      for (uint32_t y = 0; y < 4; y++)
+      {
+        const uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+        for (uint32_t x = 0; x < 4; x++)
+        {
+          const uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+          std::memcpy(block[y * 4 + x].data(), rgba + (static_cast<size_t>(sourceY) * width + sourceX) * 4, 4);
+        }
+      }
+      return block;
+    }
+
+    void StoreBlock(const Block& block, uint8_t* rgba, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY)
+    {
+      for (uint32_t y = 0; y < 4 && blockY * 4 + y < height; y++)
+      {
+        for (uint32_t x = 0; x < 4 && blockX * 4 + x < width; x++)
+        {
+          const size_t texel = static_cast<size_t>(blockY * 4 + y) * width + blockX * 4 + x;
+          std::memcpy(rgba + texel * 4, block[y * 4 + x].data(), 4);
+        }
+      }
+    }
+
+    void Write16(uint8_t* out, uint16_t value)
+    {
+      out[0] = static_cast<uint8_t>(value);
+      out[1] = static_cast<uint8_t>(value >> 8);
+    }
+
+    uint16_t Read16(const uint8_t* in)
+    {
+      return static_cast<uint16_t>(in[0] | (in[1] << 8));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Color blocks (BC1, and the color half of BC3)
+
+    uint16_t PackRgb565(glm::vec3 color)
+    {
+      const auto c = glm::clamp(color, 0.0f, 255.0f) / 255.0f;
+      const auto r = static_cast<uint32_t>(c.r * 31.0f + 0.5f);
+      const auto g = static_cast<uint32_t>(c.g * 63.0f + 0.5f);
+      const auto b = static_cast<uint32_t>(c.b * 31.0f + 0.5f);
+      return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    glm::vec3 UnpackRgb565(uint16_t color)
+    {
+      const uint32_t r = (color >> 11) & 31;
+      const uint32_t g = (color >> 5) & 63;
+      const uint32_t b = color & 31;
+      return glm::vec3((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+    }
+
+    // The four-color palette, in index order
+    std::array<glm::vec3, 4> GetColorPalette(uint16_t c0, uint16_t c1)
+    {
+      const auto p0 = UnpackRgb565(c0);
+      const auto p1 = UnpackRgb565(c1);
+      return {p0, p1, (2.0f * p0 + p1) / 3.0f, (p0 + 2.0f * p1) / 3.0f};
+    }
+
+    // The weight of endpoint 0 for each index in four-color mode
+    constexpr std::array<float, 4> colorIndexWeights = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+
+    struct ColorBlock
+    {
+      uint16_t c0;
+      uint16_t c1;
+      uint32_t indices;
+      float error;
+    };
+
+    // Chooses the nearest palette entry for each texel. Endpoints are ordered so that the block is decoded in four-color
+    // mode, even where the order would otherwise select three-color mode (BC1 with c0 <= c1)
+    ColorBlock FitColorIndices(const std::array<glm::vec3, 16>& colors, uint16_t c0, uint16_t c1)
+    {
+      if (c0 < c1)
+      {
+        std::swap(c0, c1);
+      }
+
+      ColorBlock result{.c0 = c0, .c1 = c1, .indices = 0, .error = 0};
+
+      // Three-color mode can't be avoided, so only use the shared endpoint
+      if (c0 == c1)
+      {
+        const auto p0 = UnpackRgb565(c0);
+        for (const auto& color : colors)
+        {
+          const auto d = color - p0;
+          result.error += glm::dot(d, d);
+        }
+        return result;
+      }
+
+      const auto palette = GetColorPalette(c0, c1);
+      for (uint32_t i = 0; i < 16; i++)
+      {
+        uint32_t bestIndex = 0;
+        float bestError = std::numeric_limits<float>::max();
+        for (uint32_t j = 0; j < 4; j++)
+        {
+          const auto d = colors[i] - palette[j];
+          if (const float error = glm::dot(d, d); error < bestError)
+          {
+            bestError = error;
+            bestIndex = j;
+          }
+        }
+        result.indices |= bestIndex << (2 * i);
+        result.error += bestError;
+      }
+
+      return result;
+    }
+
+    std::pair<glm::vec3, glm::vec3> GetBoundingBoxEndpoints(const std::array<glm::vec3, 16>& colors)
+    {
+      auto lo = colors[0];
+      auto hi = colors[0];
+      for (const auto& color : colors)
+      {
+        lo = glm::min(lo, color);
+        hi = glm::max(hi, color);
+      }
+
+      // Move the endpoints inward, as the extremes are rarely the colors that most of the block is closest to
+      const auto inset = (hi - lo) / 16.0f;
+      return {hi - inset, lo + inset};
+    }
+
+    std::pair<glm::vec3, glm::vec3> GetPrincipalAxisEndpoints(const std::array<glm::vec3, 16>& colors)
+    {
+      auto mean = glm::vec3(0);
+      for (const auto& color : colors)
+      {
+        mean += color;
+      }
+      mean /= 16.0f;
+
+      auto covariance = glm::mat3(0);
+      for (const auto& color : colors)
+      {
+        const auto d = color - mean;
+        covariance += glm::mat3(d * d.x, d * d.y, d * d.z);
+      }
+
+      // Power iteration, starting from the luminance axis
+      auto axis = glm::vec3(1);
+      for (int i = 0; i < 8; i++)
+      {
+        axis = covariance * axis;
+        const float length = glm::length(axis);
+        if (length < 1e-6f)
+        {
+          // Every color is the same
+          return {mean, mean};
+        }
+        axis /= length;
+      }
+
+      // Use the colors at the extremes of the axis, which are better endpoints than the projections of them
+      uint32_t minIndex = 0;
+      uint32_t maxIndex = 0;
+      float minT = std::numeric_limits<float>::max();
+      float maxT = std::numeric_limits<float>::lowest();
+      for (uint32_t i = 0; i < 16; i++)
+      {
+        const float t = glm::dot(colors[i] - mean, axis);
+        if (t < minT)
+        {
+          minT = t;
+          minIndex = i;
+        }
+        if (t > maxT)
+        {
+          maxT = t;
+          maxIndex = i;
+        }
+      }
+
+      return {colors[maxIndex], colors[minIndex]};
+    }
+
+    // Finds the endpoints that minimize the squared error of the block if the indices don't change. Returns false if
+    // the indices don't constrain both endpoints
+    bool RefineColorEndpoints(const std::array<glm::vec3, 16>& colors, uint32_t indices, glm::vec3& e0, glm::vec3& e1)
+    {
+      float w00 = 0, w01 = 0, w11 = 0;
+      auto x0 = glm::vec3(0);
+      auto x1 = glm::vec3(0);
+      for (uint32_t i = 0; i < 16; i++)
+      {
+        const float w = colorIndexWeights[(indices >> (2 * i)) & 3];
+        w00 += w * w;
+        w01 += w * (1.0f - w);
+        w11 += (1.0f - w) * (1.0f - w);
+        x0 += w * colors[i];
+        x1 += (1.0f - w) * colors[i];
+      }
+
+      const float determinant = w00 * w11 - w01 * w01;
+      if (std::abs(determinant) < 1e-6f)
+      {
+        return false;
+      }
+
+      e0 = (x0 * w11 - x1 * w01) / determinant;
+      e1 = (x1 * w00 - x0 * w01) / determinant;
+      return true;
+    }
+
+    void EncodeColorBlock(const Block& block, uint8_t* out, BcQuality quality)
+    {
+      std::array<glm::vec3, 16> colors;
+      for (uint32_t i = 0; i < 16; i++)
+      {
+        colors[i] = glm::vec3(block[i][0], block[i][1], block[i][2]);
+      }
+
+      const auto [e0, e1] =
+        quality == BcQuality::FAST ? GetBoundingBoxEndpoints(colors) : GetPrincipalAxisEndpoints(colors);
+      auto best = FitColorIndices(colors, PackRgb565(e0), PackRgb565(e1));
+
+      if (quality == BcQuality::HIGH)
+      {
+        for (int iteration = 0; iteration < 2 && best.error > 0; iteration++)
+        {
+          glm::vec3 r0, r1;
+          if (!RefineColorEndpoints(colors, best.indices, r0, r1))
+          {
+            break;
+          }
+
+          const auto candidate = FitColorIndices(colors, PackRgb565(r0), PackRgb565(r1));
+          if (candidate.error >= best.error)
+          {
+            break;
+          }
+          best = candidate;
+        }
+      }
+
+      Write16(out, best.c0);
+      Write16(out + 2, best.c1);
+      for (int i = 0; i < 4; i++)
+      {
+        out[4 + i] = static_cast<uint8_t>(best.indices >> (8 * i));
+      }
+    }
+
+    void DecodeColorBlock(const uint8_t* in, Block& block, bool allowThreeColorMode)
+    {
+      const uint16_t c0 = Read16(in);
+      const uint16_t c1 = Read16(in + 2);
+
+      std::array<std::array<uint8_t, 4>, 4> palette;
+      auto store = [&](uint32_t index, glm::vec3 color, uint8_t alpha)
+      {
+        palette[index] = {static_cast<uint8_t>(color.r + 0.5f),
+                          static_cast<uint8_t>(color.g + 0.5f),
+                          static_cast<uint8_t>(color.b + 0.5f),
+                          alpha};
+      };
+
+      const auto p0 = UnpackRgb565(c0);
+      const auto p1 = UnpackRgb565(c1);
+      store(0, p0, 255);
+      store(1, p1, 255);
+      if (c0 > c1 || !allowThreeColorMode)
+      {
+        store(2, (2.0f * p0 + p1) / 3.0f, 255);
+        store(3, (p0 + 2.0f * p1) / 3.0f, 255);
+      }
+      else
+      {
+        store(2, (p0 + p1) / 2.0f, 255);
+        store(3, glm::vec3(0), 0);
+      }
+
+      const uint32_t indices = in[4] | (in[5] << 8) | (in[6] << 16) | (static_cast<uint32_t>(in[7]) << 24);
+      for (uint32_t i = 0; i < 16; i++)
+      {
+        block[i] = palette[(indices >> (2 * i)) & 3];
+      }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Single-channel blocks (BC4, BC5, and the alpha half of BC3)
+
+    // The eight-value palette, in index order. Values are interpolated if a0 > a1. Otherwise, there are four
+    // interpolated values, 0, and 255
+    std::array<uint8_t, 8> GetChannelPalette(uint8_t a0, uint8_t a1)
+    {
+      std::array<uint8_t, 8> palette{a0, a1};
+      if (a0 > a1)
+      {
+        for (uint32_t i = 2; i < 8; i++)
+        {
+          palette[i] = static_cast<uint8_t>(((8 - i) * a0 + (i - 1) * a1 + 3) / 7);
+        }
+      }
+      else
+      {
+        for (uint32_t i = 2; i < 6; i++)
+        {
+          palette[i] = static_cast<uint8_t>(((6 - i) * a0 + (i - 1) * a1 + 2) / 5);
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+      }
+      return palette;
+    }
+
+    struct ChannelBlock
+    {
+      uint8_t a0;
+      uint8_t a1;
+      uint64_t indices;
+      uint32_t error;
+    };
+
+    ChannelBlock FitChannelIndices(const std::array<uint8_t, 16>& values, uint8_t a0, uint8_t a1)
+    {
+      ChannelBlock result{.a0 = a0, .a1 = a1, .indices = 0, .error = 0};
+
+      const auto palette = GetChannelPalette(a0, a1);
+      for (uint32_t i = 0; i < 16; i++)
+      {
+        uint64_t bestIndex = 0;
+        uint32_t bestError = std::numeric_limits<uint32_t>::max();
+        for (uint32_t j = 0; j < 8; j++)
+        {
+          const int d = values[i] - palette[j];
+          if (const auto error = static_cast<uint32_t>(d * d); error < bestError)
+          {
+            bestError = error;
+            bestIndex = j;
+          }
+        }
+        result.indices |= bestIndex << (3 * i);
+        result.error += bestError;
+      }
+
+      return result;
+    }
+
+    void EncodeChannelBlock(const Block& block, uint32_t channel, uint8_t* out, BcQuality quality)
+    {
+      std::array<uint8_t, 16> values;
+      for (uint32_t i = 0; i < 16; i++)
+      {
+        values[i] = block[i][channel];
+      }
+
+      const auto [lo, hi] = std::ranges::minmax(values);
+      auto best = FitChannelIndices(values, hi, lo);
+
+      // Blocks that contain 0 or 255 may be better served by six interpolated values between the rest, since the
+      // extremes have their own indices
+      if (quality == BcQuality::HIGH && best.error > 0)
+      {
+        uint8_t innerLo = 255;
+        uint8_t innerHi = 0;
+        for (auto value : values)
+        {
+          if (value != 0 && value != 255)
+          {
+            innerLo = std::min(innerLo, value);
+            innerHi = std::max(innerHi, value);
+          }
+        }
+        if (innerLo > innerHi)
+        {
+          innerLo = innerHi = 0;
+        }
+
+        if (const auto candidate = FitChannelIndices(values, innerLo, innerHi); candidate.error < best.error)
+        {
+          best = candidate;
+        }
+      }
+
+      out[0] = best.a0;
+      out[1] = best.a1;
+      for (int i = 0; i < 6; i++)
+      {
+        out[2 + i] = static_cast<uint8_t>(best.indices >> (8 * i));
+      }
+    }
+
+    void DecodeChannelBlock(const uint8_t* in, Block& block, uint32_t channel)
+    {
+      const auto palette = GetChannelPalette(in[0], in[1]);
+      uint64_t indices = 0;
+      for (int i = 0; i < 6; i++)
+      {
+        indices |= static_cast<uint64_t>(in[2 + i]) << (8 * i);
+      }
+      for (uint32_t i = 0; i < 16; i++)
+      {
+        block[i][channel] = palette[(indices >> (3 * i)) & 7];
+      }
+    }
+  } // namespace
+
+  bool IsBcEncodable(Fwog::Format format)
+  {
+    return GetBlockKind(format) != BlockKind::NONE;
+  }
+
+  size_t GetBcImageSize(Fwog::Format format, uint32_t width, uint32_t height)
+  {
+    FWOG_ASSERT(IsBcEncodable(format));
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(GetBlockKind(format));
+  }
+
+  void EncodeBc(Fwog::Format format,
+                std::span<const std::byte> rgba,
+                uint32_t width,
+                uint32_t height,
+                std::span<std::byte> output,
+                BcQuality quality)
+  {
+    const auto kind = GetBlockKind(format);
+    FWOG_ASSERT(kind != BlockKind::NONE);
+    FWOG_ASSERT(rgba.size() >= static_cast<size_t>(width) * height * 4);
+    FWOG_ASSERT(output.size() >= GetBcImageSize(format, width, height));
+
+    const auto* in = reinterpret_cast<const uint8_t*>(rgba.data());
+    auto* out = reinterpret_cast<uint8_t*>(output.data());
+    for (uint32_t blockY = 0; blockY < (height + 3) / 4; blockY++)
+    {
+      for (uint32_t blockX = 0; blockX < (width + 3) / 4; blockX++)
+      {
+        const auto block = LoadBlock(in, width, height, blockX, blockY);
+        switch (kind)
+        {
+        case BlockKind::BC1: EncodeColorBlock(block, out, quality); break;
+        case BlockKind::BC3:
+          EncodeChannelBlock(block, 3, out, quality);
+          EncodeColorBlock(block, out + 8, quality);
+          break;
+        case BlockKind::BC4: EncodeChannelBlock(block, 0, out, quality); break;
+        case BlockKind::BC5:
+          EncodeChannelBlock(block, 0, out, quality);
+          EncodeChannelBlock(block, 1, out + 8, quality);
+          break;
+        default: FWOG_UNREACHABLE;
+        }
+        out += GetBlockSize(kind);
+      }
+    }
+  }
+
+  void DecodeBc(Fwog::Format format,
+                std::span<const std::byte> encoded,
+                uint32_t width,
+                uint32_t height,
+                std::span<std::byte> rgba)
+  {
+    const auto kind = GetBlockKind(format);
+    FWOG_ASSERT(kind != BlockKind::NONE);
+    FWOG_ASSERT(encoded.size() >= GetBcImageSize(format, width, height));
+    FWOG_ASSERT(rgba.size() >= static_cast<size_t>(width) * height * 4);
+
+    const auto* in = reinterpret_cast<const uint8_t*>(encoded.data());
+    auto* out = reinterpret_cast<uint8_t*>(rgba.data());
+    for (uint32_t blockY = 0; blockY < (height + 3) / 4; blockY++)
+    {
+      for (uint32_t blockX = 0; blockX < (width + 3) / 4; blockX++)
+      {
+        Block block;
+        block.fill({0, 0, 0, 255});
+        switch (kind)
+        {
+        case BlockKind::BC1: DecodeColorBlock(in, block, true); break;
+        case BlockKind::BC3:
+          DecodeColorBlock(in + 8, block, false);
+          DecodeChannelBlock(in, block, 3);
+          break;
+        case BlockKind::BC4: DecodeChannelBlock(in, block, 0); break;
+        case BlockKind::BC5:
+          DecodeChannelBlock(in, block, 0);
+          DecodeChannelBlock(in + 8, block, 1);
+          break;
+        default: FWOG_UNREACHABLE;
+        }
+        StoreBlock(block, out, width, height, blockX, blockY);
+        in += GetBlockSize(kind);
+      }
+    }
+  }
+
+  double ComputePsnr(std::span<const std::byte> reference, std::span<const std::byte> test, uint32_t channelCount)
+  {
+    FWOG_ASSERT(reference.size() == test.size() && reference.size() % 4 == 0);
+    FWOG_ASSERT(channelCount >= 1 && channelCount <= 4);
+
+    double squaredError = 0;
+    for (size_t texel = 0; texel < reference.size(); texel += 4)
+    {
+      for (uint32_t channel = 0; channel < channelCount; channel++)
+      {
+        const double d = std::to_integer<int>(reference[texel + channel]) - std::to_integer<int>(test[texel + channel]);
+        squaredError += d * d;
+      }
+    }
+
+    const double meanSquaredError = squaredError / (static_cast<double>(reference.size() / 4) * channelCount);
+    if (meanSquaredError == 0)
+    {
+      return std::numeric_limits<double>::infinity();
+    }
+    return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+  }
+
+  std::vector<std::byte> DownsampleRgba8(std::span<const std::byte> rgba, uint32_t width, uint32_t height)
+  {
+    FWOG_ASSERT(rgba.size() >= static_cast<size_t>(width) * height * 4);
+
+    const uint32_t newWidth = std::max(width / 2, 1u);
+    const uint32_t newHeight = std::max(height / 2, 1u);
+    std::vector<std::byte> result(static_cast<size_t>(newWidth) * newHeight * 4);
+
+    const auto* in = reinterpret_cast<const uint8_t*>(rgba.data());
+    auto* out = reinterpret_cast<uint8_t*>(result.data());
+    for (uint32_t y = 0; y < newHeight; y++)
+    {
+      const size_t row0 = static_cast<size_t>(std::min(y * 2, height - 1)) * width;
+      const size_t row1 = static_cast<size_t>(std::min(y * 2 + 1, height - 1)) * width;
+      for (uint32_t x = 0; x < newWidth; x++)
+      {
+        const uint32_t x0 = std::min(x * 2, width - 1);
+        const uint32_t x1 = std::min(x * 2 + 1, width - 1);
+        for (uint32_t c = 0; c < 4; c++)
+        {
+          const uint32_t sum =
+            in[(row0 + x0) * 4 + c] + in[(row0 + x1) * 4 + c] + in[(row1 + x0) * 4 + c] + in[(row1 + x1) * 4 + c];
+          out[(static_cast<size_t>(y) * newWidth + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+        }
+      }
+    }
+
+    return result;
+  }
+} // namespace Utility
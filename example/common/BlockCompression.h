@@ -0,0 +1,57 @@
+#pragma once
+#include <Fwog/BasicTypes.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Utility
+{
+  // Trades encoding time for quality. Each preset does everything the one before it does
+  enum class BcQuality
+  {
+    FAST,   // Color endpoints are the corners of the bounding box of each block's colors
+    NORMAL, // Color endpoints are the extremes of each block's colors along their principal axis
+    HIGH,   // Endpoints are refined with least squares to fit the chosen indices, and both BC4 modes are tried
+  };
+
+  // Block-compression for images that are only available as RGBA8 at runtime. Supported formats (and their sRGB
+  // variants, which are encoded identically) are:
+  // - BC1_RGB_UNORM: RGB, alpha is ignored
+  // - BC3_RGBA_UNORM: RGB like BC1 and alpha like BC4
+  // - BC4_R_UNORM: red
+  // - BC5_RG_UNORM: red and green, each like BC4
+  //
+  // Images are tightly packed RGBA8, with rows from top to bottom. Extents that aren't a multiple of four are padded by
+  // repeating the last row and column.
+
+  [[nodiscard]] bool IsBcEncodable(Fwog::Format format);
+
+  // The number of bytes needed to hold an encoded image
+  [[nodiscard]] size_t GetBcImageSize(Fwog::Format format, uint32_t width, uint32_t height);
+
+  void EncodeBc(Fwog::Format format,
+                std::span<const std::byte> rgba,
+                uint32_t width,
+                uint32_t height,
+                std::span<std::byte> output,
+                BcQuality quality);
+
+  // Decodes an image that was encoded by EncodeBc into RGBA8. Channels that the format doesn't store are set to 0,
+  // except alpha, which is set to 255
+  void DecodeBc(Fwog::Format format,
+                std::span<const std::byte> encoded,
+                uint32_t width,
+                uint32_t height,
+                std::span<std::byte> rgba);
+
+  // The peak signal-to-noise ratio in dB of the first channelCount channels of two RGBA8 images of the same size.
+  // Returns infinity if they're identical
+  [[nodiscard]] double ComputePsnr(std::span<const std::byte> reference,
+                                   std::span<const std::byte> test,
+                                   uint32_t channelCount);
+
+  // Halves each dimension of an RGBA8 image (rounding down, but not below one) with a box filter
+  [[nodiscard]] std::vector<std::byte> DownsampleRgba8(std::span<const std::byte> rgba, uint32_t width, uint32_t height);
+} // namespace Utility
@@ -0,0 +1,155 @@
+#include "ClusteredLighting.h"
+#include "Application.h"
+
+#include <Fwog/Rendering.h>
+#include <Fwog/Shader.h>
+
+#include <stb_include.h>
+
+#include <glm/matrix.hpp>
+
+#include <cstdlib>
+#include <string>
+
+static std::string LoadFileWithInclude(std::string_view path)
+{
+  char error[256] = {};
+  char* included = stb_include_string(Application::LoadFile(path).data(), nullptr, "shaders/clustered", "", error);
+  std::string includedStr = included;
+  free(included);
+  return includedStr;
+}
+
+static Fwog::ComputePipeline CreateMarkVisibleClustersPipeline()
+{
+  auto cs = Fwog::Shader(Fwog::PipelineStage::COMPUTE_SHADER,
+                         LoadFileWithInclude("shaders/clustered/MarkVisibleClusters.comp.glsl"));
+  return Fwog::ComputePipeline({.name = "Mark visible clusters", .shader = &cs});
+}
+
+static Fwog::ComputePipeline CreateCompactVisibleClustersPipeline()
+{
+  auto cs = Fwog::Shader(Fwog::PipelineStage::COMPUTE_SHADER,
+                         LoadFileWithInclude("shaders/clustered/CompactVisibleClusters.comp.glsl"));
+  return Fwog::ComputePipeline({.name = "Compact visible clusters", .shader = &cs});
+}
+
+static Fwog::ComputePipeline CreateCullLightsPipeline()
+{
+  auto cs =
+    Fwog::Shader(Fwog::PipelineStage::COMPUTE_SHADER, LoadFileWithInclude("shaders/clustered/CullLights.comp.glsl"));
+  return Fwog::ComputePipeline({.name = "Cull lights", .shader = &cs});
+}
+
+namespace Clustered
+{
+  ClusteredLighting::ClusteredLighting(uint32_t lightIndexCapacity)
+    : lightIndexCapacity(lightIndexCapacity),
+      uniformBuffer(Fwog::BufferStorageFlag::DYNAMIC_STORAGE),
+      clusterFlagsBuffer(clusterCount),
+      visibleClustersBuffer(clusterCount),
+      cullDispatchBuffer(Fwog::DispatchIndirectCommand{.groupCountX = 0, .groupCountY = 1, .groupCountZ = 1}),
+      clusterLightsBuffer(clusterCount),
+      lightIndexBuffer(sizeof(uint32_t) * (2 + static_cast<size_t>(lightIndexCapacity))),
+      markVisibleClustersPipeline(CreateMarkVisibleClustersPipeline()),
+      compactVisibleClustersPipeline(CreateCompactVisibleClustersPipeline()),
+      cullLightsPipeline(CreateCullLightsPipeline())
+  {
+  }
+
+  void ClusteredLighting::SetResolution(uint32_t newWidth, uint32_t newHeight)
+  {
+    width = newWidth;
+    height = newHeight;
+  }
+
+  void ClusteredLighting::CullLights(const glm::mat4& view,
+                                     const glm::mat4& proj,
+                                     float zNear,
+                                     float zFar,
+                                     const Fwog::Texture& depth,
+                                     const Fwog::Buffer& lightBuffer,
+                                     uint32_t lightCount)
+  {
+    uniformBuffer.UpdateData(ClusterUniforms{
+      .view = view,
+      .invProj = glm::inverse(proj),
+      .gridSize = {gridSizeX, gridSizeY, gridSizeZ},
+      .lightCount = lightCount,
+      .screenSize = {width, height},
+      .zNear = zNear,
+      .zFar = zFar,
+#ifdef FWOG_DEFAULT_CLIP_DEPTH_RANGE_ZERO_TO_ONE
+      .depthZeroToOne = true,
+#else
+      .depthZeroToOne = false,
+#endif
+      .lightIndexCapacity = lightIndexCapacity,
+    });
+
+    // Clusters that are not visible this frame keep an empty range, so stale lists are never read
+    clusterFlagsBuffer.ClearSubData({.internalFormat = Fwog::Format::R32_UINT});
+    clusterLightsBuffer.ClearSubData({.internalFormat = Fwog::Format::R32_UINT});
+    cullDispatchBuffer.ClearSubData({.offset = 0, .size = sizeof(uint32_t), .internalFormat = Fwog::Format::R32_UINT});
+    lightIndexBuffer.ClearSubData({.offset = 0, .size = 2 * sizeof(uint32_t), .internalFormat = Fwog::Format::R32_UINT});
+
+    auto nearestSampler = Fwog::Sampler({
+      .minFilter = Fwog::Filter::NEAREST,
+      .magFilter = Fwog::Filter::NEAREST,
+    });
+
+    Fwog::BeginCompute("Clustered light culling");
+    Fwog::Cmd::BindUniformBuffer(3, uniformBuffer);
+    Fwog::Cmd::BindStorageBuffer(0, lightBuffer);
+    Fwog::Cmd::BindStorageBuffer(1, clusterLightsBuffer);
+    Fwog::Cmd::BindStorageBuffer(2, lightIndexBuffer);
+    Fwog::Cmd::BindStorageBuffer(3, clusterFlagsBuffer);
+    Fwog::Cmd::BindStorageBuffer(4, visibleClustersBuffer);
+    Fwog::Cmd::BindStorageBuffer(5, cullDispatchBuffer);
+
+    Fwog::Cmd::BindComputePipeline(markVisibleClustersPipeline);
+    Fwog::Cmd::BindSampledImage(0, depth, nearestSampler);
+    Fwog::Cmd::DispatchInvocations(width, height, 1);
+
+    Fwog::MemoryBarrier(Fwog::MemoryBarrierBit::SHADER_STORAGE_BIT);
+    Fwog::Cmd::BindComputePipeline(compactVisibleClustersPipeline);
+    Fwog::Cmd::DispatchInvocations(clusterCount, 1, 1);
+
+    Fwog::MemoryBarrier(Fwog::MemoryBarrierBit::SHADER_STORAGE_BIT | Fwog::MemoryBarrierBit::COMMAND_BUFFER_BIT);
+    Fwog::Cmd::BindComputePipeline(cullLightsPipeline);
+    Fwog::Cmd::DispatchIndirect(cullDispatchBuffer, 0);
+    Fwog::EndCompute();
+
+    // Make the light lists visible to the shading pass and to the readback of the counters
+    Fwog::MemoryBarrier(Fwog::MemoryBarrierBit::SHADER_STORAGE_BIT | Fwog::MemoryBarrierBit::BUFFER_UPDATE_BIT);
+
+    UpdateStats();
+  }
+
+  void ClusteredLighting::BindForShading(const Fwog::Buffer& lightBuffer) const
+  {
+    Fwog::Cmd::BindUniformBuffer(3, uniformBuffer);
+    Fwog::Cmd::BindStorageBuffer(0, lightBuffer);
+    Fwog::Cmd::BindStorageBuffer(1, clusterLightsBuffer);
+    Fwog::Cmd::BindStorageBuffer(2, lightIndexBuffer);
+  }
+
+  void ClusteredLighting::UpdateStats()
+  {
+    if (pendingVisibleClusters && pendingVisibleClusters->IsReady() && pendingLightIndices->IsReady())
+    {
+      stats.visibleClusters = pendingVisibleClusters->DataAs<uint32_t>()[0];
+      stats.lightIndices = pendingLightIndices->DataAs<uint32_t>()[0];
+      stats.droppedLights = pendingLightIndices->DataAs<uint32_t>()[1];
+      pendingVisibleClusters.reset();
+      pendingLightIndices.reset();
+    }
+
+    // Only one readback is in flight at a time
+    if (!pendingVisibleClusters)
+    {
+      pendingVisibleClusters = Fwog::ReadbackBuffer(cullDispatchBuffer, 0, sizeof(uint32_t));
+      pendingLightIndices = Fwog::ReadbackBuffer(lightIndexBuffer, 0, 2 * sizeof(uint32_t));
+    }
+  }
+} // namespace Clustered
@@ -0,0 +1,107 @@
+#pragma once
+#include <Fwog/BasicTypes.h>
+#include <Fwog/Buffer.h>
+#include <Fwog/Pipeline.h>
+#include <Fwog/Readback.h>
+#include <Fwog/Texture.h>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <optional>
+
+namespace Clustered
+{
+  struct ClusteredLightingStats
+  {
+    uint32_t visibleClusters;
+    uint32_t lightIndices;
+
+    // Lights that intersect a cluster but were left out of its list, because the list was full or the shared light
+    // list ran out of space. Nonzero means that lighting is incorrect
+    uint32_t droppedLights;
+  };
+
+  // Clustered light culling for deferred shading.
+  //
+  // The view frustum is divided into a 16x9x24 grid of clusters that are exponentially distributed in depth. Each
+  // frame, after the depth buffer has been rendered:
+  // 1. MarkVisibleClusters flags every cluster that contains a pixel.
+  // 2. CompactVisibleClusters writes the indices of flagged clusters to a list, and counts them in an indirect dispatch
+  //    command.
+  // 3. CullLights builds a list of the lights that intersect each visible cluster, with one workgroup per cluster.
+  //
+  // Shaders that include shaders/clustered/Common.h.glsl can then find a pixel's lights with GetClusterIndex. The
+  // resources they need are bound with BindForShading.
+  //
+  // Lights are read from a storage buffer of structs with the layout {vec4 position; vec3 intensity; float invRadius;}.
+  class ClusteredLighting
+  {
+  public:
+    static constexpr uint32_t gridSizeX = 16;
+    static constexpr uint32_t gridSizeY = 9;
+    static constexpr uint32_t gridSizeZ = 24;
+    static constexpr uint32_t clusterCount = gridSizeX * gridSizeY * gridSizeZ;
+
+    // The maximum number of lights that can be assigned to a single cluster (must match CullLights.comp.glsl)
+    static constexpr uint32_t maxLightsPerCluster = 256;
+
+    // lightIndexCapacity: the size of the light list that is shared by all clusters
+    explicit ClusteredLighting(uint32_t lightIndexCapacity = clusterCount * 128);
+
+    void SetResolution(uint32_t newWidth, uint32_t newHeight);
+
+    // Input: the depth buffer of the scene and the projection (with any jitter) that it was rendered with
+    void CullLights(const glm::mat4& view,
+                    const glm::mat4& proj,
+                    float zNear,
+                    float zFar,
+                    const Fwog::Texture& depth,
+                    const Fwog::Buffer& lightBuffer,
+                    uint32_t lightCount);
+
+    // Binds the light buffer (storage buffer 0), per-cluster light ranges (storage buffer 1), light list
+    // (storage buffer 2), and cluster uniforms (uniform buffer 3) for a shading pass
+    void BindForShading(const Fwog::Buffer& lightBuffer) const;
+
+    // Gets the counts from a recent frame. The data is read back asynchronously, so it lags a few frames behind
+    [[nodiscard]] const ClusteredLightingStats& GetStats() const
+    {
+      return stats;
+    }
+
+  private:
+    struct ClusterUniforms
+    {
+      glm::mat4 view;
+      glm::mat4 invProj;
+      glm::uvec3 gridSize;
+      uint32_t lightCount;
+      glm::uvec2 screenSize;
+      float zNear;
+      float zFar;
+      uint32_t depthZeroToOne;
+      uint32_t lightIndexCapacity;
+    };
+
+    void UpdateStats();
+
+    uint32_t lightIndexCapacity;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    Fwog::TypedBuffer<ClusterUniforms> uniformBuffer;
+    Fwog::TypedBuffer<uint32_t> clusterFlagsBuffer;
+    Fwog::TypedBuffer<uint32_t> visibleClustersBuffer;
+    Fwog::TypedBuffer<Fwog::DispatchIndirectCommand> cullDispatchBuffer;
+    Fwog::TypedBuffer<glm::uvec2> clusterLightsBuffer;
+    Fwog::Buffer lightIndexBuffer; // uint lightIndexCount, droppedLightCount; uint lightIndices[lightIndexCapacity];
+    Fwog::ComputePipeline markVisibleClustersPipeline;
+    Fwog::ComputePipeline compactVisibleClustersPipeline;
+    Fwog::ComputePipeline cullLightsPipeline;
+    std::optional<Fwog::ReadbackResult> pendingVisibleClusters;
+    std::optional<Fwog::ReadbackResult> pendingLightIndices;
+    ClusteredLightingStats stats{};
+  };
+} // namespace Clustered
@@ -0,0 +1,147 @@
+#include "DepthPyramid.h"
+#include "Application.h"
+
+#include <Fwog/Context.h>
+#include <Fwog/Rendering.h>
+#include <Fwog/Shader.h>
+
+#include <algorithm>
+#include <bit>
+#include <string>
+
+// Each workgroup reduces a tile of this many texels into the next LEVELS_PER_TILE levels
+static constexpr uint32_t TILE_SIZE = 64;
+static constexpr uint32_t LEVELS_PER_TILE = 6;
+
+// A tile of level 0 and a tile of level 6 cover a pyramid whose level 0 is 4096x4096
+static constexpr uint32_t MAX_SINGLE_PASS_LEVELS = 2 * LEVELS_PER_TILE + 1;
+
+static bool SupportsSinglePass()
+{
+  const auto& limits = Fwog::GetDeviceProperties().limits;
+  const auto required = static_cast<int32_t>(MAX_SINGLE_PASS_LEVELS);
+  return limits.maxImageUnits >= required && limits.maxCombinedImageUniforms >= required;
+}
+
+static Fwog::ComputePipeline CreateDepthPyramidPipeline(Utility::DepthReduction reduction, bool singlePass)
+{
+  std::string defines;
+  switch (reduction)
+  {
+  case Utility::DepthReduction::MIN: defines += "#define REDUCE_MIN\n"; break;
+  case Utility::DepthReduction::MAX: defines += "#define REDUCE_MAX\n"; break;
+  case Utility::DepthReduction::MIN_MAX: defines += "#define REDUCE_MIN_MAX\n"; break;
+  }
+  defines += singlePass ? "#define SINGLE_PASS 1\n" : "#define SINGLE_PASS 0\n";
+
+  // Defines must come after the #version directive
+  auto source = Application::LoadFile("shaders/DepthPyramid.comp.glsl");
+  source.insert(source.find('\n') + 1, defines);
+
+  auto cs = Fwog::Shader(Fwog::PipelineStage::COMPUTE_SHADER, source);
+  return Fwog::ComputePipeline({.name = singlePass ? "Depth pyramid (single pass)" : "Depth pyramid", .shader = &cs});
+}
+
+namespace Utility
+{
+  DepthPyramid::DepthPyramid(DepthReduction reduction)
+    : reduction(reduction),
+      multiPassPipeline(CreateDepthPyramidPipeline(reduction, false)),
+      counterBuffer(Fwog::BufferStorageFlag::NONE)
+  {
+    if (SupportsSinglePass())
+    {
+      singlePassPipeline = CreateDepthPyramidPipeline(reduction, true);
+    }
+
+    // The shader resets the counter after every build
+    counterBuffer.ClearSubData({.internalFormat = Fwog::Format::R32_UINT});
+  }
+
+  void DepthPyramid::SetResolution(uint32_t depthWidth, uint32_t depthHeight)
+  {
+    depthSize = {depthWidth, depthHeight};
+
+    const auto extent = Fwog::Extent2D{std::bit_ceil(depthWidth), std::bit_ceil(depthHeight)};
+    const uint32_t levels = std::bit_width(std::max(extent.width, extent.height));
+    const auto format = reduction == DepthReduction::MIN_MAX ? Fwog::Format::R32G32_FLOAT : Fwog::Format::R32_FLOAT;
+    pyramid = Fwog::CreateTexture2DMip(extent, format, levels, "Depth pyramid");
+
+    auto workgroupsForLevel = [extent](uint32_t level)
+    {
+      return Fwog::Extent2D{
+        (std::max(extent.width >> level, 1u) + TILE_SIZE - 1) / TILE_SIZE,
+        (std::max(extent.height >> level, 1u) + TILE_SIZE - 1) / TILE_SIZE,
+      };
+    };
+
+    passes.clear();
+    if (singlePassPipeline && levels <= MAX_SINGLE_PASS_LEVELS)
+    {
+      passes.push_back({.baseLevel = 0, .levelCount = levels, .workgroups = workgroupsForLevel(0)});
+    }
+    else
+    {
+      // Each dispatch reads the last level written by the previous one
+      uint32_t baseLevel = 0;
+      do
+      {
+        const uint32_t levelCount = std::min(LEVELS_PER_TILE + 1, levels - baseLevel);
+        passes.push_back({
+          .baseLevel = baseLevel,
+          .levelCount = levelCount,
+          .workgroups = workgroupsForLevel(baseLevel),
+        });
+        baseLevel += LEVELS_PER_TILE;
+      } while (baseLevel + 1 < levels);
+    }
+
+    // The uniforms only depend on the resolution, so each pass's are written once to an aligned slot
+    const auto alignment = static_cast<uint32_t>(Fwog::GetDeviceProperties().limits.uniformBufferOffsetAlignment);
+    uniformStride = (static_cast<uint32_t>(sizeof(PassUniforms)) + alignment - 1) / alignment * alignment;
+    uniformBuffer = Fwog::Buffer(uniformStride * passes.size(), Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
+    for (size_t i = 0; i < passes.size(); i++)
+    {
+      const auto& pass = passes[i];
+      uniformBuffer->UpdateData(PassUniforms{
+                                  .depthSize = glm::ivec2(depthSize),
+                                  .readDepth = pass.baseLevel == 0,
+                                  .levelCount = pass.levelCount,
+                                  .workgroupCount = pass.workgroups.width * pass.workgroups.height,
+                                },
+                                i * uniformStride);
+    }
+  }
+
+  void DepthPyramid::Build(const Fwog::Texture& depth)
+  {
+    auto nearestSampler = Fwog::Sampler({
+      .minFilter = Fwog::Filter::NEAREST,
+      .magFilter = Fwog::Filter::NEAREST,
+      .mipmapFilter = Fwog::Filter::NEAREST,
+    });
+
+    const bool isSinglePass = singlePassPipeline && passes.size() == 1 && passes[0].levelCount > LEVELS_PER_TILE + 1;
+
+    Fwog::BeginCompute("Build depth pyramid");
+    Fwog::Cmd::BindComputePipeline(isSinglePass ? *singlePassPipeline : multiPassPipeline);
+    Fwog::Cmd::BindSampledImage(0, depth, nearestSampler);
+    Fwog::Cmd::BindStorageBuffer(0, counterBuffer);
+    for (size_t i = 0; i < passes.size(); i++)
+    {
+      const auto& pass = passes[i];
+      if (i > 0)
+      {
+        Fwog::MemoryBarrier(Fwog::MemoryBarrierBit::IMAGE_ACCESS_BIT);
+      }
+
+      Fwog::Cmd::BindUniformBuffer(0, *uniformBuffer, i * uniformStride, sizeof(PassUniforms));
+      for (uint32_t level = 0; level < pass.levelCount; level++)
+      {
+        Fwog::Cmd::BindImage(level, *pyramid, pass.baseLevel + level);
+      }
+      Fwog::Cmd::Dispatch(pass.workgroups.width, pass.workgroups.height, 1);
+    }
+    Fwog::EndCompute();
+  }
+} // namespace Utility
@@ -0,0 +1,86 @@
+#pragma once
+#include <Fwog/Buffer.h>
+#include <Fwog/Pipeline.h>
+#include <Fwog/Texture.h>
+
+#include <glm/vec2.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace Utility
+{
+  // The depth that each texel of a depth pyramid stores for the texels it covers
+  enum class DepthReduction
+  {
+    MIN,     // R32_FLOAT
+    MAX,     // R32_FLOAT
+    MIN_MAX, // R32G32_FLOAT (x = min, y = max)
+  };
+
+  // Builds a full mip chain of a depth buffer on the GPU, where each texel stores the min and/or max of its footprint.
+  //
+  // Level 0 is a copy of the depth buffer, padded to a power-of-two extent so that every texel of level n covers
+  // exactly 2^n x 2^n pixels. This means that a pixel's texel in level n is always pixel >> n.
+  //
+  // When the device has enough image units to bind 13 levels at once, the pyramid is built in a single dispatch: each
+  // workgroup reduces a 64x64 tile through six levels in shared memory, and the last workgroup to finish reduces the
+  // rest. Otherwise, one dispatch is issued for every six levels.
+  class DepthPyramid
+  {
+  public:
+    explicit DepthPyramid(DepthReduction reduction = DepthReduction::MAX);
+
+    void SetResolution(uint32_t depthWidth, uint32_t depthHeight);
+
+    void Build(const Fwog::Texture& depth);
+
+    [[nodiscard]] const Fwog::Texture& GetTexture() const
+    {
+      return pyramid.value();
+    }
+
+    // Gets the extent of the depth buffer that the pyramid was created for, which may be smaller than level 0
+    [[nodiscard]] glm::uvec2 GetDepthSize() const
+    {
+      return depthSize;
+    }
+
+    [[nodiscard]] uint32_t GetLevelCount() const
+    {
+      return pyramid->GetCreateInfo().mipLevels;
+    }
+
+    [[nodiscard]] uint32_t GetDispatchCount() const
+    {
+      return static_cast<uint32_t>(passes.size());
+    }
+
+  private:
+    struct PassUniforms
+    {
+      glm::ivec2 depthSize;
+      uint32_t readDepth;
+      uint32_t levelCount;
+      uint32_t workgroupCount;
+    };
+
+    struct Pass
+    {
+      uint32_t baseLevel;
+      uint32_t levelCount;
+      Fwog::Extent2D workgroups;
+    };
+
+    DepthReduction reduction;
+    std::optional<Fwog::ComputePipeline> singlePassPipeline;
+    Fwog::ComputePipeline multiPassPipeline;
+    Fwog::TypedBuffer<uint32_t> counterBuffer;
+    std::optional<Fwog::Buffer> uniformBuffer;
+    uint32_t uniformStride = 0;
+    std::vector<Pass> passes;
+    glm::uvec2 depthSize{};
+    std::optional<Fwog::Texture> pyramid;
+  };
+} // namespace Utility
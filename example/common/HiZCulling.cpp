@@ -0,0 +1,127 @@
+#include "HiZCulling.h"
+#include "Application.h"
+
+#include <Fwog/Rendering.h>
+#include <Fwog/Shader.h>
+
+#include <vector>
+
+static Fwog::ComputePipeline CreateCullPipeline()
+{
+  auto cs = Fwog::Shader(Fwog::PipelineStage::COMPUTE_SHADER, Application::LoadFile("shaders/culling/Cull.comp.glsl"));
+  return Fwog::ComputePipeline({.name = "Cull objects", .shader = &cs});
+}
+
+static std::vector<Fwog::DrawIndexedIndirectCommand> MakeSourceCommands(std::span<const Utility::MeshBindless> meshes)
+{
+  std::vector<Fwog::DrawIndexedIndirectCommand> commands;
+  commands.reserve(meshes.size());
+  for (const auto& mesh : meshes)
+  {
+    commands.push_back({
+      .indexCount = mesh.indexCount,
+      .instanceCount = 0,
+      .firstIndex = mesh.startIndex,
+      .vertexOffset = mesh.startVertex,
+      .firstInstance = 0,
+    });
+  }
+  return commands;
+}
+
+namespace Culling
+{
+  HiZCuller::HiZCuller(std::span<const Utility::MeshBindless> meshes)
+    : objectCount(static_cast<uint32_t>(meshes.size())),
+      objectsBuffer(MakeCullObjects(meshes)),
+      sourceCommandsBuffer(MakeSourceCommands(meshes)),
+      visibilityBuffer(meshes.size()),
+      earlyUniformBuffer(Fwog::BufferStorageFlag::DYNAMIC_STORAGE),
+      lateUniformBuffer(Fwog::BufferStorageFlag::DYNAMIC_STORAGE),
+      earlyDrawList(objectCount),
+      lateDrawList(objectCount),
+      cullPipeline(CreateCullPipeline()),
+      depthPyramid(Utility::DepthReduction::MAX)
+  {
+    // Nothing was visible before the first frame, so everything is drawn by the late phase
+    visibilityBuffer.ClearSubData({.internalFormat = Fwog::Format::R32_UINT});
+  }
+
+  std::vector<HiZCuller::CullObject> HiZCuller::MakeCullObjects(std::span<const Utility::MeshBindless> meshes)
+  {
+    std::vector<CullObject> objects;
+    objects.reserve(meshes.size());
+    for (const auto& mesh : meshes)
+    {
+      objects.push_back({
+        .model = mesh.transform,
+        .boxOffset = glm::vec4(mesh.boundingBox.offset, 0),
+        .boxHalfExtent = glm::vec4(mesh.boundingBox.halfExtent, 0),
+      });
+    }
+    return objects;
+  }
+
+  void HiZCuller::SetResolution(uint32_t newWidth, uint32_t newHeight)
+  {
+    depthPyramid.SetResolution(newWidth, newHeight);
+  }
+
+  void HiZCuller::CullEarly(const glm::mat4& viewProj)
+  {
+    Cull(viewProj, false, earlyUniformBuffer, earlyDrawList);
+  }
+
+  void HiZCuller::BuildHiZ(const Fwog::Texture& depth)
+  {
+    depthPyramid.Build(depth);
+  }
+
+  void HiZCuller::CullLate(const glm::mat4& viewProj)
+  {
+    Cull(viewProj, true, lateUniformBuffer, lateDrawList);
+  }
+
+  void HiZCuller::Cull(const glm::mat4& viewProj,
+                       bool isLatePhase,
+                       Fwog::TypedBuffer<CullingUniforms>& uniformBuffer,
+                       Fwog::IndirectDrawList<Fwog::DrawIndexedIndirectCommand>& drawList)
+  {
+    uniformBuffer.UpdateData(CullingUniforms{
+      .viewProj = viewProj,
+      .depthSize = depthPyramid.GetDepthSize(),
+      .hizLevels = depthPyramid.GetLevelCount(),
+      .objectCount = objectCount,
+      .isLatePhase = isLatePhase,
+#ifdef FWOG_DEFAULT_CLIP_DEPTH_RANGE_ZERO_TO_ONE
+      .depthZeroToOne = true,
+#else
+      .depthZeroToOne = false,
+#endif
+      .frustumCulling = frustumCulling,
+      .occlusionCulling = occlusionCulling,
+    });
+
+    drawList.Reset();
+
+    auto nearestSampler = Fwog::Sampler({
+      .minFilter = Fwog::Filter::NEAREST,
+      .magFilter = Fwog::Filter::NEAREST,
+      .mipmapFilter = Fwog::Filter::NEAREST,
+    });
+
+    Fwog::BeginCompute(isLatePhase ? "Cull objects (late)" : "Cull objects (early)");
+    // Make the previous phase's writes to the visibility buffer and Hi-Z visible
+    Fwog::MemoryBarrier(Fwog::MemoryBarrierBit::SHADER_STORAGE_BIT | Fwog::MemoryBarrierBit::TEXTURE_FETCH_BIT);
+    Fwog::Cmd::BindComputePipeline(cullPipeline);
+    Fwog::Cmd::BindUniformBuffer(0, uniformBuffer);
+    Fwog::Cmd::BindSampledImage(0, depthPyramid.GetTexture(), nearestSampler);
+    Fwog::Cmd::BindStorageBuffer(0, objectsBuffer);
+    Fwog::Cmd::BindStorageBuffer(1, sourceCommandsBuffer);
+    Fwog::Cmd::BindStorageBuffer(2, visibilityBuffer);
+    Fwog::Cmd::BindStorageBuffer(3, drawList.GetCommandBuffer());
+    Fwog::Cmd::BindStorageBuffer(4, drawList.GetCountBuffer());
+    Fwog::Cmd::DispatchInvocations(objectCount, 1, 1);
+    Fwog::EndCompute();
+  }
+} // namespace Culling
@@ -0,0 +1,103 @@
+#pragma once
+#include "DepthPyramid.h"
+#include "SceneLoader.h"
+
+#include <Fwog/Buffer.h>
+#include <Fwog/IndirectDrawList.h>
+#include <Fwog/Pipeline.h>
+#include <Fwog/Texture.h>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Culling
+{
+  // Frustum and Hi-Z occlusion culling of bindless meshes on the GPU.
+  //
+  // Culling is split into two phases to avoid the one-frame lag of testing against the previous frame's depth:
+  // 1. CullEarly: objects that were visible last frame and are in the frustum are written to the early draw list,
+  //    which the application draws to produce a partial depth buffer.
+  // 2. BuildHiZ: a Utility::DepthPyramid storing the farthest depth of each texel's footprint is built from that depth
+  //    buffer.
+  // 3. CullLate: every object in the frustum is tested against the pyramid. Visible objects that were not drawn in the
+  //    early phase are written to the late draw list, which the application draws on top. The result is used as the
+  //    next frame's visibility.
+  //
+  // The draw commands' first instance is set to the index of the mesh, which shaders should use (via
+  // gl_BaseInstance) to fetch per-object data instead of gl_DrawID.
+  class HiZCuller
+  {
+  public:
+    explicit HiZCuller(std::span<const Utility::MeshBindless> meshes);
+
+    void SetResolution(uint32_t newWidth, uint32_t newHeight);
+
+    void CullEarly(const glm::mat4& viewProj);
+
+    // Input: the depth buffer produced by drawing the early draw list
+    void BuildHiZ(const Fwog::Texture& depth);
+
+    void CullLate(const glm::mat4& viewProj);
+
+    [[nodiscard]] const Fwog::IndirectDrawList<Fwog::DrawIndexedIndirectCommand>& GetEarlyDrawList() const
+    {
+      return earlyDrawList;
+    }
+
+    [[nodiscard]] const Fwog::IndirectDrawList<Fwog::DrawIndexedIndirectCommand>& GetLateDrawList() const
+    {
+      return lateDrawList;
+    }
+
+    [[nodiscard]] const Fwog::Texture& GetHiZ() const
+    {
+      return depthPyramid.GetTexture();
+    }
+
+    bool frustumCulling = true;
+    bool occlusionCulling = true;
+
+  private:
+    struct CullObject
+    {
+      glm::mat4 model;
+      glm::vec4 boxOffset;
+      glm::vec4 boxHalfExtent;
+    };
+
+    struct CullingUniforms
+    {
+      glm::mat4 viewProj;
+      glm::uvec2 depthSize;
+      uint32_t hizLevels;
+      uint32_t objectCount;
+      uint32_t isLatePhase;
+      uint32_t depthZeroToOne;
+      uint32_t frustumCulling;
+      uint32_t occlusionCulling;
+    };
+
+    static std::vector<CullObject> MakeCullObjects(std::span<const Utility::MeshBindless> meshes);
+
+    void Cull(const glm::mat4& viewProj,
+              bool isLatePhase,
+              Fwog::TypedBuffer<CullingUniforms>& uniformBuffer,
+              Fwog::IndirectDrawList<Fwog::DrawIndexedIndirectCommand>& drawList);
+
+    uint32_t objectCount;
+    Fwog::TypedBuffer<CullObject> objectsBuffer;
+    Fwog::TypedBuffer<Fwog::DrawIndexedIndirectCommand> sourceCommandsBuffer;
+    Fwog::TypedBuffer<uint32_t> visibilityBuffer;
+    Fwog::TypedBuffer<CullingUniforms> earlyUniformBuffer;
+    Fwog::TypedBuffer<CullingUniforms> lateUniformBuffer;
+    Fwog::IndirectDrawList<Fwog::DrawIndexedIndirectCommand> earlyDrawList;
+    Fwog::IndirectDrawList<Fwog::DrawIndexedIndirectCommand> lateDrawList;
+    Fwog::ComputePipeline cullPipeline;
+    Utility::DepthPyramid depthPyramid;
+  };
+} // namespace Culling
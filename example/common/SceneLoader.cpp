@@ -1,7 +1,11 @@
 #include "SceneLoader.h"
+#include "TextureCache.h"
+#include <Fwog/MemoryUsage.h>
 #include <iostream>
 #include <numeric>
-#include <execution>
+#include <atomic>
+#include <thread>
+#include <stop_token>
 #include <stack>
 #include <tuple>
 #include <optional>
@@ -35,6 +39,12 @@ namespace Utility
 {
   namespace // helpers
   {
+    // Most glTF scenes fit in a single block of this size. Larger meshes get a dedicated block
+    constexpr uint64_t geometryHeapBlockSize = 64 * 1024 * 1024;
+
+    std::filesystem::path textureCacheDirectory = "texture_cache";
+    std::optional<BcQuality> imageCompression;
+
     class Timer
     {
       using microsecond_t = std::chrono::microseconds;
@@ -122,6 +132,13 @@ namespace Utility
       return Fwog::Texture(Fwog::TextureCreateInfo{});
     }
 
+    struct EncodeStats
+    {
+      uint64_t pixels;
+      double seconds;
+      double psnr;
+    };
+
     struct RawImageData
     {
       // Used for ktx and non-ktx images alike
@@ -142,6 +159,20 @@ namespace Utility
       // ktx
       std::unique_ptr<ktxTexture2, decltype([](ktxTexture2* p) { ktxTexture_Destroy(ktxTexture(p)); })> ktx = {};
 
+      // Set if the image was found in the texture cache, in which case it wasn't decoded
+      std::optional<TextureCacheEntry> cached;
+
+      // The time it took to decode or transcode the image, if it wasn't cached. Block compression is in encodeStats
+      std::optional<double> decodeSeconds;
+
+      // Non-ktx images that were block-compressed after decoding. Holds every level
+      std::unique_ptr<std::byte[]> compressedData = {};
+      std::optional<EncodeStats> encodeStats;
+
+      // What is uploaded, regardless of where it came from. Points into data, ktx, cached, or compressedData
+      Fwog::Format format = Fwog::Format::UNDEFINED;
+      std::vector<std::span<const std::byte>> levels;
+
       //std::optional<Fwog::Texture> texture;
     };
 
@@ -173,46 +204,262 @@ namespace Utility
       return true;
     }
 
-    bool LoadImageDataParallel(std::span<RawImageData> rawImageData)
+    struct DecodeSettings
+    {
+      const TextureCache* cache = nullptr;
+
+      // If set, non-KTX images are block-compressed with BC3 if they have alpha, and BC1 otherwise
+      std::optional<BcQuality> compression;
+    };
+
+    // The formats an image may be uploaded in. Block-compressed images have one of two, as whether they have alpha is
+    // only known once they're decoded
+    std::span<const Fwog::Format> GetCandidateFormats(const RawImageData& image, const DecodeSettings& settings)
+    {
+      static constexpr Fwog::Format ktxFormats[] = {Fwog::Format::BC7_RGBA_UNORM};
+      static constexpr Fwog::Format rgbaFormats[] = {Fwog::Format::R8G8B8A8_UNORM};
+      static constexpr Fwog::Format bcFormats[] = {Fwog::Format::BC1_RGB_UNORM, Fwog::Format::BC3_RGBA_UNORM};
+
+      if (image.isKtx)
+      {
+        return ktxFormats;
+      }
+      return settings.compression ? bcFormats : rgbaFormats;
+    }
+
+    // Generates the mip chain of a decoded image on the CPU and block-compresses every level
+    void CompressImage(RawImageData& image, BcQuality quality)
+    {
+      Timer timer;
+
+      auto width = static_cast<uint32_t>(image.width);
+      auto height = static_cast<uint32_t>(image.height);
+      const auto baseLevel = std::as_bytes(std::span(image.data.get(), static_cast<size_t>(width) * height * 4));
+
+      bool hasAlpha = false;
+      for (size_t i = 3; i < baseLevel.size() && !hasAlpha; i += 4)
+      {
+        hasAlpha = baseLevel[i] != std::byte{255};
+      }
+      image.format = hasAlpha ? Fwog::Format::BC3_RGBA_UNORM : Fwog::Format::BC1_RGB_UNORM;
+
+      // The levels share one allocation, and are stored contiguously like they are in a KTX file
+      std::vector<size_t> levelOffsets;
+      size_t totalSize = 0;
+      for (uint32_t w = width, h = height;; w = std::max(w / 2, 1u), h = std::max(h / 2, 1u))
+      {
+        levelOffsets.push_back(totalSize);
+        totalSize += GetBcImageSize(image.format, w, h);
+        if (w == 1 && h == 1)
+        {
+          break;
+        }
+      }
+      image.compressedData = std::make_unique<std::byte[]>(totalSize);
+
+      uint64_t pixelCount = 0;
+      std::vector<std::byte> mip;
+      auto level = baseLevel;
+      for (size_t i = 0; i < levelOffsets.size(); i++)
+      {
+        const auto size = GetBcImageSize(image.format, width, height);
+        const auto encoded = std::span(image.compressedData.get() + levelOffsets[i], size);
+        EncodeBc(image.format, level, width, height, encoded, quality);
+        image.levels.push_back(encoded);
+        pixelCount += static_cast<uint64_t>(width) * height;
+
+        if (i + 1 < levelOffsets.size())
+        {
+          mip = DownsampleRgba8(level, width, height);
+          level = mip;
+          width = std::max(width / 2, 1u);
+          height = std::max(height / 2, 1u);
+        }
+      }
+
+      const double seconds = timer.Elapsed_us() / 1e6;
+
+      // Measure the quality of the base level, which is most of the data
+      std::vector<std::byte> decoded(baseLevel.size());
+      DecodeBc(image.format,
+               image.levels[0],
+               static_cast<uint32_t>(image.width),
+               static_cast<uint32_t>(image.height),
+               decoded);
+
+      image.encodeStats = EncodeStats{
+        .pixels = pixelCount,
+        .seconds = seconds,
+        .psnr = ComputePsnr(baseLevel, decoded, hasAlpha ? 4 : 3),
+      };
+
+      image.data.reset();
+    }
+
+    // Decodes a PNG or JPEG image, or creates a KTX2 texture and transcodes it to BC7 if it is supercompressed. If there
+    // is a cache, the result is read from or added to it
+    bool DecodeImage(RawImageData& rawImage, const DecodeSettings& settings)
     {
-      return std::all_of(std::execution::seq, rawImageData.begin(), rawImageData.end(), [&](RawImageData& rawImage)
+      uint64_t hash{};
+      if (settings.cache)
       {
-        if (rawImage.isKtx)
+        hash = TextureCache::Hash(std::as_bytes(std::span(rawImage.encodedPixelData.get(), rawImage.encodedPixelSize)));
+        if (!rawImage.isKtx && settings.compression)
         {
-          ktxTexture2* ktx{};
-          if (auto result = ktxTexture2_CreateFromMemory(rawImage.encodedPixelData.get(),
-                                                         rawImage.encodedPixelSize,
-                                                         KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
-                                                         &ktx); result != KTX_SUCCESS)
+          hash = TextureCache::Hash(std::as_bytes(std::span(&*settings.compression, 1)), hash);
+        }
+
+        for (auto format : GetCandidateFormats(rawImage, settings))
+        {
+          if (auto entry = settings.cache->Load(hash, format))
           {
-            return false;
+            rawImage.format = format;
+            rawImage.width = static_cast<int>(entry->width);
+            rawImage.height = static_cast<int>(entry->height);
+            rawImage.components = 4;
+            rawImage.levels = entry->levels;
+            rawImage.cached = std::move(entry);
+            return true;
           }
-          
-          rawImage.width = ktx->baseWidth;
-          rawImage.height = ktx->baseHeight;
-          rawImage.components = ktxTexture2_GetNumComponents(ktx);
-          rawImage.ktx.reset(ktx);
         }
-        else
+      }
+
+      // Each image has exactly one GPU format, unless it is compressed here
+      rawImage.format = GetCandidateFormats(rawImage, settings)[0];
+
+      Timer timer;
+
+      if (rawImage.isKtx)
+      {
+        ktxTexture2* ktx{};
+        if (auto result = ktxTexture2_CreateFromMemory(rawImage.encodedPixelData.get(),
+                                                       rawImage.encodedPixelSize,
+                                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                                       &ktx); result != KTX_SUCCESS)
         {
-          int x, y, comp;
-          auto* pixels = stbi_load_from_memory(rawImage.encodedPixelData.get(), rawImage.encodedPixelSize, &x, &y, &comp, 4);
-          if (!pixels)
+          return false;
+        }
+
+        rawImage.ktx.reset(ktx);
+
+        if (ktxTexture2_NeedsTranscoding(ktx))
+        {
+          if (auto result = ktxTexture2_TranscodeBasis(ktx, KTX_TTF_BC7_RGBA, KTX_TF_HIGH_QUALITY); result != KTX_SUCCESS)
           {
             return false;
           }
+        }
 
-          rawImage.width = x;
-          rawImage.height = y;
-          //rawImage.components = comp;
-          rawImage.components = 4; // If forced 4 components
-          rawImage.data.reset(pixels);
+        rawImage.width = ktx->baseWidth;
+        rawImage.height = ktx->baseHeight;
+        rawImage.components = ktxTexture2_GetNumComponents(ktx);
+
+        for (uint32_t level = 0; level < ktx->numLevels; level++)
+        {
+          size_t offset{};
+          ktxTexture_GetImageOffset(ktxTexture(ktx), level, 0, 0, &offset);
+          rawImage.levels.emplace_back(reinterpret_cast<const std::byte*>(ktx->pData + offset),
+                                       ktxTexture_GetImageSize(ktxTexture(ktx), level));
         }
 
-        return true;
-      });
+        rawImage.decodeSeconds = timer.Elapsed_us() / 1e6;
+      }
+      else
+      {
+        int x, y, comp;
+        auto* pixels = stbi_load_from_memory(rawImage.encodedPixelData.get(), rawImage.encodedPixelSize, &x, &y, &comp, 4);
+        if (!pixels)
+        {
+          return false;
+        }
+
+        rawImage.width = x;
+        rawImage.height = y;
+        //rawImage.components = comp;
+        rawImage.components = 4; // If forced 4 components
+        rawImage.data.reset(pixels);
+        rawImage.decodeSeconds = timer.Elapsed_us() / 1e6;
+
+        if (settings.compression)
+        {
+          CompressImage(rawImage, *settings.compression);
+        }
+        else
+        {
+          // The rest of the mip chain is generated on the GPU
+          rawImage.levels.emplace_back(reinterpret_cast<const std::byte*>(pixels), static_cast<size_t>(x) * y * 4);
+        }
+      }
+
+      if (settings.cache)
+      {
+        settings.cache->Store(hash,
+                              rawImage.format,
+                              static_cast<uint32_t>(rawImage.width),
+                              static_cast<uint32_t>(rawImage.height),
+                              rawImage.levels);
+      }
+
+      return true;
     }
 
+    // Decodes images on worker threads. Each worker takes the next image that hasn't been started, so images finish
+    // roughly in order and the main thread can upload each one as soon as it's ready instead of waiting for all of them
+    class ParallelImageDecoder
+    {
+    public:
+      // Only the images at indices are decoded, in that order
+      ParallelImageDecoder(std::span<RawImageData> images, std::vector<size_t> indices, DecodeSettings settings)
+        : images_(images),
+          indices_(std::move(indices)),
+          settings_(settings),
+          statuses_(std::make_unique<std::atomic<Status>[]>(images.size()))
+      {
+        // The main thread is busy uploading the decoded images
+        const auto threadCount =
+          std::min<size_t>(std::max(std::thread::hardware_concurrency(), 2u) - 1, indices_.size());
+        for (size_t i = 0; i < threadCount; i++)
+        {
+          workers_.emplace_back([this](std::stop_token stopToken) { Work(stopToken); });
+        }
+      }
+
+      // Blocks until an image has been decoded. Returns false if it couldn't be. The image must be one of the indices
+      // that were passed to the constructor
+      bool Wait(size_t index)
+      {
+        statuses_[index].wait(Status::PENDING);
+        return statuses_[index].load() == Status::DECODED;
+      }
+
+    private:
+      enum class Status
+      {
+        PENDING,
+        DECODED,
+        FAILED,
+      };
+
+      void Work(std::stop_token stopToken)
+      {
+        for (size_t i = next_++; i < indices_.size() && !stopToken.stop_requested(); i = next_++)
+        {
+          const auto index = indices_[i];
+          statuses_[index] = DecodeImage(images_[index], settings_) ? Status::DECODED : Status::FAILED;
+          statuses_[index].notify_all();
+        }
+      }
+
+      std::span<RawImageData> images_;
+      std::vector<size_t> indices_;
+      DecodeSettings settings_;
+      std::unique_ptr<std::atomic<Status>[]> statuses_;
+      std::atomic<size_t> next_ = 0;
+
+      // Declared last so the workers are stopped and joined before anything they use is destroyed
+      std::vector<std::jthread> workers_;
+    };
+
     glm::mat4 NodeToMat4(const tinygltf::Node& node)
     {
       glm::mat4 transform{ 1 };
@@ -428,119 +675,205 @@ namespace Utility
     return indices;
   }
 
-  std::pair<std::vector<Fwog::Texture>, std::vector<Fwog::SamplerState>> LoadTextureSamplers(const tinygltf::Model& model, std::span<const RawImageData> images)
+  // glTF textures are pairs of an image and a sampler, and many of them can share an image. Each image is uploaded once
+  // (in the format it is transcoded to), and identical samplers are merged
+  struct LoadedTextures
   {
-    std::vector<Fwog::Texture> textures;
+    std::vector<Fwog::Texture> images;
     std::vector<Fwog::SamplerState> samplers;
 
-    for (const auto& texture : model.textures)
+    // Indices into images and samplers for each glTF texture
+    std::vector<std::pair<uint32_t, uint32_t>> textures;
+
+    // The number of images that were read from the texture cache instead of being decoded
+    uint32_t cachedImages = 0;
+
+    // Totals for the images that were decoded or transcoded by this load, excluding block compression and uploads
+    uint32_t decodedImages = 0;
+    uint64_t decodedPixels = 0;
+    double decodeSeconds = 0;
+
+    // Totals for the images that were block-compressed by this load
+    uint32_t encodedImages = 0;
+    uint64_t encodedPixels = 0;
+    double encodeSeconds = 0;
+    double psnrSum = 0;
+  };
+
+  Fwog::Format GetSrgbFormat(Fwog::Format format)
+  {
+    switch (format)
     {
-      int textureSource = texture.source;
-      if (auto it = texture.extensions.find("KHR_texture_basisu"); it != texture.extensions.end())
-      {
-        struct Hack : tinygltf::Value
-        {
-          Hack(const tinygltf::Value& basisuExtension)
-            : Value(basisuExtension) {}
+    case Fwog::Format::R8G8B8A8_UNORM: return Fwog::Format::R8G8B8A8_SRGB;
+    case Fwog::Format::BC1_RGB_UNORM: return Fwog::Format::BC1_RGB_SRGB;
+    case Fwog::Format::BC3_RGBA_UNORM: return Fwog::Format::BC3_RGBA_SRGB;
+    case Fwog::Format::BC7_RGBA_UNORM: return Fwog::Format::BC7_RGBA_SRGB;
+    default: FWOG_UNREACHABLE; return format;
+    }
+  }
 
-          int GetTextureSource() const
-          {
-            return this->object_value_.at("source").GetNumberAsInt();
-          }
-        };
-        textureSource = Hack {it->second}.GetTextureSource();
-        //printf("source: %d\n", textureSource);
-      }
-      const auto& image = images[textureSource];
+  Fwog::SamplerState ConvertSampler(const tinygltf::Model& model, int samplerIndex)
+  {
+    Fwog::SamplerState samplerState{};
 
-      // Load sampler
+    // sampler isn't null
+    if (samplerIndex >= 0)
+    {
+      const tinygltf::Sampler& baseColorSampler = model.samplers[samplerIndex];
+
+      samplerState.addressModeU = ConvertGlAddressMode(baseColorSampler.wrapS);
+      samplerState.addressModeV = ConvertGlAddressMode(baseColorSampler.wrapT);
+      samplerState.minFilter = ConvertGlFilterMode(baseColorSampler.minFilter);
+      samplerState.magFilter = ConvertGlFilterMode(baseColorSampler.magFilter);
+      samplerState.mipmapFilter = GetGlMipmapFilter(baseColorSampler.minFilter);
+      if (GetGlMipmapFilter(baseColorSampler.minFilter) != Fwog::Filter::NONE)
       {
-        Fwog::SamplerState samplerState{};
+        samplerState.anisotropy = Fwog::SampleCount::SAMPLES_16;
+      }
+    }
 
-        // sampler isn't null
-        if (texture.sampler >= 0)
-        {
-          const tinygltf::Sampler& baseColorSampler = model.samplers[texture.sampler];
-
-          samplerState.addressModeU = ConvertGlAddressMode(baseColorSampler.wrapS);
-          samplerState.addressModeV = ConvertGlAddressMode(baseColorSampler.wrapT);
-          samplerState.minFilter = ConvertGlFilterMode(baseColorSampler.minFilter);
-          samplerState.magFilter = ConvertGlFilterMode(baseColorSampler.magFilter);
-          samplerState.mipmapFilter = GetGlMipmapFilter(baseColorSampler.minFilter);
-          if (GetGlMipmapFilter(baseColorSampler.minFilter) != Fwog::Filter::NONE)
-          {
-            samplerState.anisotropy = Fwog::SampleCount::SAMPLES_16;
-          }
-        }
+    return samplerState;
+  }
 
-        samplers.emplace_back(samplerState);
-      }
+  Fwog::Texture UploadImage(const RawImageData& image)
+  {
+    Fwog::Extent2D dims = {static_cast<uint32_t>(image.width), static_cast<uint32_t>(image.height)};
+
+    if (image.format != Fwog::Format::R8G8B8A8_UNORM)
+    {
+      const auto levelCount = static_cast<uint32_t>(image.levels.size());
+      auto textureData = Fwog::CreateTexture2DMip(dims, image.format, levelCount, image.name);
 
-      // Load texture
+      for (uint32_t level = 0; level < levelCount; level++)
       {
+        uint32_t width = std::max(dims.width >> level, 1u);
+        uint32_t height = std::max(dims.height >> level, 1u);
 
-        Fwog::Extent2D dims = {static_cast<uint32_t>(image.width), static_cast<uint32_t>(image.height)};
+        textureData.UpdateCompressedImageAsync({
+          .level = level,
+          .extent = {width, height, 1},
+          .data = image.levels[level].data(),
+        });
+      }
 
-        if (image.isKtx)
-        {
-          auto* ktx = image.ktx.get();
-          if (ktxTexture2_NeedsTranscoding(ktx))
-          {
-            if (auto result = ktxTexture2_TranscodeBasis(ktx, KTX_TTF_BC7_RGBA, KTX_TF_HIGH_QUALITY); result != KTX_SUCCESS)
-            {
-              FWOG_ASSERT(0);
-            }
-          }
+      return textureData;
+    }
 
-          auto textureData = Fwog::CreateTexture2DMip(dims, Fwog::Format::BC7_RGBA_UNORM, ktx->numLevels, image.name);
+    FWOG_ASSERT(image.format == Fwog::Format::R8G8B8A8_UNORM);
+    FWOG_ASSERT(image.components == 4);
+    FWOG_ASSERT(image.pixel_type == GL_UNSIGNED_BYTE);
+    FWOG_ASSERT(image.bits == 8);
+
+    auto textureData = Fwog::CreateTexture2DMip(dims,
+                                                image.format,
+                                                uint32_t(1 + floor(log2(glm::max(dims.width, dims.height)))),
+                                                image.name);
+
+    Fwog::TextureUpdateInfo updateInfo{.level = 0,
+                                       .offset = {},
+                                       .extent = {dims.width, dims.height, 1},
+                                       .format = Fwog::UploadFormat::RGBA,
+                                       .type = Fwog::UploadType::UBYTE,
+                                       .pixels = image.levels[0].data()};
+    textureData.UpdateImageAsync(updateInfo);
+    textureData.GenMipmaps();
+
+    return textureData;
+  }
 
-          for (uint32_t level = 0; level < ktx->numLevels; level++)
-          {
-            size_t offset{};
-            ktxTexture_GetImageOffset(ktxTexture(ktx), level, 0, 0, &offset);
-            //auto imageSize = ktxTexture_GetImageSize(ktxTexture(ktx), level);
+  // Returns the image that a texture uses. With KHR_texture_basisu, that is the KTX2 image rather than the fallback
+  int GetTextureSource(const tinygltf::Texture& texture)
+  {
+    int textureSource = texture.source;
+    if (auto it = texture.extensions.find("KHR_texture_basisu"); it != texture.extensions.end())
+    {
+      struct Hack : tinygltf::Value
+      {
+        Hack(const tinygltf::Value& basisuExtension)
+          : Value(basisuExtension) {}
+
+        int GetTextureSource() const
+        {
+          return this->object_value_.at("source").GetNumberAsInt();
+        }
+      };
+      textureSource = Hack {it->second}.GetTextureSource();
+      //printf("source: %d\n", textureSource);
+    }
+    return textureSource;
+  }
 
-            uint32_t width = std::max(dims.width >> level, 1u);
-            uint32_t height = std::max(dims.height >> level, 1u);
+  // The images that are used by textures, in the order that LoadTextureSamplers uploads them
+  std::vector<size_t> GetUsedImages(const tinygltf::Model& model)
+  {
+    std::vector<size_t> usedImages;
+    std::vector<bool> isUsed(model.images.size());
+    for (const auto& texture : model.textures)
+    {
+      const auto textureSource = static_cast<size_t>(GetTextureSource(texture));
+      if (!isUsed[textureSource])
+      {
+        isUsed[textureSource] = true;
+        usedImages.push_back(textureSource);
+      }
+    }
+    return usedImages;
+  }
 
-            textureData.UpdateCompressedImage({
-              .level = level,
-              .extent = {width, height, 1},
-              .data = ktx->pData + offset,
-            });
-          }
+  // Returns nullopt if an image that is used by a texture couldn't be decoded
+  std::optional<LoadedTextures> LoadTextureSamplers(const tinygltf::Model& model,
+                                                    std::span<const RawImageData> images,
+                                                    ParallelImageDecoder& decoder)
+  {
+    LoadedTextures loaded;
+    std::vector<std::optional<uint32_t>> imageIndices(images.size());
 
-          textures.emplace_back(std::move(textureData));
+    for (const auto& texture : model.textures)
+    {
+      const int textureSource = GetTextureSource(texture);
+
+      // Each image is decoded to exactly one GPU format, so the source identifies the texture
+      auto& imageIndex = imageIndices[textureSource];
+      if (!imageIndex)
+      {
+        if (!decoder.Wait(textureSource))
+        {
+          return std::nullopt;
         }
-        else
+        imageIndex = static_cast<uint32_t>(loaded.images.size());
+        loaded.images.emplace_back(UploadImage(images[textureSource]));
+        loaded.cachedImages += images[textureSource].cached.has_value();
+        if (const auto& seconds = images[textureSource].decodeSeconds)
+        {
+          loaded.decodedImages++;
+          loaded.decodedPixels += static_cast<uint64_t>(images[textureSource].width) * images[textureSource].height;
+          loaded.decodeSeconds += *seconds;
+        }
+        if (const auto& stats = images[textureSource].encodeStats)
         {
-          FWOG_ASSERT(image.components == 4);
-          FWOG_ASSERT(image.pixel_type == GL_UNSIGNED_BYTE);
-          FWOG_ASSERT(image.bits == 8);
-
-          auto textureData = Fwog::CreateTexture2DMip(dims,
-                                                      Fwog::Format::R8G8B8A8_UNORM,
-                                                      uint32_t(1 + floor(log2(glm::max(dims.width, dims.height)))),
-                                                      image.name);
-
-          Fwog::TextureUpdateInfo updateInfo{.level = 0,
-                                             .offset = {},
-                                             .extent = {dims.width, dims.height, 1},
-                                             .format = Fwog::UploadFormat::RGBA,
-                                             .type = Fwog::UploadType::UBYTE,
-                                             .pixels = image.data.get()};
-          textureData.UpdateImage(updateInfo);
-          textureData.GenMipmaps();
-
-          textures.emplace_back(std::move(textureData));
+          loaded.encodedImages++;
+          loaded.encodedPixels += stats->pixels;
+          loaded.encodeSeconds += stats->seconds;
+          loaded.psnrSum += stats->psnr;
         }
       }
+
+      // Fwog::Sampler already dedupes GL samplers with the context's sampler cache. Merging the states here means
+      // materials that use the same sampler can be recognized by index
+      const auto samplerState = ConvertSampler(model, texture.sampler);
+      auto samplerIt = std::ranges::find(loaded.samplers, samplerState);
+      if (samplerIt == loaded.samplers.end())
+      {
+        samplerIt = loaded.samplers.insert(samplerIt, samplerState);
+      }
+
+      loaded.textures.emplace_back(*imageIndex, static_cast<uint32_t>(samplerIt - loaded.samplers.begin()));
     }
 
-    return std::make_pair(std::move(textures), std::move(samplers));
+    return loaded;
   }
 
-  std::vector<Material> LoadMaterials(const tinygltf::Model& model, int baseTextureSamplerIndex, std::span<Fwog::Texture> textures, std::span<const Fwog::SamplerState> samplers)
+  std::vector<Material> LoadMaterials(const tinygltf::Model& model, LoadedTextures& textures)
   {
     std::vector<Material> materials;
 
@@ -558,13 +891,24 @@ namespace Utility
 
       if (baseColorTextureIndex >= 0)
       {
-        auto& tex = textures[baseColorTextureIndex];
-        auto texFormat = tex.GetCreateInfo().format;
+        const auto [imageIndex, samplerIndex] = textures.textures[baseColorTextureIndex];
+        auto& tex = textures.images[imageIndex];
+        const auto& texInfo = tex.GetCreateInfo();
         material.gpuMaterial.flags |= MaterialFlagBit::HAS_BASE_COLOR_TEXTURE;
+
+        // Materials that use the same image share one view, so the view outlives the material and only needs one
+        // bindless handle
         material.albedoTextureSampler = 
         {
-          tex.CreateFormatView(texFormat == Fwog::Format::BC7_RGBA_UNORM ? Fwog::Format::BC7_RGBA_SRGB : Fwog::Format::R8G8B8A8_SRGB),
-          samplers[baseColorTextureIndex]
+          tex.CreateCachedView({
+            .viewType = texInfo.imageType,
+            .format = GetSrgbFormat(texInfo.format),
+            .minLevel = 0,
+            .numLevels = texInfo.mipLevels,
+            .minLayer = 0,
+            .numLayers = texInfo.arrayLayers,
+          }),
+          textures.samplers[samplerIndex]
         };
       }
 
@@ -613,8 +957,7 @@ namespace Utility
   std::optional<LoadModelResult> LoadModelFromFileBase(std::string_view fileName, 
     glm::mat4 rootTransform, 
     bool binary,
-    uint32_t baseMaterialIndex,
-    uint32_t baseTextureSamplerIndex)
+    uint32_t baseMaterialIndex)
   {
     tinygltf::TinyGLTF loader;
     tinygltf::Model model;
@@ -659,25 +1002,57 @@ namespace Utility
       return std::nullopt;
     }
 
-    bool loadImageResult = LoadImageDataParallel(rawImageData);
-    if (loadImageResult == false)
+    // let's not deal with glTFs containing multiple scenes right now
+    FWOG_ASSERT(model.scenes.size() == 1);
+
+    std::cout << "Parsing took " << timer.Elapsed_us() / 1000 << " ms\n";
+
+    // Images are uploaded as they finish decoding. Images that no texture uses, such as the fallbacks of
+    // KHR_texture_basisu textures, are not decoded
+    std::optional<TextureCache> textureCache;
+    if (!textureCacheDirectory.empty())
+    {
+      textureCache.emplace(textureCacheDirectory);
+    }
+    auto usedImages = GetUsedImages(model);
+    const auto unusedImageCount = rawImageData.size() - usedImages.size();
+    ParallelImageDecoder decoder(rawImageData,
+                                 std::move(usedImages),
+                                 {
+                                   .cache = textureCache ? &*textureCache : nullptr,
+                                   .compression = imageCompression,
+                                 });
+    auto textures = LoadTextureSamplers(model, rawImageData, decoder);
+    if (!textures)
     {
       std::cout << "Failed to load glTF images" << '\n';
       return std::nullopt;
     }
 
-    // let's not deal with glTFs containing multiple scenes right now
-    FWOG_ASSERT(model.scenes.size() == 1);
-
-    auto ms = timer.Elapsed_us() / 1000;
-    std::cout << "Loading took " << ms << " ms\n";
+    std::cout << "Loading took " << timer.Elapsed_us() / 1000 << " ms (" << model.textures.size() << " textures, "
+              << textures->images.size() << " unique images (" << textures->cachedImages << " cached, "
+              << unusedImageCount << " unused images skipped), " << textures->samplers.size() << " unique samplers)\n";
+    if (textures->decodedImages > 0)
+    {
+      // Like block compression, decoding is parallel, so this is the rate of a single thread
+      std::cout << "Decoded " << textures->decodedImages << " images in " << textures->decodeSeconds * 1000
+                << " ms of worker time (" << textures->decodedPixels / textures->decodeSeconds / 1e6
+                << " MPixels/s per thread), excluding block compression and uploads\n";
+    }
+    if (textures->encodedImages > 0)
+    {
+      // Images are encoded in parallel, so this is the rate of a single thread
+      std::cout << "Block-compressed " << textures->encodedImages << " images at "
+                << textures->encodedPixels / textures->encodeSeconds / 1e6 << " MPixels/s per thread, "
+                << textures->psnrSum / textures->encodedImages << " dB average PSNR\n";
+    }
 
     LoadModelResult scene;
 
-    std::tie(scene.textures, scene.samplers) = LoadTextureSamplers(model, rawImageData);
-
-    auto materials = LoadMaterials(model, baseTextureSamplerIndex, scene.textures, scene.samplers);
+    auto materials = LoadMaterials(model, *textures);
     std::ranges::move(materials, std::back_inserter(scene.materials));
+    scene.textures = std::move(textures->images);
+    scene.samplers = std::move(textures->samplers);
 
     // <node*, global transform>
     std::stack<std::pair<const tinygltf::Node*, glm::mat4>> nodeStack;
@@ -727,24 +1102,37 @@ namespace Utility
     return scene;
   }
 
+  void SetTextureCacheDirectory(std::filesystem::path directory)
+  {
+    textureCacheDirectory = std::move(directory);
+  }
+
+  void SetImageCompression(std::optional<BcQuality> quality)
+  {
+    imageCompression = quality;
+  }
+
   bool LoadModelFromFile(Scene& scene, std::string_view fileName, glm::mat4 rootTransform, bool binary)
   {
-    FWOG_ASSERT(scene.textures.size() == scene.samplers.size());
     const auto baseMaterialIndex = static_cast<uint32_t>(scene.materials.size());
-    const auto baseTextureSamplerIndex = static_cast<uint32_t>(scene.textures.size());
 
-    auto loadedScene = LoadModelFromFileBase(fileName, rootTransform, binary, baseMaterialIndex, baseTextureSamplerIndex);
+    auto loadedScene = LoadModelFromFileBase(fileName, rootTransform, binary, baseMaterialIndex);
 
     if (!loadedScene)
       return false;
 
+    if (!scene.geometryHeap)
+    {
+      scene.geometryHeap.emplace(geometryHeapBlockSize);
+    }
+
     scene.meshes.reserve(scene.meshes.size() + loadedScene->meshes.size());
     for (auto& mesh : loadedScene->meshes)
     {
       scene.meshes.emplace_back(Mesh
         {
-          .vertexBuffer = Fwog::Buffer(std::span(mesh.vertices)),
-          .indexBuffer = Fwog::Buffer(std::span(mesh.indices)),
+          .vertexAllocation = scene.geometryHeap->Allocate(std::span(mesh.vertices)),
+          .indexAllocation = scene.geometryHeap->Allocate(std::span(mesh.indices)),
           .materialIdx = mesh.materialIdx,
           .transform = mesh.transform
         });
@@ -759,13 +1147,29 @@ namespace Utility
     return true;
   }
 
+  size_t DefragmentGeometry(Scene& scene, const Fwog::BufferHeapDefragmentInfo& info)
+  {
+    if (!scene.geometryHeap)
+      return 0;
+
+    const auto relocations = scene.geometryHeap->Defragment(info);
+    if (relocations.empty())
+      return 0;
+
+    for (auto& mesh : scene.meshes)
+    {
+      scene.geometryHeap->ApplyRelocations(relocations, mesh.vertexAllocation);
+      scene.geometryHeap->ApplyRelocations(relocations, mesh.indexAllocation);
+    }
+
+    return relocations.size();
+  }
+
   bool LoadModelFromFileBindless(SceneBindless& scene, std::string_view fileName, glm::mat4 rootTransform, bool binary)
   {
-    FWOG_ASSERT(scene.textures.size() == scene.samplers.size());
     const auto baseMaterialIndex = static_cast<uint32_t>(scene.materials.size());
-    const auto baseTextureSamplerIndex = static_cast<uint32_t>(scene.materials.size());
 
-    auto loadedScene = LoadModelFromFileBase(fileName, rootTransform, binary, baseMaterialIndex, baseTextureSamplerIndex);
+    auto loadedScene = LoadModelFromFileBase(fileName, rootTransform, binary, baseMaterialIndex);
 
     if (!loadedScene)
       return false;
@@ -790,24 +1194,84 @@ namespace Utility
       scene.indices.insert(scene.indices.end(), tempIndices.begin(), tempIndices.end());
     }
 
-    std::ranges::move(loadedScene->textures, std::back_inserter(scene.textures));
-
     std::ranges::move(loadedScene->samplers, std::back_inserter(scene.samplers));
 
+    if (!scene.textureTable)
+    {
+      scene.textureTable.emplace(Fwog::BindlessTextureTableCreateInfo{.capacity = 4096});
+    }
+
+    // Without bindless textures, the materials' textures are copied into arrays that can be bound all at once. Each
+    // array can only be sampled with one sampler, so textures are partitioned by sampler. The loaded textures are
+    // released once they're packed, as nothing else uses them
+    std::optional<PackedTextures> packedTextures;
+    const auto baseArrayIndex = static_cast<uint32_t>(scene.textureArrays.size());
+    if (!scene.textureTable->IsSupported())
+    {
+      const auto textureBytesBefore = Fwog::GetMemoryUsage().textureBytes;
+
+      std::vector<TextureArrayPackerInput> packerInputs;
+      for (auto& material : loadedScene->materials)
+      {
+        if (material.gpuMaterial.flags & MaterialFlagBit::HAS_BASE_COLOR_TEXTURE)
+        {
+          auto& [texture, sampler] = material.albedoTextureSampler.value();
+          const auto samplerIndex = std::ranges::find(scene.samplers, sampler) - scene.samplers.begin();
+          packerInputs.push_back({.texture = &texture, .partition = static_cast<uint32_t>(samplerIndex)});
+        }
+      }
+
+      packedTextures = PackTextureArrays(packerInputs, {.resample = true, .maxExtent = 4096});
+      for (auto& array : packedTextures->arrays)
+      {
+        scene.textureArraySamplers.push_back(scene.samplers[array.partition]);
+        scene.textureArrays.push_back(std::move(array));
+      }
+
+      // The materials' views must be destroyed along with the textures they view, or the views keep them alive
+      for (auto& material : loadedScene->materials)
+      {
+        material.albedoTextureSampler.reset();
+      }
+      loadedScene->textures.clear();
+      const auto textureBytesAfter = Fwog::GetMemoryUsage().textureBytes;
+
+      const auto& stats = packedTextures->stats;
+      std::cout << "Packed " << stats.textureCount << " textures into " << stats.arrayCount << " texture arrays ("
+                << stats.resampledCount << " resampled), " << stats.sourceBytes / 1024 / 1024 << " MiB -> "
+                << stats.packedBytes / 1024 / 1024 << " MiB. Texture memory after releasing the sources: "
+                << textureBytesBefore / 1024 / 1024 << " MiB -> " << textureBytesAfter / 1024 / 1024 << " MiB\n";
+    }
+    else
+    {
+      std::ranges::move(loadedScene->textures, std::back_inserter(scene.textures));
+    }
+
     scene.materials.reserve(scene.materials.size() + loadedScene->materials.size());
+    uint32_t packedTextureIndex = 0;
     for (auto& material : loadedScene->materials)
     {
       GpuMaterialBindless bindlessMaterial
       {
         .flags = material.gpuMaterial.flags,
         .alphaCutoff = material.gpuMaterial.alphaCutoff,
-        .baseColorTextureHandle = 0,
+        .baseColorTextureIndex = 0,
         .baseColorFactor = material.gpuMaterial.baseColorFactor
       };
       if (material.gpuMaterial.flags & MaterialFlagBit::HAS_BASE_COLOR_TEXTURE)
       {
-        auto& [texture, sampler] = material.albedoTextureSampler.value();
-        bindlessMaterial.baseColorTextureHandle = texture.GetBindlessHandle(Fwog::Sampler(sampler));
+        if (packedTextures)
+        {
+          const auto location = packedTextures->locations[packedTextureIndex++];
+          bindlessMaterial.baseColorTextureIndex = baseArrayIndex + location.arrayIndex;
+          bindlessMaterial.baseColorLayer = location.layer;
+        }
+        else
+        {
+          auto& [texture, sampler] = material.albedoTextureSampler.value();
+          // The view is a cached view of a texture in scene.textures, so its GL texture outlives the material
+          bindlessMaterial.baseColorTextureIndex = scene.textureTable->Add(texture, sampler);
+        }
       }
       scene.materials.emplace_back(bindlessMaterial);
     }
@@ -1,14 +1,20 @@
 #pragma once
 #include <Fwog/detail/Flags.h>
+#include <Fwog/BindlessTextureTable.h>
 #include <Fwog/Buffer.h>
+#include <Fwog/BufferHeap.h>
 #include <Fwog/Texture.h>
 
+#include "BlockCompression.h"
+#include "TextureArrayPacker.h"
+
 #include <glm/mat4x4.hpp>
 #include <glm/vec4.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec2.hpp>
 
 #include <vector>
+#include <filesystem>
 #include <string_view>
 #include <optional>
 
@@ -54,7 +60,8 @@ namespace Utility
   {
     MaterialFlags flags{};
     float alphaCutoff{};
-    uint64_t baseColorTextureHandle{};
+    uint32_t baseColorTextureIndex{}; // Slot of SceneBindless::textureTable, or index of SceneBindless::textureArrays
+    uint32_t baseColorLayer{};        // Layer of the texture array, if there is no textureTable
     glm::vec4 baseColorFactor{};
   };
 
@@ -66,17 +73,22 @@ namespace Utility
 
   struct Mesh
   {
-    //const GeometryBuffers* buffers;
-    Fwog::Buffer vertexBuffer;
-    Fwog::Buffer indexBuffer;
+    // Suballocations of Scene::geometryHeap
+    Fwog::BufferHeapAllocation vertexAllocation;
+    Fwog::BufferHeapAllocation indexAllocation;
     uint32_t materialIdx{};
     glm::mat4 transform{};
   };
 
   struct Scene
   {
+    // Owns the vertex and index data of every mesh. Created when the first model is loaded
+    std::optional<Fwog::BufferHeap> geometryHeap;
     std::vector<Mesh> meshes;
     std::vector<Material> materials;
+
+    // One texture per unique image and one state per unique sampler. Materials reference them, so the two are not
+    // parallel arrays
     std::vector<Fwog::Texture> textures;
     std::vector<Fwog::SamplerState> samplers;
   };
@@ -97,10 +109,31 @@ namespace Utility
     std::vector<Vertex> vertices;
     std::vector<index_t> indices;
     std::vector<GpuMaterialBindless> materials;
+
+    // Only holds the textures of models that were loaded with bindless textures. Otherwise, the materials' textures are
+    // copied into textureArrays and the originals are released
     std::vector<Fwog::Texture> textures;
     std::vector<Fwog::SamplerState> samplers;
+
+    // Bindless handles of the materials' textures. Created when the first model is loaded. Declared after the textures
+    // so that it is destroyed first
+    std::optional<Fwog::BindlessTextureTable> textureTable;
+
+    // Copies of the materials' textures, used instead of textureTable if bindless textures are not supported. Each
+    // array is sampled with the sampler at the same index of textureArraySamplers
+    std::vector<PackedTextureArray> textureArrays;
+    std::vector<Fwog::SamplerState> textureArraySamplers;
   };
 
+  // Decoded and transcoded images are cached in this directory so later loads can skip decoding them. Defaults to
+  // "texture_cache" in the working directory. An empty path disables the cache
+  void SetTextureCacheDirectory(std::filesystem::path directory);
+
+  // Block-compresses PNG and JPEG images (with BC3 if they have alpha, and BC1 otherwise) when they're loaded. This
+  // takes a while (unless they're in the texture cache), but they use a quarter to an eighth of the memory. Disabled by
+  // default
+  void SetImageCompression(std::optional<BcQuality> quality);
+
   bool LoadModelFromFile(Scene& scene, 
     std::string_view fileName, 
     glm::mat4 rootTransform = glm::mat4{ 1 }, 
@@ -110,4 +143,7 @@ namespace Utility
     std::string_view fileName, 
     glm::mat4 rootTransform = glm::mat4{ 1 }, 
     bool binary = false);
+
+  // Compacts the scene's geometry heap and patches the meshes that were moved. Returns the number of moved allocations
+  size_t DefragmentGeometry(Scene& scene, const Fwog::BufferHeapDefragmentInfo& info = {});
 }
\ No newline at end of file
@@ -0,0 +1,249 @@
+#include "TextureArrayPacker.h"
+
+#include <Fwog/Context.h>
+#include <Fwog/MipmapGenerator.h>
+#include <Fwog/Rendering.h>
+
+#include <algorithm>
+#include <bit>
+#include <unordered_map>
+#include <utility>
+
+namespace Utility
+{
+  namespace
+  {
+    struct ArrayKey
+    {
+      uint32_t partition;
+      Fwog::Format storageFormat;
+      Fwog::Format viewFormat;
+      uint32_t width;
+      uint32_t height;
+      uint32_t levels;
+      bool resample; // Layers are blitted and their mips regenerated, rather than copied
+
+      bool operator==(const ArrayKey&) const = default;
+    };
+
+    struct ArrayMembers
+    {
+      ArrayKey key;
+      std::vector<uint32_t> inputs;
+    };
+
+    bool IsResamplable(Fwog::Format format)
+    {
+      return format == Fwog::Format::R8G8B8A8_UNORM || format == Fwog::Format::R8G8B8A8_SRGB;
+    }
+
+    bool IsBlockCompressed(Fwog::Format format)
+    {
+      return format >= Fwog::Format::BC1_RGB_UNORM && format <= Fwog::Format::BC7_RGBA_SRGB;
+    }
+
+    bool IsSrgb(Fwog::Format format)
+    {
+      switch (format)
+      {
+      case Fwog::Format::R8G8B8_SRGB:
+      case Fwog::Format::R8G8B8A8_SRGB:
+      case Fwog::Format::BC1_RGB_SRGB:
+      case Fwog::Format::BC1_RGBA_SRGB:
+      case Fwog::Format::BC2_RGBA_SRGB:
+      case Fwog::Format::BC3_RGBA_SRGB:
+      case Fwog::Format::BC7_RGBA_SRGB: return true;
+      default: return false;
+      }
+    }
+
+    // Only RGBA8 and BCn textures are loaded by the examples, so other formats are assumed to be 4 bytes per texel
+    uint64_t EstimateSize(Fwog::Format format, uint32_t width, uint32_t height, uint32_t levels)
+    {
+      uint64_t size = 0;
+      for (uint32_t level = 0; level < levels; level++)
+      {
+        const auto levelWidth = std::max(width >> level, 1u);
+        const auto levelHeight = std::max(height >> level, 1u);
+        if (IsBlockCompressed(format))
+        {
+          size += Fwog::detail::GetBlockCompressedImageSize(format, levelWidth, levelHeight, 1);
+        }
+        else
+        {
+          size += uint64_t(levelWidth) * levelHeight * 4;
+        }
+      }
+      return size;
+    }
+
+    uint32_t GetLevelCount(uint32_t width, uint32_t height)
+    {
+      return std::bit_width(std::max(width, height));
+    }
+  } // namespace
+
+  PackedTextures PackTextureArrays(std::span<const TextureArrayPackerInput> inputs,
+                                   const TextureArrayPackerSettings& settings)
+  {
+    const auto maxLayers = static_cast<uint32_t>(Fwog::GetDeviceProperties().limits.maxArrayTextureLayers);
+
+    PackedTextures packed;
+    packed.locations.resize(inputs.size());
+
+    // The first input of each texture and partition, so that later inputs of the same texture share its layer
+    std::unordered_map<uint64_t, uint32_t> firstInputs;
+
+    std::vector<ArrayMembers> groups;
+    for (uint32_t i = 0; i < inputs.size(); i++)
+    {
+      const auto inputKey = uint64_t(inputs[i].texture->Handle()) << 32 | inputs[i].partition;
+      if (const auto [it, inserted] = firstInputs.try_emplace(inputKey, i); !inserted)
+      {
+        packed.locations[i] = packed.locations[it->second];
+        continue;
+      }
+
+      packed.stats.textureCount++;
+
+      const auto& texture = *inputs[i].texture;
+      const auto& createInfo = texture.GetCreateInfo();
+      FWOG_ASSERT(createInfo.imageType == Fwog::ImageType::TEX_2D);
+
+      // Views of the base texture are packed in the base format, so layers can be copied without conversion
+      auto key = ArrayKey{
+        .partition = inputs[i].partition,
+        .storageFormat = createInfo.format,
+        .viewFormat = createInfo.format,
+        .width = createInfo.extent.width,
+        .height = createInfo.extent.height,
+        .levels = createInfo.mipLevels,
+        .resample = settings.resample && IsResamplable(createInfo.format),
+      };
+      if (const auto* view = dynamic_cast<const Fwog::TextureView*>(&texture))
+      {
+        FWOG_ASSERT(view->GetViewInfo().minLevel == 0 && view->GetViewInfo().minLayer == 0);
+        key.viewFormat = view->GetViewInfo().format;
+        key.levels = std::min(key.levels, view->GetViewInfo().numLevels);
+      }
+
+      packed.stats.sourceBytes += EstimateSize(key.storageFormat, key.width, key.height, key.levels);
+
+      if (key.resample)
+      {
+        auto width = std::bit_ceil(key.width);
+        auto height = std::bit_ceil(key.height);
+        if (settings.maxExtent != 0)
+        {
+          width = std::min(width, std::bit_floor(settings.maxExtent));
+          height = std::min(height, std::bit_floor(settings.maxExtent));
+        }
+        if (width != key.width || height != key.height)
+        {
+          packed.stats.resampledCount++;
+        }
+        key.width = width;
+        key.height = height;
+        key.levels = GetLevelCount(width, height);
+      }
+
+      auto it = std::ranges::find_if(groups,
+                                     [&](const ArrayMembers& group)
+                                     { return group.key == key && group.inputs.size() < maxLayers; });
+      if (it == groups.end())
+      {
+        groups.push_back({.key = key});
+        it = groups.end() - 1;
+      }
+
+      packed.locations[i] = {
+        .arrayIndex = static_cast<uint32_t>(it - groups.begin()),
+        .layer = static_cast<uint32_t>(it->inputs.size()),
+      };
+      it->inputs.push_back(i);
+    }
+
+    // Only created if a group needs it, as it compiles its pipelines lazily anyway
+    std::optional<Fwog::MipmapGenerator> mipmapGenerator;
+
+    for (const auto& [key, members] : groups)
+    {
+      auto array = Fwog::Texture(
+        Fwog::TextureCreateInfo{
+          .imageType = Fwog::ImageType::TEX_2D_ARRAY,
+          .format = key.storageFormat,
+          .extent = {key.width, key.height, 1},
+          .mipLevels = key.levels,
+          .arrayLayers = static_cast<uint32_t>(members.size()),
+          .sampleCount = Fwog::SampleCount::SAMPLES_1,
+        },
+        "Packed texture array");
+
+      for (uint32_t layer = 0; layer < members.size(); layer++)
+      {
+        auto& source = *inputs[members[layer]].texture;
+        const auto& sourceExtent = source.GetCreateInfo().extent;
+
+        if (!key.resample)
+        {
+          for (uint32_t level = 0; level < key.levels; level++)
+          {
+            Fwog::CopyTexture({
+              .source = source,
+              .target = array,
+              .sourceLevel = level,
+              .targetLevel = level,
+              .targetOffset = {0, 0, layer},
+              .extent = {std::max(key.width >> level, 1u), std::max(key.height >> level, 1u), 1},
+            });
+          }
+          continue;
+        }
+
+        // Blitting from an sRGB view to a UNORM array (or vice versa) would convert the texels
+        std::optional<Fwog::TextureView> sourceView;
+        if (key.viewFormat != key.storageFormat)
+        {
+          sourceView = source.CreateFormatView(key.storageFormat);
+        }
+
+        Fwog::BlitTexture(sourceView ? static_cast<const Fwog::Texture&>(*sourceView) : source,
+                          array.CreateSingleLayerView(layer),
+                          {},
+                          {},
+                          {sourceExtent.width, sourceExtent.height, 1},
+                          {key.width, key.height, 1},
+                          Fwog::Filter::LINEAR);
+      }
+
+      if (key.resample && key.levels > 1)
+      {
+        if (!mipmapGenerator)
+        {
+          mipmapGenerator.emplace();
+        }
+        mipmapGenerator->Generate(array, {.srgb = IsSrgb(key.viewFormat)});
+      }
+
+      packed.stats.packedBytes +=
+        EstimateSize(key.storageFormat, key.width, key.height, key.levels) * members.size();
+
+      auto& packedArray = packed.arrays.emplace_back(PackedTextureArray{
+        .texture = std::move(array),
+        .partition = key.partition,
+      });
+      if (key.viewFormat != key.storageFormat)
+      {
+        packedArray.view = packedArray.texture.CreateFormatView(key.viewFormat);
+      }
+    }
+
+    if (mipmapGenerator)
+    {
+      Fwog::MemoryBarrier(Fwog::MemoryBarrierBit::TEXTURE_FETCH_BIT);
+    }
+
+    packed.stats.arrayCount = static_cast<uint32_t>(packed.arrays.size());
+    return packed;
+  }
+} // namespace Utility
@@ -0,0 +1,88 @@
+#pragma once
+#include <Fwog/BasicTypes.h>
+#include <Fwog/Texture.h>
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace Utility
+{
+  struct TextureArrayPackerInput
+  {
+    Fwog::Texture* texture{};
+
+    // Textures in different partitions never share an array. For example, the index of the sampler that the texture is
+    // used with, as each array can only be bound with one sampler
+    uint32_t partition{};
+  };
+
+  struct TextureArrayPackerSettings
+  {
+    // Round the size of RGBA8 textures up to a power of two, so that textures with similar sizes share an array.
+    // Resampled textures get a full mip chain. Other formats are only packed with textures of the same size
+    bool resample = false;
+
+    // With resample, RGBA8 textures are also downscaled so that neither dimension exceeds this. Zero means no limit
+    uint32_t maxExtent = 0;
+  };
+
+  struct TextureArrayPackerStats
+  {
+    // The number of distinct inputs that were packed
+    uint32_t textureCount{};
+    uint32_t arrayCount{};
+    uint32_t resampledCount{};
+
+    // The estimated size of the inputs and of the arrays. The arrays can be larger because of resampling, or smaller
+    // because of downscaling
+    uint64_t sourceBytes{};
+    uint64_t packedBytes{};
+  };
+
+  struct PackedTextureArray
+  {
+    // A TEX_2D_ARRAY with the format of the base texture of its inputs
+    Fwog::Texture texture;
+
+    // A view with the format that the inputs were viewed with, if that is different (such as an sRGB view of a UNORM
+    // texture)
+    std::optional<Fwog::TextureView> view;
+
+    uint32_t partition{};
+
+    // The array or its view, whichever the inputs should be sampled like
+    [[nodiscard]] const Fwog::Texture& GetSampledTexture() const
+    {
+      return view ? static_cast<const Fwog::Texture&>(*view) : texture;
+    }
+  };
+
+  struct PackedTextureLocation
+  {
+    uint32_t arrayIndex{};
+    uint32_t layer{};
+  };
+
+  struct PackedTextures
+  {
+    std::vector<PackedTextureArray> arrays;
+
+    // The location of each input, in the same order. Inputs with the same texture and partition share a location
+    std::vector<PackedTextureLocation> locations;
+
+    TextureArrayPackerStats stats;
+  };
+
+  // Copies 2D textures into TEX_2D_ARRAY textures, so that draws that sample different textures can be merged on
+  // drivers without bindless textures.
+  //
+  // Textures are grouped by partition, format, size, and mip count. Each group becomes one array (or several, if it has
+  // more layers than the driver supports). Layers are copied on the GPU, without a round trip through the CPU.
+  // Inputs can be views, in which case the arrays have the format of the base texture and get a view with the format
+  // of the inputs. Inputs are identified by their GL texture, so an input that appears more than once (such as a cached
+  // view that several materials use) is copied into one layer.
+  [[nodiscard]] PackedTextures PackTextureArrays(std::span<const TextureArrayPackerInput> inputs,
+                                                 const TextureArrayPackerSettings& settings = {});
+} // namespace Utility
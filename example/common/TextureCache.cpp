@@ -0,0 +1,326 @@
+#include "TextureCache.h"
+
+#include <Fwog/Config.h>
+#include <Fwog/Texture.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Utility
+{
+  namespace
+  {
+    constexpr uint32_t entryMagic = 0x43545746; // "FWTC"
+
+    // Increment when the layout of entries or the way images are decoded changes
+    constexpr uint32_t entryVersion = 1;
+
+    struct EntryHeader
+    {
+      uint32_t magic;
+      uint32_t version;
+      uint64_t hash;
+      uint32_t format;
+      uint32_t width;
+      uint32_t height;
+      uint32_t levelCount;
+    };
+
+    // Followed by EntryHeader::levelCount of these, and then the data of each level
+    struct LevelHeader
+    {
+      uint64_t offset;
+      uint64_t size;
+    };
+
+    uint32_t GetMaxLevelCount(uint32_t width, uint32_t height)
+    {
+      return static_cast<uint32_t>(std::bit_width(std::max(width, height)));
+    }
+
+    // The examples only cache block-compressed and RGBA8 images
+    uint64_t GetLevelSize(Fwog::Format format, uint32_t width, uint32_t height, uint32_t level)
+    {
+      width = std::max(width >> level, 1u);
+      height = std::max(height >> level, 1u);
+      if (format >= Fwog::Format::BC1_RGB_UNORM && format <= Fwog::Format::BC7_RGBA_SRGB)
+      {
+        return Fwog::detail::GetBlockCompressedImageSize(format, width, height, 1);
+      }
+      return static_cast<uint64_t>(width) * height * 4;
+    }
+  } // namespace
+
+  std::optional<MappedFile> MappedFile::Open(const std::filesystem::path& path)
+  {
+    MappedFile file;
+
+#ifdef _WIN32
+    file.fileHandle = CreateFileW(path.c_str(),
+                                  GENERIC_READ,
+                                  FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                  nullptr,
+                                  OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL,
+                                  nullptr);
+    if (file.fileHandle == INVALID_HANDLE_VALUE)
+    {
+      file.fileHandle = nullptr;
+      return std::nullopt;
+    }
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file.fileHandle, &size) || size.QuadPart == 0)
+    {
+      return std::nullopt;
+    }
+
+    file.mappingHandle = CreateFileMappingW(file.fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!file.mappingHandle)
+    {
+      return std::nullopt;
+    }
+
+    file.data = static_cast<const std::byte*>(MapViewOfFile(file.mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!file.data)
+    {
+      return std::nullopt;
+    }
+    file.size = static_cast<size_t>(size.QuadPart);
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+      return std::nullopt;
+    }
+
+    struct stat fileStat{};
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+      close(fd);
+      return std::nullopt;
+    }
+
+    // The mapping keeps the file alive, so the descriptor isn't needed after this
+    void* mapped = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+    {
+      return std::nullopt;
+    }
+
+    file.data = static_cast<const std::byte*>(mapped);
+    file.size = static_cast<size_t>(fileStat.st_size);
+#endif
+
+    return file;
+  }
+
+  MappedFile::MappedFile(MappedFile&& old) noexcept
+    : data(std::exchange(old.data, nullptr)),
+      size(std::exchange(old.size, 0))
+#ifdef _WIN32
+      ,
+      fileHandle(std::exchange(old.fileHandle, nullptr)),
+      mappingHandle(std::exchange(old.mappingHandle, nullptr))
+#endif
+  {
+  }
+
+  MappedFile& MappedFile::operator=(MappedFile&& old) noexcept
+  {
+    if (&old == this)
+      return *this;
+    this->~MappedFile();
+    return *new (this) MappedFile(std::move(old));
+  }
+
+  MappedFile::~MappedFile()
+  {
+#ifdef _WIN32
+    if (data)
+    {
+      UnmapViewOfFile(data);
+    }
+    if (mappingHandle)
+    {
+      CloseHandle(mappingHandle);
+    }
+    if (fileHandle)
+    {
+      CloseHandle(fileHandle);
+    }
+#else
+    if (data)
+    {
+      munmap(const_cast<std::byte*>(data), size);
+    }
+#endif
+  }
+
+  TextureCache::TextureCache(std::filesystem::path directory) : directory(std::move(directory)) {}
+
+  uint64_t TextureCache::Hash(std::span<const std::byte> data, uint64_t seed)
+  {
+    // 64-bit FNV-1a
+    uint64_t hash = seed;
+    for (auto byte : data)
+    {
+      hash ^= static_cast<uint64_t>(byte);
+      hash *= 0x100000001b3;
+    }
+    return hash;
+  }
+
+  std::optional<TextureCacheEntry> TextureCache::Load(uint64_t hash, Fwog::Format format) const
+  {
+    auto file = MappedFile::Open(GetEntryPath(hash, format));
+    if (!file)
+    {
+      return std::nullopt;
+    }
+
+    // Entries may have been written by an older version, or been truncated because the disk was full, so everything is
+    // validated before it is used
+    const auto data = file->Data();
+    EntryHeader header{};
+    if (data.size() < sizeof(header))
+    {
+      return std::nullopt;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    if (header.magic != entryMagic || header.version != entryVersion || header.hash != hash ||
+        header.format != static_cast<uint32_t>(format) || header.width == 0 || header.height == 0 ||
+        header.levelCount == 0 || header.levelCount > GetMaxLevelCount(header.width, header.height) ||
+        data.size() < sizeof(EntryHeader) + header.levelCount * sizeof(LevelHeader))
+    {
+      return std::nullopt;
+    }
+
+    std::vector<std::span<const std::byte>> levels;
+    levels.reserve(header.levelCount);
+    for (uint32_t i = 0; i < header.levelCount; i++)
+    {
+      LevelHeader level{};
+      std::memcpy(&level, data.data() + sizeof(EntryHeader) + i * sizeof(LevelHeader), sizeof(level));
+      if (level.size != GetLevelSize(format, header.width, header.height, i) || level.offset > data.size() ||
+          level.size > data.size() - level.offset)
+      {
+        return std::nullopt;
+      }
+      levels.emplace_back(data.subspan(level.offset, level.size));
+    }
+
+    return TextureCacheEntry{
+      .format = format,
+      .width = header.width,
+      .height = header.height,
+      .levels = std::move(levels),
+      .file = std::move(*file),
+    };
+  }
+
+  bool TextureCache::Store(uint64_t hash,
+                           Fwog::Format format,
+                           uint32_t width,
+                           uint32_t height,
+                           std::span<const std::span<const std::byte>> levels) const
+  {
+    FWOG_ASSERT(width > 0 && height > 0);
+    FWOG_ASSERT(!levels.empty() && levels.size() <= GetMaxLevelCount(width, height));
+    for (uint32_t i = 0; i < levels.size(); i++)
+    {
+      FWOG_ASSERT(levels[i].size() == GetLevelSize(format, width, height, i));
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec)
+    {
+      return false;
+    }
+
+    const auto header = EntryHeader{
+      .magic = entryMagic,
+      .version = entryVersion,
+      .hash = hash,
+      .format = static_cast<uint32_t>(format),
+      .width = width,
+      .height = height,
+      .levelCount = static_cast<uint32_t>(levels.size()),
+    };
+
+    std::vector<LevelHeader> levelHeaders;
+    uint64_t offset = sizeof(EntryHeader) + levels.size() * sizeof(LevelHeader);
+    for (const auto& level : levels)
+    {
+      levelHeaders.push_back({.offset = offset, .size = level.size()});
+      offset += level.size();
+    }
+
+    // Another thread may be writing the same entry, so each thread writes to its own temporary file
+    const auto path = GetEntryPath(hash, format);
+    auto tempPath = path;
+    tempPath += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+
+    {
+      std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+      stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      stream.write(reinterpret_cast<const char*>(levelHeaders.data()), levelHeaders.size() * sizeof(LevelHeader));
+      for (const auto& level : levels)
+      {
+        stream.write(reinterpret_cast<const char*>(level.data()), level.size());
+      }
+
+      if (!stream.flush())
+      {
+        stream.close();
+        std::filesystem::remove(tempPath, ec);
+        return false;
+      }
+    }
+
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec)
+    {
+      std::filesystem::remove(tempPath, ec);
+      return false;
+    }
+
+    return true;
+  }
+
+  std::filesystem::path TextureCache::GetEntryPath(uint64_t hash, Fwog::Format format) const
+  {
+    char name[64];
+    std::snprintf(name,
+                  sizeof(name),
+                  "%016llx_%u.fwogtex",
+                  static_cast<unsigned long long>(hash),
+                  static_cast<unsigned>(format));
+    return directory / name;
+  }
+} // namespace Utility
@@ -0,0 +1,88 @@
+#pragma once
+#include <Fwog/BasicTypes.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace Utility
+{
+  // A read-only, memory-mapped file
+  class MappedFile
+  {
+  public:
+    // Returns nullopt if the file doesn't exist, is empty, or couldn't be mapped
+    static std::optional<MappedFile> Open(const std::filesystem::path& path);
+
+    MappedFile(MappedFile&& old) noexcept;
+    MappedFile& operator=(MappedFile&& old) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    [[nodiscard]] std::span<const std::byte> Data() const
+    {
+      return {data, size};
+    }
+
+  private:
+    MappedFile() = default;
+
+    const std::byte* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+  };
+
+  // An image that is ready to be uploaded. The level data lives in the mapped cache file
+  struct TextureCacheEntry
+  {
+    Fwog::Format format{};
+    uint32_t width{};
+    uint32_t height{};
+
+    // Tightly packed data of each mip level, starting with the base level. Images that are not block-compressed may
+    // only store the base level, in which case the rest of the mip chain is generated after uploading
+    std::vector<std::span<const std::byte>> levels;
+
+    MappedFile file;
+  };
+
+  // A content-addressed cache of decoded and transcoded images.
+  //
+  // Entries are keyed by a hash of the encoded image and the format it was decoded to, so an image that changes gets a
+  // new entry instead of a stale one. Entries are never evicted: delete the directory to clear the cache.
+  //
+  // The cache may be used from multiple threads. Entries are written to a temporary file that is then renamed, so a
+  // partially written entry is never read.
+  class TextureCache
+  {
+  public:
+    static constexpr uint64_t hashSeed = 0xcbf29ce484222325;
+
+    explicit TextureCache(std::filesystem::path directory);
+
+    // Pass a previous result as the seed to add more data (such as encoding settings) to a key
+    [[nodiscard]] static uint64_t Hash(std::span<const std::byte> data, uint64_t seed = hashSeed);
+
+    // Returns nullopt if there is no valid entry for the image
+    [[nodiscard]] std::optional<TextureCacheEntry> Load(uint64_t hash, Fwog::Format format) const;
+
+    // Returns false if the entry couldn't be written. This is not fatal: the image will be decoded again next time
+    bool Store(uint64_t hash,
+               Fwog::Format format,
+               uint32_t width,
+               uint32_t height,
+               std::span<const std::span<const std::byte>> levels) const;
+
+  private:
+    [[nodiscard]] std::filesystem::path GetEntryPath(uint64_t hash, Fwog::Format format) const;
+
+    std::filesystem::path directory;
+  };
+} // namespace Utility
@@ -0,0 +1,167 @@
+#include "TiledDeferredShading.h"
+#include "Application.h"
+
+#include <Fwog/Rendering.h>
+#include <Fwog/Shader.h>
+
+#include <stb_include.h>
+
+#include <glm/matrix.hpp>
+
+#include <cstdlib>
+#include <span>
+#include <string>
+
+static std::string LoadFileWithInclude(std::string_view path, std::string_view defines = {})
+{
+  char error[256] = {};
+  char* included = stb_include_string(Application::LoadFile(path).data(), nullptr, "shaders", "", error);
+  std::string includedStr = included;
+  free(included);
+
+  // Defines must come after the #version directive
+  includedStr.insert(includedStr.find('\n') + 1, defines);
+  return includedStr;
+}
+
+static Fwog::ComputePipeline CreateClassifyTilesPipeline()
+{
+  auto cs = Fwog::Shader(Fwog::PipelineStage::COMPUTE_SHADER,
+                         LoadFileWithInclude("shaders/tiled/ClassifyTiles.comp.glsl"));
+  return Fwog::ComputePipeline({.name = "Classify tiles", .shader = &cs});
+}
+
+static Fwog::ComputePipeline CreateShadeTilesPipeline(uint32_t tileClass)
+{
+  const auto defines = "#define TILE_CLASS " + std::to_string(tileClass) + "\n";
+  auto cs = Fwog::Shader(Fwog::PipelineStage::COMPUTE_SHADER,
+                         LoadFileWithInclude("shaders/tiled/ShadeTiles.comp.glsl", defines));
+  return Fwog::ComputePipeline({.name = "Shade tiles", .shader = &cs});
+}
+
+namespace Tiled
+{
+  TiledDeferredShading::TiledDeferredShading()
+    : uniformBuffer(Fwog::BufferStorageFlag::DYNAMIC_STORAGE),
+      tileDispatchBuffer(TileClass::COUNT, Fwog::BufferStorageFlag::DYNAMIC_STORAGE),
+      classifyTilesPipeline(CreateClassifyTilesPipeline()),
+      shadeTilesPipelines{
+        CreateShadeTilesPipeline(0),
+        CreateShadeTilesPipeline(TileClass::SUN_LIT),
+        CreateShadeTilesPipeline(TileClass::LOCAL_LIGHTS),
+        CreateShadeTilesPipeline(TileClass::SUN_LIT | TileClass::LOCAL_LIGHTS),
+      }
+  {
+  }
+
+  void TiledDeferredShading::SetResolution(uint32_t newWidth, uint32_t newHeight)
+  {
+    screenSize = {newWidth, newHeight};
+    tileCount = {(newWidth + tileSize - 1) / tileSize, (newHeight + tileSize - 1) / tileSize};
+
+    tileListsBuffer.emplace(TileClass::COUNT * GetTileCount());
+    tileLightCountsBuffer.emplace(GetTileCount());
+    tileLightsBuffer.emplace(maxLightsPerTile * GetTileCount());
+  }
+
+  void TiledDeferredShading::ClassifyTiles(const glm::mat4& view,
+                                           const glm::mat4& proj,
+                                           const glm::vec4& sunDir,
+                                           const Fwog::Texture& gNormal,
+                                           const Fwog::Texture& gDepth,
+                                           const Fwog::Buffer& lightBuffer,
+                                           uint32_t lightCount)
+  {
+    uniformBuffer.UpdateData(TileUniforms{
+      .view = view,
+      .invProj = glm::inverse(proj),
+      .sunDir = sunDir,
+      .screenSize = screenSize,
+      .tileCount = tileCount,
+      .lightCount = lightCount,
+#ifdef FWOG_DEFAULT_CLIP_DEPTH_RANGE_ZERO_TO_ONE
+      .depthZeroToOne = true,
+#else
+      .depthZeroToOne = false,
+#endif
+    });
+
+    std::array<Fwog::DispatchIndirectCommand, TileClass::COUNT> emptyDispatches;
+    emptyDispatches.fill({.groupCountX = 0, .groupCountY = 1, .groupCountZ = 1});
+    tileDispatchBuffer.UpdateData(std::span<const Fwog::DispatchIndirectCommand>(emptyDispatches));
+    droppedLightsBuffer.ClearSubData({.internalFormat = Fwog::Format::R32_UINT});
+
+    auto nearestSampler = Fwog::Sampler({
+      .minFilter = Fwog::Filter::NEAREST,
+      .magFilter = Fwog::Filter::NEAREST,
+    });
+
+    Fwog::BeginCompute("Classify tiles");
+    Fwog::Cmd::BindComputePipeline(classifyTilesPipeline);
+    Fwog::Cmd::BindSampledImage(0, gNormal, nearestSampler);
+    Fwog::Cmd::BindSampledImage(1, gDepth, nearestSampler);
+    Fwog::Cmd::BindUniformBuffer(4, uniformBuffer);
+    Fwog::Cmd::BindStorageBuffer(0, lightBuffer);
+    Fwog::Cmd::BindStorageBuffer(3, *tileListsBuffer);
+    Fwog::Cmd::BindStorageBuffer(4, *tileLightCountsBuffer);
+    Fwog::Cmd::BindStorageBuffer(5, *tileLightsBuffer);
+    Fwog::Cmd::BindStorageBuffer(6, tileDispatchBuffer);
+    Fwog::Cmd::BindStorageBuffer(7, droppedLightsBuffer);
+    Fwog::Cmd::Dispatch(tileCount.x, tileCount.y, 1);
+    Fwog::EndCompute();
+
+    // Make the tile lists visible to the shading pass, the indirect dispatches, and the readback of the counters
+    Fwog::MemoryBarrier(Fwog::MemoryBarrierBit::SHADER_STORAGE_BIT | Fwog::MemoryBarrierBit::COMMAND_BUFFER_BIT |
+                        Fwog::MemoryBarrierBit::BUFFER_UPDATE_BIT);
+
+    UpdateStats();
+  }
+
+  void TiledDeferredShading::ShadeTiles(Fwog::Texture& output,
+                                        const Fwog::Buffer& lightBuffer,
+                                        const glm::vec3& skyColor)
+  {
+    // Sky tiles and pixels are never written by the shading pass
+    output.ClearImage({
+      .format = Fwog::UploadFormat::RGB,
+      .type = Fwog::UploadType::FLOAT,
+      .data = &skyColor,
+    });
+
+    Fwog::Cmd::BindImage(0, output, 0);
+    Fwog::Cmd::BindUniformBuffer(4, uniformBuffer);
+    Fwog::Cmd::BindStorageBuffer(0, lightBuffer);
+    Fwog::Cmd::BindStorageBuffer(3, *tileListsBuffer);
+    Fwog::Cmd::BindStorageBuffer(4, *tileLightCountsBuffer);
+    Fwog::Cmd::BindStorageBuffer(5, *tileLightsBuffer);
+    for (uint32_t tileClass = 0; tileClass < TileClass::COUNT; tileClass++)
+    {
+      Fwog::Cmd::BindComputePipeline(shadeTilesPipelines[tileClass]);
+      Fwog::Cmd::DispatchIndirect(tileDispatchBuffer, tileClass * sizeof(Fwog::DispatchIndirectCommand));
+    }
+
+    Fwog::MemoryBarrier(Fwog::MemoryBarrierBit::IMAGE_ACCESS_BIT | Fwog::MemoryBarrierBit::TEXTURE_FETCH_BIT);
+  }
+
+  void TiledDeferredShading::UpdateStats()
+  {
+    if (pendingTileCounts && pendingTileCounts->IsReady() && pendingDroppedLights->IsReady())
+    {
+      const auto dispatches = pendingTileCounts->DataAs<Fwog::DispatchIndirectCommand>();
+      for (uint32_t tileClass = 0; tileClass < TileClass::COUNT; tileClass++)
+      {
+        stats.tilesPerClass[tileClass] = dispatches[tileClass].groupCountX;
+      }
+      stats.droppedLights = pendingDroppedLights->DataAs<uint32_t>()[0];
+      pendingTileCounts.reset();
+      pendingDroppedLights.reset();
+    }
+
+    // Only one readback is in flight at a time
+    if (!pendingTileCounts)
+    {
+      pendingTileCounts = Fwog::ReadbackBuffer(tileDispatchBuffer);
+      pendingDroppedLights = Fwog::ReadbackBuffer(droppedLightsBuffer);
+    }
+  }
+} // namespace Tiled
@@ -0,0 +1,111 @@
+#pragma once
+#include <Fwog/BasicTypes.h>
+#include <Fwog/Buffer.h>
+#include <Fwog/Pipeline.h>
+#include <Fwog/Readback.h>
+#include <Fwog/Texture.h>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+namespace Tiled
+{
+  // Bits of a tile's class (must match shaders/tiled/Common.h.glsl)
+  namespace TileClass
+  {
+    inline constexpr uint32_t SUN_LIT = 1;
+    inline constexpr uint32_t LOCAL_LIGHTS = 2;
+    inline constexpr uint32_t COUNT = 4;
+  } // namespace TileClass
+
+  struct TiledShadingStats
+  {
+    std::array<uint32_t, TileClass::COUNT> tilesPerClass;
+
+    // Lights that intersect a tile but were left out of its full list. Nonzero means that lighting is incorrect
+    uint32_t droppedLights;
+  };
+
+  // Compute-based deferred shading.
+  //
+  // The screen is divided into 16x16 pixel tiles. Each frame, after the g-buffer has been rendered:
+  // 1. ClassifyTiles finds the depth range of each tile, culls the local lights against it into a list in shared
+  //    memory, and checks whether any pixel faces the sun. Tiles are appended to a list for their class, which is
+  //    counted in an indirect dispatch command. Tiles that only contain sky are skipped.
+  // 2. ShadeTiles dispatches one shader permutation per class, so tiles that face away from the sun don't evaluate
+  //    shadows and tiles without lights don't loop over them.
+  //
+  // Shading uses the functions in shaders/DeferredPbrCommon.h.glsl, whose resources must be bound by the caller.
+  // Lights are read from a storage buffer of structs with the layout {vec4 position; vec3 intensity; float invRadius;}.
+  class TiledDeferredShading
+  {
+  public:
+    static constexpr uint32_t tileSize = 16;
+
+    // The maximum number of lights that can be assigned to a single tile (must match shaders/tiled/Common.h.glsl)
+    static constexpr uint32_t maxLightsPerTile = 256;
+
+    TiledDeferredShading();
+
+    void SetResolution(uint32_t newWidth, uint32_t newHeight);
+
+    // Input: the g-buffer of the scene and the projection (with any jitter) that it was rendered with
+    void ClassifyTiles(const glm::mat4& view,
+                       const glm::mat4& proj,
+                       const glm::vec4& sunDir,
+                       const Fwog::Texture& gNormal,
+                       const Fwog::Texture& gDepth,
+                       const Fwog::Buffer& lightBuffer,
+                       uint32_t lightCount);
+
+    // Writes the lighting of every non-sky pixel to output, which must be R11G11B10_FLOAT. Sky pixels are cleared to
+    // skyColor. Must be called in a compute scope, after binding the g-buffer samplers (0-5) and uniform buffers (0-2)
+    // of DeferredPbrCommon.h.glsl
+    void ShadeTiles(Fwog::Texture& output, const Fwog::Buffer& lightBuffer, const glm::vec3& skyColor);
+
+    // Gets the counts from a recent frame. The data is read back asynchronously, so it lags a few frames behind
+    [[nodiscard]] const TiledShadingStats& GetStats() const
+    {
+      return stats;
+    }
+
+    [[nodiscard]] uint32_t GetTileCount() const
+    {
+      return tileCount.x * tileCount.y;
+    }
+
+  private:
+    struct TileUniforms
+    {
+      glm::mat4 view;
+      glm::mat4 invProj;
+      glm::vec4 sunDir;
+      glm::uvec2 screenSize;
+      glm::uvec2 tileCount;
+      uint32_t lightCount;
+      uint32_t depthZeroToOne;
+    };
+
+    void UpdateStats();
+
+    glm::uvec2 screenSize{};
+    glm::uvec2 tileCount{};
+    Fwog::TypedBuffer<TileUniforms> uniformBuffer;
+    Fwog::TypedBuffer<Fwog::DispatchIndirectCommand> tileDispatchBuffer;
+    Fwog::TypedBuffer<uint32_t> droppedLightsBuffer;
+    std::optional<Fwog::TypedBuffer<uint32_t>> tileListsBuffer;
+    std::optional<Fwog::TypedBuffer<uint32_t>> tileLightCountsBuffer;
+    std::optional<Fwog::TypedBuffer<uint32_t>> tileLightsBuffer;
+    Fwog::ComputePipeline classifyTilesPipeline;
+    std::array<Fwog::ComputePipeline, TileClass::COUNT> shadeTilesPipelines;
+    std::optional<Fwog::ReadbackResult> pendingTileCounts;
+    std::optional<Fwog::ReadbackResult> pendingDroppedLights;
+    TiledShadingStats stats{};
+  };
+} // namespace Tiled
@@ -0,0 +1,179 @@
+#version 460 core
+
+// Builds a depth pyramid in the style of AMD's single pass downsampler (SPD).
+//
+// Each workgroup reduces a 64x64 tile of a source level into the six levels after it, keeping intermediate results in
+// shared memory. In single pass mode, the last workgroup to finish (detected with a global atomic counter) then
+// reduces level 6, which is at most 64x64 texels, into the remaining levels. Otherwise, the application dispatches
+// once per six levels.
+//
+// Defines injected by the application:
+// REDUCE_MIN, REDUCE_MAX, or REDUCE_MIN_MAX: the depth that each texel stores for its footprint
+// SINGLE_PASS: 1 if all 13 levels can be bound at once, 0 otherwise
+
+layout(local_size_x = 256) in;
+
+#if defined(REDUCE_MIN_MAX)
+  #define Value vec2
+  #define FORMAT rg32f
+  const Value NEUTRAL = Value(1.0, 0.0);
+  Value Reduce(Value a, Value b) { return Value(min(a.x, b.x), max(a.y, b.y)); }
+  Value FromTexel(vec4 texel) { return texel.xy; }
+  vec4 ToTexel(Value value) { return vec4(value, 0.0, 0.0); }
+#else
+  #define Value float
+  #define FORMAT r32f
+  #if defined(REDUCE_MIN)
+    const Value NEUTRAL = 1.0;
+    Value Reduce(Value a, Value b) { return min(a, b); }
+  #else
+    const Value NEUTRAL = 0.0;
+    Value Reduce(Value a, Value b) { return max(a, b); }
+  #endif
+  Value FromTexel(vec4 texel) { return texel.x; }
+  vec4 ToTexel(Value value) { return vec4(value); }
+#endif
+
+#if SINGLE_PASS
+  #define IMAGE_COUNT 13
+#else
+  #define IMAGE_COUNT 7
+#endif
+
+layout(binding = 0) uniform sampler2D s_depth;
+
+// i_levels[0] is the source level of the dispatch, and the rest are the levels after it
+layout(binding = 0, FORMAT) uniform coherent image2D i_levels[IMAGE_COUNT];
+
+layout(binding = 0, std140) uniform Uniforms
+{
+  ivec2 depthSize;
+  uint readDepth;      // Whether i_levels[0] is level 0 of the pyramid, which must first be copied from s_depth
+  uint levelCount;     // The number of bound levels, including the source level
+  uint workgroupCount;
+}uniforms;
+
+layout(binding = 0, std430) coherent buffer Counter
+{
+  uint finishedWorkgroups;
+};
+
+shared Value s_values[16][16];
+shared bool s_isLastWorkgroup;
+
+Value Reduce4(Value a, Value b, Value c, Value d)
+{
+  return Reduce(Reduce(a, b), Reduce(c, d));
+}
+
+void Store(uint level, ivec2 coord, Value value)
+{
+  if (level < uniforms.levelCount && all(lessThan(coord, imageSize(i_levels[level]))))
+  {
+    imageStore(i_levels[level], coord, ToTexel(value));
+  }
+}
+
+Value Load(uint level, ivec2 coord)
+{
+  if (level == 0 && uniforms.readDepth != 0)
+  {
+    // Level 0 is padded to a power of two. The padding must not affect the result
+    Value value = all(lessThan(coord, uniforms.depthSize)) ? Value(texelFetch(s_depth, coord, 0).r) : NEUTRAL;
+    Store(0, coord, value);
+    return value;
+  }
+
+  // Non-square pyramids have levels that are one texel wide or tall, but are still reduced in 2x2 blocks
+  if (any(greaterThanEqual(coord, imageSize(i_levels[level]))))
+  {
+    return NEUTRAL;
+  }
+
+  return FromTexel(imageLoad(i_levels[level], coord));
+}
+
+// Reduces a 64x64 tile of srcLevel into the six levels after it
+void ReduceTile(uint srcLevel, ivec2 tile)
+{
+  uint index = gl_LocalInvocationIndex;
+  ivec2 thread = ivec2(index % 16, index / 16);
+
+  // Each invocation reduces a 4x4 block of the source into 2x2 texels of the first level, then one texel of the second
+  Value quad[4];
+  for (int i = 0; i < 4; i++)
+  {
+    ivec2 offset = ivec2(i % 2, i / 2);
+    ivec2 src = tile * 64 + thread * 4 + offset * 2;
+    quad[i] = Reduce4(Load(srcLevel, src),
+                      Load(srcLevel, src + ivec2(1, 0)),
+                      Load(srcLevel, src + ivec2(0, 1)),
+                      Load(srcLevel, src + ivec2(1, 1)));
+    Store(srcLevel + 1, tile * 32 + thread * 2 + offset, quad[i]);
+  }
+
+  Value value = Reduce4(quad[0], quad[1], quad[2], quad[3]);
+  Store(srcLevel + 2, tile * 16 + thread, value);
+  s_values[thread.y][thread.x] = value;
+
+  // The remaining levels (8x8 to 1x1 texels per tile) are reduced in shared memory
+  for (uint level = 3, size = 8; level <= 6; level++, size /= 2)
+  {
+    barrier();
+
+    ivec2 coord = ivec2(index % size, index / size);
+    bool isActive = index < size * size;
+    if (isActive)
+    {
+      ivec2 src = coord * 2;
+      value = Reduce4(s_values[src.y][src.x],
+                      s_values[src.y][src.x + 1],
+                      s_values[src.y + 1][src.x],
+                      s_values[src.y + 1][src.x + 1]);
+      Store(srcLevel + level, tile * int(size) + coord, value);
+    }
+
+    barrier();
+
+    if (isActive)
+    {
+      s_values[coord.y][coord.x] = value;
+    }
+  }
+}
+
+void main()
+{
+  ReduceTile(0, ivec2(gl_WorkGroupID.xy));
+
+#if SINGLE_PASS
+  if (uniforms.levelCount <= 7)
+  {
+    return;
+  }
+
+  // Make this workgroup's writes to level 6 visible before announcing that it has finished
+  memoryBarrierImage();
+  barrier();
+
+  if (gl_LocalInvocationIndex == 0)
+  {
+    s_isLastWorkgroup = atomicAdd(finishedWorkgroups, 1) == uniforms.workgroupCount - 1;
+  }
+
+  barrier();
+
+  if (!s_isLastWorkgroup)
+  {
+    return;
+  }
+
+  // Every other workgroup has finished, so the counter can be reset for the next build
+  if (gl_LocalInvocationIndex == 0)
+  {
+    finishedWorkgroups = 0;
+  }
+
+  ReduceTile(6, ivec2(0));
+#endif
+}
@@ -0,0 +1,92 @@
+#ifndef CLUSTERED_COMMON_H
+#define CLUSTERED_COMMON_H
+
+// The view frustum is divided into a grid of clusters (froxels) that are uniform in screen space and exponentially
+// distributed in view depth. Each cluster that contains a pixel stores a range of lightIndices for the lights that
+// affect it.
+
+layout(binding = 3, std140) uniform ClusterUniforms
+{
+  mat4 view;
+  mat4 invProj;
+  uvec3 gridSize;
+  uint lightCount;
+  uvec2 screenSize;
+  float zNear;
+  float zFar;
+  uint depthZeroToOne;
+  uint lightIndexCapacity;
+}clusterUniforms;
+
+struct Light
+{
+  vec4 position;
+  vec3 intensity;
+  float invRadius;
+};
+
+layout(binding = 0, std430) readonly buffer LightBuffer
+{
+  Light lights[];
+}lightBuffer;
+
+// x = offset into lightIndices, y = number of lights
+layout(binding = 1, std430) buffer ClusterLightsBuffer
+{
+  uvec2 clusterLights[];
+};
+
+// droppedLightCount counts the lights that intersect a cluster but didn't fit in its list
+layout(binding = 2, std430) buffer LightIndexBuffer
+{
+  uint lightIndexCount;
+  uint droppedLightCount;
+  uint lightIndices[];
+};
+
+uint GetClusterCount()
+{
+  return clusterUniforms.gridSize.x * clusterUniforms.gridSize.y * clusterUniforms.gridSize.z;
+}
+
+// Returns the positive distance along the view axis of a depth buffer sample
+float GetViewDistance(ivec2 pixel, float depth)
+{
+  vec2 uv = (vec2(pixel) + 0.5) / vec2(clusterUniforms.screenSize);
+  float ndcZ = clusterUniforms.depthZeroToOne != 0 ? depth : depth * 2.0 - 1.0;
+  vec4 view = clusterUniforms.invProj * vec4(uv * 2.0 - 1.0, ndcZ, 1.0);
+  return -view.z / view.w;
+}
+
+// The view distance of the near side of a depth slice
+float GetSliceDistance(uint slice)
+{
+  float t = float(slice) / float(clusterUniforms.gridSize.z);
+  return clusterUniforms.zNear * pow(clusterUniforms.zFar / clusterUniforms.zNear, t);
+}
+
+uint GetClusterIndex(uvec3 cluster)
+{
+  return cluster.x + clusterUniforms.gridSize.x * (cluster.y + clusterUniforms.gridSize.y * cluster.z);
+}
+
+uvec3 GetClusterCoord(uint index)
+{
+  uvec2 size = clusterUniforms.gridSize.xy;
+  return uvec3(index % size.x, (index / size.x) % size.y, index / (size.x * size.y));
+}
+
+// Must be computed identically in every pass that reads or writes per-cluster data, so integer math is used wherever
+// possible
+uint GetClusterIndex(ivec2 pixel, float depth)
+{
+  uvec2 xy = uvec2(pixel) * clusterUniforms.gridSize.xy / clusterUniforms.screenSize;
+
+  float distance = GetViewDistance(pixel, depth);
+  float slice = log(distance / clusterUniforms.zNear) / log(clusterUniforms.zFar / clusterUniforms.zNear);
+  uint z = uint(clamp(slice * float(clusterUniforms.gridSize.z), 0.0, float(clusterUniforms.gridSize.z - 1)));
+
+  return GetClusterIndex(uvec3(min(xy, clusterUniforms.gridSize.xy - 1), z));
+}
+
+#endif // CLUSTERED_COMMON_H
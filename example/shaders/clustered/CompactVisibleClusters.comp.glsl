@@ -0,0 +1,34 @@
+#version 460 core
+
+#include "Common.h.glsl"
+
+layout(local_size_x = 64) in;
+
+layout(binding = 3, std430) readonly buffer ClusterFlagsBuffer
+{
+  uint clusterFlags[];
+};
+
+layout(binding = 4, std430) writeonly buffer VisibleClustersBuffer
+{
+  uint visibleClusters[];
+};
+
+// An indirect dispatch command with one workgroup per visible cluster. y and z are always 1
+layout(binding = 5, std430) buffer CullDispatchBuffer
+{
+  uint groupCountX;
+  uint groupCountY;
+  uint groupCountZ;
+};
+
+void main()
+{
+  uint index = gl_GlobalInvocationID.x;
+  if (index >= GetClusterCount() || clusterFlags[index] == 0)
+  {
+    return;
+  }
+
+  visibleClusters[atomicAdd(groupCountX, 1)] = index;
+}
@@ -0,0 +1,100 @@
+#version 460 core
+
+#include "Common.h.glsl"
+
+#define WORKGROUP_SIZE 64
+#define MAX_LIGHTS_PER_CLUSTER 256
+
+layout(local_size_x = WORKGROUP_SIZE) in;
+
+layout(binding = 4, std430) readonly buffer VisibleClustersBuffer
+{
+  uint visibleClusters[];
+};
+
+shared uint s_lightCount;
+shared uint s_lightOffset;
+shared uint s_lights[MAX_LIGHTS_PER_CLUSTER];
+
+// Returns the point along the view ray through an NDC position that is a certain distance along the view axis
+vec3 GetViewPosition(vec2 ndc, float distance)
+{
+  vec4 point = clusterUniforms.invProj * vec4(ndc, 0.0, 1.0);
+  point.xyz /= point.w;
+  return point.xyz * (distance / -point.z);
+}
+
+bool SphereIntersectsBox(vec3 center, float radius, vec3 boxMin, vec3 boxMax)
+{
+  vec3 closest = clamp(center, boxMin, boxMax);
+  vec3 d = center - closest;
+  return dot(d, d) <= radius * radius;
+}
+
+// Each workgroup builds the light list of one visible cluster
+void main()
+{
+  uint clusterIndex = visibleClusters[gl_WorkGroupID.x];
+  uvec3 cluster = GetClusterCoord(clusterIndex);
+
+  // View-space bounds of the cluster
+  vec2 ndcMin = vec2(cluster.xy) / vec2(clusterUniforms.gridSize.xy) * 2.0 - 1.0;
+  vec2 ndcMax = vec2(cluster.xy + 1) / vec2(clusterUniforms.gridSize.xy) * 2.0 - 1.0;
+  float nearDistance = GetSliceDistance(cluster.z);
+  float farDistance = GetSliceDistance(cluster.z + 1);
+
+  vec3 boxMin = vec3(1e30);
+  vec3 boxMax = vec3(-1e30);
+  for (uint i = 0; i < 8; i++)
+  {
+    vec2 ndc = vec2((i & 1) != 0 ? ndcMax.x : ndcMin.x, (i & 2) != 0 ? ndcMax.y : ndcMin.y);
+    vec3 corner = GetViewPosition(ndc, (i & 4) != 0 ? farDistance : nearDistance);
+    boxMin = min(boxMin, corner);
+    boxMax = max(boxMax, corner);
+  }
+
+  if (gl_LocalInvocationIndex == 0)
+  {
+    s_lightCount = 0;
+  }
+
+  barrier();
+
+  for (uint i = gl_LocalInvocationIndex; i < clusterUniforms.lightCount; i += WORKGROUP_SIZE)
+  {
+    Light light = lightBuffer.lights[i];
+    vec3 center = (clusterUniforms.view * vec4(light.position.xyz, 1.0)).xyz;
+    if (SphereIntersectsBox(center, 1.0 / light.invRadius, boxMin, boxMax))
+    {
+      uint slot = atomicAdd(s_lightCount, 1);
+      if (slot < MAX_LIGHTS_PER_CLUSTER)
+      {
+        s_lights[slot] = i;
+      }
+    }
+  }
+
+  barrier();
+
+  // Allocate a contiguous range of the global index list. Lights that don't fit are dropped and counted
+  if (gl_LocalInvocationIndex == 0)
+  {
+    uint count = min(s_lightCount, MAX_LIGHTS_PER_CLUSTER);
+    uint offset = atomicAdd(lightIndexCount, count);
+    count = min(count, clusterUniforms.lightIndexCapacity - min(offset, clusterUniforms.lightIndexCapacity));
+    if (count < s_lightCount)
+    {
+      atomicAdd(droppedLightCount, s_lightCount - count);
+    }
+    clusterLights[clusterIndex] = uvec2(offset, count);
+    s_lightOffset = offset;
+    s_lightCount = count;
+  }
+
+  barrier();
+
+  for (uint i = gl_LocalInvocationIndex; i < s_lightCount; i += WORKGROUP_SIZE)
+  {
+    lightIndices[s_lightOffset + i] = s_lights[i];
+  }
+}
@@ -1,6 +1,32 @@
-layout(local_size_x = 64) in;
+#version 460 core
 
+#include "Common.h.glsl"
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0) uniform sampler2D s_depth;
+
+layout(binding = 3, std430) writeonly buffer ClusterFlagsBuffer
+{
+  uint clusterFlags[];
+};
+
+// Flags every cluster that contains at least one pixel, so lights are only culled for clusters that will be shaded
 void main()
 {
-    
-}
\ No newline at end of file
+  ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(pixel, ivec2(clusterUniforms.screenSize))))
+  {
+    return;
+  }
+
+  float depth = texelFetch(s_depth, pixel, 0).x;
+
+  // The sky is not shaded
+  if (depth == 1.0)
+  {
+    return;
+  }
+
+  clusterFlags[GetClusterIndex(pixel, depth)] = 1;
+}
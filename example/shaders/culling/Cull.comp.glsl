@@ -0,0 +1,174 @@
+#version 460 core
+
+layout(local_size_x = 64) in;
+
+struct DrawIndexedIndirectCommand
+{
+  uint indexCount;
+  uint instanceCount;
+  uint firstIndex;
+  int vertexOffset;
+  uint firstInstance;
+};
+
+struct CullObject
+{
+  mat4 model;
+  vec4 boxOffset;
+  vec4 boxHalfExtent;
+};
+
+layout(binding = 0, std140) uniform CullingUniforms
+{
+  mat4 viewProj;
+  uvec2 depthSize; // The pyramid's level 0 is padded to a power of two, so this may be smaller
+  uint hizLevels;
+  uint objectCount;
+  uint isLatePhase;
+  uint depthZeroToOne;
+  uint frustumCulling;
+  uint occlusionCulling;
+}uniforms;
+
+layout(binding = 0) uniform sampler2D s_hiz;
+
+layout(binding = 0, std430) readonly restrict buffer ObjectsBuffer
+{
+  CullObject objects[];
+};
+
+// One command for every object, in the same order as 'objects'.
+layout(binding = 1, std430) readonly restrict buffer SourceCommandsBuffer
+{
+  DrawIndexedIndirectCommand sourceCommands[];
+};
+
+// Whether each object was visible at the end of the previous frame.
+layout(binding = 2, std430) restrict buffer VisibilityBuffer
+{
+  uint visibility[];
+};
+
+layout(binding = 3, std430) writeonly restrict buffer DrawCommandsBuffer
+{
+  DrawIndexedIndirectCommand drawCommands[];
+};
+
+layout(binding = 4, std430) restrict buffer DrawCountBuffer
+{
+  uint drawCount;
+};
+
+// Returns false if the box is entirely outside one of the frustum planes.
+// If no corner is behind the camera, the box's screen-space bounds and nearest depth are also computed.
+bool ProjectBox(CullObject object, out vec2 uvMin, out vec2 uvMax, out float nearestDepth, out bool isBehindCamera)
+{
+  mat4 modelViewProj = uniforms.viewProj * object.model;
+  uvMin = vec2(1.0);
+  uvMax = vec2(0.0);
+  nearestDepth = 1.0;
+  isBehindCamera = false;
+
+  // One bit per plane (-x, +x, -y, +y, near, far). A bit stays set only if every corner is outside that plane
+  uint outsideAll = 0x3F;
+  for (uint c = 0; c < 8; c++)
+  {
+    vec3 cornerSign = vec3((c & 1) != 0 ? 1.0 : -1.0, (c & 2) != 0 ? 1.0 : -1.0, (c & 4) != 0 ? 1.0 : -1.0);
+    vec4 clip = modelViewProj * vec4(object.boxOffset.xyz + object.boxHalfExtent.xyz * cornerSign, 1.0);
+
+    float nearPlane = uniforms.depthZeroToOne != 0 ? 0.0 : -clip.w;
+    uint outside = 0;
+    outside |= clip.x < -clip.w ? 1u : 0u;
+    outside |= clip.x > clip.w ? 2u : 0u;
+    outside |= clip.y < -clip.w ? 4u : 0u;
+    outside |= clip.y > clip.w ? 8u : 0u;
+    outside |= clip.z < nearPlane ? 16u : 0u;
+    outside |= clip.z > clip.w ? 32u : 0u;
+    outsideAll &= outside;
+
+    if (clip.w <= 0.0)
+    {
+      isBehindCamera = true;
+      continue;
+    }
+
+    vec3 ndc = clip.xyz / clip.w;
+    vec2 uv = ndc.xy * 0.5 + 0.5;
+    uvMin = min(uvMin, uv);
+    uvMax = max(uvMax, uv);
+    nearestDepth = min(nearestDepth, uniforms.depthZeroToOne != 0 ? ndc.z : ndc.z * 0.5 + 0.5);
+  }
+
+  return outsideAll == 0;
+}
+
+// Returns true if the box's screen-space bounds are entirely behind the depth stored in the Hi-Z pyramid
+bool IsOccluded(vec2 uvMin, vec2 uvMax, float nearestDepth)
+{
+  ivec2 size = ivec2(uniforms.depthSize);
+  ivec2 pixelMin = clamp(ivec2(clamp(uvMin, 0.0, 1.0) * size), ivec2(0), size - 1);
+  ivec2 pixelMax = clamp(ivec2(clamp(uvMax, 0.0, 1.0) * size), ivec2(0), size - 1);
+
+  // Choose the level where the bounds span at most 2x2 texels
+  ivec2 extent = pixelMax - pixelMin + 1;
+  int level = int(ceil(log2(float(max(extent.x, extent.y)))));
+  level = clamp(level, 0, int(uniforms.hizLevels) - 1);
+
+  ivec2 levelSize = textureSize(s_hiz, level);
+  ivec2 texelMin = min(pixelMin >> level, levelSize - 1);
+  ivec2 texelMax = min(pixelMax >> level, levelSize - 1);
+
+  float d00 = texelFetch(s_hiz, texelMin, level).r;
+  float d10 = texelFetch(s_hiz, ivec2(texelMax.x, texelMin.y), level).r;
+  float d01 = texelFetch(s_hiz, ivec2(texelMin.x, texelMax.y), level).r;
+  float d11 = texelFetch(s_hiz, texelMax, level).r;
+  float farthestDepth = max(max(d00, d10), max(d01, d11));
+
+  return nearestDepth > farthestDepth;
+}
+
+void main()
+{
+  uint i = gl_GlobalInvocationID.x;
+  if (i >= uniforms.objectCount)
+  {
+    return;
+  }
+
+  vec2 uvMin;
+  vec2 uvMax;
+  float nearestDepth;
+  bool isBehindCamera;
+  bool isVisible = ProjectBox(objects[i], uvMin, uvMax, nearestDepth, isBehindCamera) || uniforms.frustumCulling == 0;
+
+  bool wasVisible = visibility[i] != 0;
+
+  if (uniforms.isLatePhase == 0)
+  {
+    // Early phase: draw what was visible last frame, so its depth can be used to test everything else
+    if (isVisible && wasVisible)
+    {
+      DrawIndexedIndirectCommand command = sourceCommands[i];
+      command.instanceCount = 1;
+      command.firstInstance = i;
+      drawCommands[atomicAdd(drawCount, 1)] = command;
+    }
+    return;
+  }
+
+  // Late phase: test against the pyramid built from the early phase's depth and draw newly disoccluded objects
+  if (isVisible && uniforms.occlusionCulling != 0 && !isBehindCamera)
+  {
+    isVisible = !IsOccluded(uvMin, uvMax, nearestDepth);
+  }
+
+  if (isVisible && !wasVisible)
+  {
+    DrawIndexedIndirectCommand command = sourceCommands[i];
+    command.instanceCount = 1;
+    command.firstInstance = i;
+    drawCommands[atomicAdd(drawCount, 1)] = command;
+  }
+
+  visibility[i] = isVisible ? 1u : 0u;
+}
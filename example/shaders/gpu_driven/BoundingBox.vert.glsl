@@ -14,8 +14,8 @@ vec3 CreateCube(in uint vertexID)
 
 void main()
 {
-  uint i = objectIndices.array[gl_BaseInstance + gl_InstanceID];
-  v_drawID = gl_BaseInstance + gl_InstanceID;
+  uint i = gl_BaseInstance + gl_InstanceID;
+  v_drawID = i;
   vec3 a_pos = CreateCube(gl_VertexID) - .5; // gl_VertexIndex for Vulkan
   ObjectUniforms obj = objects[i];
   a_pos *= boundingBoxes[i].halfExtent * 2.0 + 1e-1;
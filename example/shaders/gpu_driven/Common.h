@@ -13,7 +13,8 @@ struct Material
 {
   uint flags;
   float alphaCutoff;
-  uvec2 baseColorTextureHandle;
+  uint baseColorTextureIndex;
+  uint baseColorLayer; // Only used without bindless textures
   vec4 baseColorFactor;
 };
 
@@ -57,18 +58,10 @@ layout(binding = 2, std430) readonly restrict buffer BoundingBoxesBuffer
   BoundingBox boundingBoxes[];
 };
 
-// The indices of objects that were not culled in the initial frustum culling pass.
-// They should be used to index 'objects' and 'boundingBoxes'
-layout(binding = 3, std430) readonly restrict buffer ObjectIndicesBuffer
+// Bindless texture handles. Indexed with material.baseColorTextureIndex, if bindless textures are supported
+layout(binding = 4, std430) readonly restrict buffer TextureTableBuffer
 {
-  uint count;
-  uint array[];
-}objectIndices;
-
-// The draw commands generated by the frustum culling pass.
-layout(binding = 4, std430) writeonly restrict buffer DrawCommandsBuffer
-{
-  DrawIndexedIndirectCommand drawCommands[];
+  uvec2 textureHandles[];
 };
 
 #endif // GPU_COMMON_H
\ No newline at end of file
@@ -0,0 +1,47 @@
+#version 460 core
+#extension GL_GOOGLE_include_directive : enable
+
+// Used instead of SceneForward.frag.glsl when bindless textures are not supported. MAX_TEXTURE_ARRAYS is defined by
+// the application
+
+#include "Common.h"
+
+layout(location = 0) in vec3 v_position;
+layout(location = 1) in vec3 v_normal;
+layout(location = 2) in vec2 v_uv;
+layout(location = 3) in flat uint v_materialIdx;
+
+layout(location = 0) out vec4 o_color;
+
+// Indexed with material.baseColorTextureIndex, and material.baseColorLayer selects the layer. Each draw of a
+// multi-draw is its own invocation group, so the index is dynamically uniform
+layout(binding = 0) uniform sampler2DArray s_baseColorArrays[MAX_TEXTURE_ARRAYS];
+
+void main()
+{
+  Material material = materials[v_materialIdx];
+
+  vec4 color = material.baseColorFactor.rgba;
+  if ((material.flags & HAS_BASE_COLOR_TEXTURE) != 0)
+  {
+    vec3 uvw = vec3(v_uv, float(material.baseColorLayer));
+    color *= texture(s_baseColorArrays[material.baseColorTextureIndex], uvw).rgba;
+  }
+  
+  if (color.a < material.alphaCutoff)
+  {
+    discard;
+  }
+
+  vec3 albedo = color.rgb;
+  vec3 normal = normalize(v_normal);
+  
+  vec3 viewDir = normalize(globalUniforms.cameraPos.xyz - v_position);
+  float VoN = max(0.0, dot(viewDir, normal));
+  vec3 diffuse = albedo * VoN;
+
+  vec3 ambient = vec3(.1) * albedo;
+  vec3 finalColor = diffuse + ambient;
+
+  o_color = vec4(finalColor, 1.0);
+}
\ No newline at end of file
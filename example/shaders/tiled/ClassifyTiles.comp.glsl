@@ -0,0 +1,136 @@
+#version 460 core
+
+#include "tiled/Common.h.glsl"
+
+layout(local_size_x = TILE_SIZE, local_size_y = TILE_SIZE) in;
+
+layout(binding = 0) uniform sampler2D s_gNormal;
+layout(binding = 1) uniform sampler2D s_gDepth;
+
+// One indirect dispatch command {groupCountX, groupCountY, groupCountZ} per tile class
+layout(binding = 6, std430) buffer TileDispatchBuffer
+{
+  uint tileDispatch[];
+};
+
+// Counts the lights that intersect a tile but didn't fit in its list
+layout(binding = 7, std430) buffer DroppedLightsBuffer
+{
+  uint droppedLightCount;
+};
+
+shared uint s_minDepth;
+shared uint s_maxDepth;
+shared uint s_sunLit;
+shared uint s_lightCount;
+shared uint s_lights[MAX_LIGHTS_PER_TILE];
+
+vec3 GetViewPosition(vec2 ndcXY, float depth)
+{
+  float ndcZ = tileUniforms.depthZeroToOne != 0 ? depth : depth * 2.0 - 1.0;
+  vec4 point = tileUniforms.invProj * vec4(ndcXY, ndcZ, 1.0);
+  return point.xyz / point.w;
+}
+
+bool SphereIntersectsBox(vec3 center, float radius, vec3 boxMin, vec3 boxMax)
+{
+  vec3 closest = clamp(center, boxMin, boxMax);
+  vec3 d = center - closest;
+  return dot(d, d) <= radius * radius;
+}
+
+// Each workgroup classifies one tile and builds its light list
+void main()
+{
+  uint tileIndex = gl_WorkGroupID.x + gl_WorkGroupID.y * tileUniforms.tileCount.x;
+
+  if (gl_LocalInvocationIndex == 0)
+  {
+    s_minDepth = floatBitsToUint(1.0);
+    s_maxDepth = floatBitsToUint(0.0);
+    s_sunLit = 0;
+    s_lightCount = 0;
+  }
+
+  barrier();
+
+  ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+  if (all(lessThan(pixel, ivec2(tileUniforms.screenSize))))
+  {
+    float depth = texelFetch(s_gDepth, pixel, 0).x;
+    if (depth != 1.0)
+    {
+      // Non-negative floats have the same order as their bit patterns
+      atomicMin(s_minDepth, floatBitsToUint(depth));
+      atomicMax(s_maxDepth, floatBitsToUint(depth));
+
+      vec3 normal = texelFetch(s_gNormal, pixel, 0).xyz;
+      if (dot(normal, -tileUniforms.sunDir.xyz) > 0.0)
+      {
+        atomicOr(s_sunLit, 1);
+      }
+    }
+  }
+
+  barrier();
+
+  // Tiles that only contain sky aren't shaded at all
+  if (s_minDepth > s_maxDepth)
+  {
+    return;
+  }
+
+  // View-space bounds of the part of the tile's frustum that contains geometry
+  vec2 screenSize = vec2(tileUniforms.screenSize);
+  vec2 ndcMin = vec2(gl_WorkGroupID.xy * TILE_SIZE) / screenSize * 2.0 - 1.0;
+  vec2 ndcMax = vec2(min((gl_WorkGroupID.xy + 1) * TILE_SIZE, tileUniforms.screenSize)) / screenSize * 2.0 - 1.0;
+  float minDepth = uintBitsToFloat(s_minDepth);
+  float maxDepth = uintBitsToFloat(s_maxDepth);
+
+  vec3 boxMin = vec3(1e30);
+  vec3 boxMax = vec3(-1e30);
+  for (uint i = 0; i < 8; i++)
+  {
+    vec2 ndc = vec2((i & 1) != 0 ? ndcMax.x : ndcMin.x, (i & 2) != 0 ? ndcMax.y : ndcMin.y);
+    vec3 corner = GetViewPosition(ndc, (i & 4) != 0 ? maxDepth : minDepth);
+    boxMin = min(boxMin, corner);
+    boxMax = max(boxMax, corner);
+  }
+
+  for (uint i = gl_LocalInvocationIndex; i < tileUniforms.lightCount; i += TILE_SIZE * TILE_SIZE)
+  {
+    Light light = lightBuffer.lights[i];
+    vec3 center = (tileUniforms.view * vec4(light.position.xyz, 1.0)).xyz;
+    if (SphereIntersectsBox(center, 1.0 / light.invRadius, boxMin, boxMax))
+    {
+      uint slot = atomicAdd(s_lightCount, 1);
+      if (slot < MAX_LIGHTS_PER_TILE)
+      {
+        s_lights[slot] = i;
+      }
+    }
+  }
+
+  barrier();
+
+  // Lights that don't fit in the tile's list are dropped and counted
+  uint lightCount = min(s_lightCount, MAX_LIGHTS_PER_TILE);
+
+  if (gl_LocalInvocationIndex == 0)
+  {
+    tileLightCounts[tileIndex] = lightCount;
+    if (lightCount < s_lightCount)
+    {
+      atomicAdd(droppedLightCount, s_lightCount - lightCount);
+    }
+
+    uint tileClass = (s_sunLit != 0 ? TILE_CLASS_SUN_LIT : 0) | (lightCount > 0 ? TILE_CLASS_LOCAL_LIGHTS : 0);
+    uint slot = atomicAdd(tileDispatch[tileClass * 3], 1);
+    tileLists[tileClass * GetTileCount() + slot] = tileIndex;
+  }
+
+  for (uint i = gl_LocalInvocationIndex; i < lightCount; i += TILE_SIZE * TILE_SIZE)
+  {
+    tileLights[tileIndex * MAX_LIGHTS_PER_TILE + i] = s_lights[i];
+  }
+}
@@ -0,0 +1,50 @@
+#ifndef TILED_COMMON_H
+#define TILED_COMMON_H
+
+// The screen is divided into tiles of TILE_SIZE x TILE_SIZE pixels. Each tile that contains geometry is assigned to a
+// class that describes which kinds of lighting it needs, and stores a list of the local lights that can affect it.
+
+#include "clustered/Common.h.glsl"
+
+#define TILE_SIZE 16
+#define MAX_LIGHTS_PER_TILE 256
+
+// Tile class bits. There is one shading permutation for each combination
+#define TILE_CLASS_SUN_LIT 1      // At least one pixel faces the sun, so shadows must be evaluated
+#define TILE_CLASS_LOCAL_LIGHTS 2 // At least one local light intersects the tile
+#define TILE_CLASS_COUNT 4
+
+layout(binding = 4, std140) uniform TileUniforms
+{
+  mat4 view;
+  mat4 invProj;
+  vec4 sunDir;
+  uvec2 screenSize;
+  uvec2 tileCount;
+  uint lightCount;
+  uint depthZeroToOne;
+}tileUniforms;
+
+// TILE_CLASS_COUNT lists of tile indices, each with room for every tile
+layout(binding = 3, std430) buffer TileListsBuffer
+{
+  uint tileLists[];
+};
+
+layout(binding = 4, std430) buffer TileLightCountsBuffer
+{
+  uint tileLightCounts[];
+};
+
+// MAX_LIGHTS_PER_TILE light indices per tile
+layout(binding = 5, std430) buffer TileLightsBuffer
+{
+  uint tileLights[];
+};
+
+uint GetTileCount()
+{
+  return tileUniforms.tileCount.x * tileUniforms.tileCount.y;
+}
+
+#endif // TILED_COMMON_H
@@ -0,0 +1,53 @@
+#version 460 core
+
+// TILE_CLASS is defined by the application. Each permutation only contains the lighting that its tile class needs
+
+#include "DeferredPbrCommon.h.glsl"
+#include "tiled/Common.h.glsl"
+
+layout(local_size_x = TILE_SIZE, local_size_y = TILE_SIZE) in;
+
+layout(binding = 0, r11f_g11f_b10f) uniform writeonly image2D i_color;
+
+// Each workgroup shades one tile of the class
+void main()
+{
+  uint tileIndex = tileLists[TILE_CLASS * GetTileCount() + gl_WorkGroupID.x];
+  uvec2 tile = uvec2(tileIndex % tileUniforms.tileCount.x, tileIndex / tileUniforms.tileCount.x);
+  ivec2 pixel = ivec2(tile * TILE_SIZE + gl_LocalInvocationID.xy);
+  if (any(greaterThanEqual(pixel, ivec2(tileUniforms.screenSize))))
+  {
+    return;
+  }
+
+  float depth = texelFetch(s_gDepth, pixel, 0).x;
+  if (depth == 1.0)
+  {
+    return;
+  }
+
+  vec2 fragCoord = vec2(pixel) + 0.5;
+  vec2 uv = fragCoord / vec2(tileUniforms.screenSize);
+  vec3 albedo = texelFetch(s_gAlbedo, pixel, 0).rgb;
+  vec3 normal = texelFetch(s_gNormal, pixel, 0).xyz;
+
+  vec3 fragWorldPos = UnprojectUV(depth, uv, invViewProj);
+  vec3 viewDir = normalize(cameraPos.xyz - fragWorldPos);
+
+  vec3 finalColor = textureLod(s_rsmIndirect, uv, 0).rgb;
+
+#if (TILE_CLASS & TILE_CLASS_SUN_LIT) != 0
+  finalColor += ShadeSun(fragWorldPos, normal, viewDir, albedo, fragCoord);
+#endif
+
+#if (TILE_CLASS & TILE_CLASS_LOCAL_LIGHTS) != 0
+  uint lightCount = tileLightCounts[tileIndex];
+  for (uint i = 0; i < lightCount; i++)
+  {
+    Light light = lightBuffer.lights[tileLights[tileIndex * MAX_LIGHTS_PER_TILE + i]];
+    finalColor += LightIntensity(light, fragWorldPos, normal, viewDir, albedo);
+  }
+#endif
+
+  imageStore(i_color, pixel, vec4(finalColor, 0.0));
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <Fwog/Config.h>
+#include <Fwog/Buffer.h>
+#include <Fwog/Texture.h>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace Fwog
+{
+  /// @brief Parameters for the constructor of BindlessTextureTable
+  struct BindlessTextureTableCreateInfo
+  {
+    /// @brief The number of slots in the table
+    uint32_t capacity = 1024;
+
+    /// @brief The estimated amount of texture memory, in bytes, that may be resident before handles that were not used
+    ///        in the last commit are made non-resident. Zero means no limit
+    uint64_t residencyBudget = 0;
+  };
+
+  /// @brief Residency statistics of a BindlessTextureTable
+  struct BindlessTextureTableStats
+  {
+    uint32_t slotCount{};
+    uint32_t residentCount{};
+
+    /// @brief The estimated size of every resident texture, in bytes. Textures referenced by several slots are counted
+    ///        once per slot
+    uint64_t residentBytes{};
+
+    /// @brief The number of handles that were made non-resident to stay within the budget, since the table was created
+    uint64_t evictionCount{};
+  };
+
+  /// @brief A GPU-visible array of bindless texture handles
+  ///
+  /// Each slot holds the handle of a texture combined with a sampler. Adding a pair that is already in the table
+  /// returns its existing slot, as GL returns the same handle for the same pair.
+  ///
+  /// Handles must be resident to be used by shaders, and resident handles keep their textures in video memory. Slots
+  /// that will be accessed are marked with MarkUsed before Commit, which makes them resident. If the estimated size of
+  /// the resident textures exceeds the budget, Commit makes the least recently used handles non-resident. Slots that
+  /// are free or not resident hold the handle of a 1x1 white texture, so stray accesses are harmless.
+  ///
+  /// The handle array is stored in GetBuffer() as one uint64_t per slot, and can be bound as a storage buffer and
+  /// indexed by materials:
+  /// @code{.glsl}
+  /// layout(binding = 0, std430) readonly buffer TextureTable { sampler2D textures[]; };
+  /// @endcode
+  ///
+  /// If GL_ARB_bindless_texture is not supported, slots are still allocated so the same material data can be used,
+  /// but the buffer holds zeros and nothing is made resident. Check IsSupported() to choose a fallback path.
+  ///
+  /// @note Handles are created with glGetTextureSamplerHandleARB, after which the texture's storage and the sampler's
+  ///       state can't be changed. Textures must outlive their slots: call Remove or destroy the table first
+  class BindlessTextureTable
+  {
+  public:
+    explicit BindlessTextureTable(const BindlessTextureTableCreateInfo& createInfo = {});
+    BindlessTextureTable(BindlessTextureTable&& old) noexcept;
+    BindlessTextureTable& operator=(BindlessTextureTable&& old) noexcept;
+    BindlessTextureTable(const BindlessTextureTable&) = delete;
+    BindlessTextureTable& operator=(const BindlessTextureTable&) = delete;
+    ~BindlessTextureTable();
+
+    /// @brief Gets the slot of a texture and sampler, adding them to the table if needed
+    /// @return The index of the slot in the handle array
+    /// @note The table must not be full
+    [[nodiscard]] uint32_t Add(Texture& texture, const SamplerState& samplerState);
+
+    /// @brief Frees a slot, making its handle non-resident. The slot may be returned by the next call to Add
+    void Remove(uint32_t slot);
+
+    /// @brief Marks a slot as accessed by commands that are recorded after the next call to Commit
+    void MarkUsed(uint32_t slot);
+
+    /// @brief Marks every slot as used, for renderers that don't know which textures will be accessed
+    void MarkAllUsed();
+
+    /// @brief Makes the handles of used slots resident, evicts unused handles over the budget, and uploads changed
+    ///        slots to the handle array
+    void Commit();
+
+    [[nodiscard]] const Buffer& GetBuffer() const noexcept
+    {
+      return handleBuffer_;
+    }
+
+    [[nodiscard]] BindlessTextureTableStats GetStats() const;
+
+    /// @brief Whether GL_ARB_bindless_texture is supported
+    [[nodiscard]] bool IsSupported() const noexcept
+    {
+      return isSupported_;
+    }
+
+  private:
+    struct Slot
+    {
+      uint64_t key{}; // Texture and sampler handles, or 0 if the slot is free
+      uint64_t handle{};
+      uint64_t size{};
+      uint64_t lastUsedCommit{};
+      bool isUsed{};
+      bool isResident{};
+    };
+
+    void MakeResident(Slot& slot);
+    void MakeNonResident(Slot& slot);
+    void MarkDirty(uint32_t slot);
+
+    bool isSupported_{};
+    uint64_t residencyBudget_{};
+    uint64_t residentBytes_{};
+    uint64_t evictionCount_{};
+    uint64_t commitIndex_{};
+    uint32_t dirtyBegin_{};
+    uint32_t dirtyEnd_{};
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> freeSlots_;
+    std::unordered_map<uint64_t, uint32_t> slotOfKey_;
+    std::optional<Texture> fallbackTexture_;
+    uint64_t fallbackHandle_{};
+    Buffer handleBuffer_;
+  };
+} // namespace Fwog
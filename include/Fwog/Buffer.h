@@ -3,6 +3,7 @@
 #include <Fwog/BasicTypes.h>
 #include <Fwog/detail/Flags.h>
 #include <span>
+#include <string_view>
 #include <type_traits>
 
 namespace Fwog
@@ -53,6 +54,12 @@ namespace Fwog
 
     /// @brief Maps the buffer (persistently and coherently) upon creation
     MAP_MEMORY = 1 << 2,
+
+    /// @brief Used with MAP_MEMORY. Maps the buffer without GL_MAP_COHERENT_BIT, allowing the driver to use cached memory
+    ///
+    /// CPU writes must be made visible to the GPU with Buffer::FlushMappedRange, and GPU writes must be made visible to
+    /// the CPU with Buffer::InvalidateMappedRange.
+    MAP_NON_COHERENT = 1 << 3,
   };
   FWOG_DECLARE_FLAG_TYPE(BufferStorageFlags, BufferStorageFlag, uint32_t)
 
@@ -60,8 +67,10 @@ namespace Fwog
   class Buffer
   {
   public:
-    explicit Buffer(size_t size, BufferStorageFlags storageFlags = BufferStorageFlag::NONE);
-    explicit Buffer(TriviallyCopyableByteSpan data, BufferStorageFlags storageFlags = BufferStorageFlag::NONE);
+    explicit Buffer(size_t size, BufferStorageFlags storageFlags = BufferStorageFlag::NONE, std::string_view name = "");
+    explicit Buffer(TriviallyCopyableByteSpan data,
+                    BufferStorageFlags storageFlags = BufferStorageFlag::NONE,
+                    std::string_view name = "");
     
     Buffer(Buffer&& old) noexcept;
     Buffer& operator=(Buffer&& old) noexcept;
@@ -100,13 +109,31 @@ namespace Fwog
       return mappedMemory_ != nullptr;
     }
 
+    /// @brief Makes CPU writes to a range of mapped memory visible to the GPU
+    /// @param offset The offset of the range, in bytes
+    /// @param size The size of the range, in bytes. If size is WHOLE_BUFFER, the rest of the buffer is flushed
+    ///
+    /// Must be called after writing through the mapped pointer of a buffer created with
+    /// BufferStorageFlag::MAP_NON_COHERENT, before any command that reads the data is issued. Does nothing for
+    /// coherently mapped buffers.
+    void FlushMappedRange(size_t offset = 0, size_t size = WHOLE_BUFFER);
+
+    /// @brief Makes GPU writes to a range of mapped memory visible to the CPU
+    /// @param offset The offset of the range, in bytes
+    /// @param size The size of the range, in bytes. If size is WHOLE_BUFFER, the rest of the buffer is invalidated
+    ///
+    /// Must be called after the commands that write the data are issued, but before the fence that the CPU waits on
+    /// before reading. OpenGL has no range-based equivalent, so this inserts a barrier that covers every mapped
+    /// buffer. Does nothing for coherently mapped buffers.
+    void InvalidateMappedRange(size_t offset = 0, size_t size = WHOLE_BUFFER);
+
     /// @brief Invalidates the content of the buffer's data store
     ///
     /// This call can be used to optimize driver synchronization in certain cases.
     void Invalidate();
 
   protected:
-    Buffer(const void* data, size_t size, BufferStorageFlags storageFlags);
+    Buffer(const void* data, size_t size, BufferStorageFlags storageFlags, std::string_view name);
 
     void UpdateData(const void* data, size_t size, size_t offset = 0);
 
@@ -123,17 +150,26 @@ namespace Fwog
   class TypedBuffer : public Buffer
   {
   public:
-    explicit TypedBuffer(BufferStorageFlags storageFlags = BufferStorageFlag::NONE) : Buffer(sizeof(T), storageFlags) {}
-    explicit TypedBuffer(size_t count, BufferStorageFlags storageFlags = BufferStorageFlag::NONE)
-      : Buffer(sizeof(T) * count, storageFlags)
+    explicit TypedBuffer(BufferStorageFlags storageFlags = BufferStorageFlag::NONE, std::string_view name = "")
+      : Buffer(sizeof(T), storageFlags, name)
+    {
+    }
+    explicit TypedBuffer(size_t count,
+                         BufferStorageFlags storageFlags = BufferStorageFlag::NONE,
+                         std::string_view name = "")
+      : Buffer(sizeof(T) * count, storageFlags, name)
     {
     }
-    explicit TypedBuffer(std::span<const T> data, BufferStorageFlags storageFlags = BufferStorageFlag::NONE)
-      : Buffer(data, storageFlags)
+    explicit TypedBuffer(std::span<const T> data,
+                         BufferStorageFlags storageFlags = BufferStorageFlag::NONE,
+                         std::string_view name = "")
+      : Buffer(data, storageFlags, name)
     {
     }
-    explicit TypedBuffer(const T& data, BufferStorageFlags storageFlags = BufferStorageFlag::NONE)
-      : Buffer(&data, sizeof(T), storageFlags)
+    explicit TypedBuffer(const T& data,
+                         BufferStorageFlags storageFlags = BufferStorageFlag::NONE,
+                         std::string_view name = "")
+      : Buffer(&data, sizeof(T), storageFlags, name)
     {
     }
 
@@ -0,0 +1,201 @@
+#pragma once
+#include <Fwog/Config.h>
+#include <Fwog/Buffer.h>
+#include <Fwog/detail/OffsetAllocator.h>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace Fwog
+{
+  /// @brief A suballocation of one of a BufferHeap's buffers
+  ///
+  /// The buffer pointer remains valid until the allocation is freed or the heap is destroyed, even if the heap is
+  /// moved.
+  struct BufferHeapAllocation
+  {
+    Buffer* buffer = nullptr;
+
+    /// @brief The offset of the allocation in buffer, in bytes. Always a multiple of the heap's alignment
+    uint64_t offset = 0;
+
+    /// @brief The size that was requested for this allocation, in bytes
+    uint64_t size = 0;
+
+    uint32_t blockIndex = detail::OffsetAllocator::NO_SPACE;
+    uint32_t node = detail::OffsetAllocator::NO_SPACE;
+
+    [[nodiscard]] bool IsValid() const noexcept
+    {
+      return buffer != nullptr;
+    }
+  };
+
+  /// @brief Occupancy and fragmentation statistics of a BufferHeap
+  struct BufferHeapStats
+  {
+    /// @brief The combined size of all of the heap's buffers
+    uint64_t totalBytes{};
+
+    /// @brief The number of bytes in use by allocations, including alignment padding
+    uint64_t usedBytes{};
+    uint64_t freeBytes{};
+
+    /// @brief The size of the largest allocation that can be made without creating a new block
+    uint64_t largestFreeRegion{};
+    uint32_t allocationCount{};
+    uint32_t freeRegionCount{};
+    uint32_t blockCount{};
+
+    /// @brief One minus the ratio of the largest free region to the total free space. 0 means no fragmentation
+    float fragmentation{};
+  };
+
+  /// @brief Limits the amount of work done by a call to BufferHeap::Defragment
+  struct BufferHeapDefragmentInfo
+  {
+    /// @brief The maximum number of bytes that may be copied
+    uint64_t maxBytesToMove = UINT64_MAX;
+
+    /// @brief The maximum number of allocations that may be moved
+    uint32_t maxMoves = UINT32_MAX;
+  };
+
+  /// @brief Records that an allocation was moved by BufferHeap::Defragment
+  ///
+  /// Blocks are identified by index rather than by buffer pointer, as Defragment may destroy the source block, and a
+  /// later block may reuse its address. Use BufferHeap::ApplyRelocations to resolve the new location to a buffer.
+  struct BufferHeapRelocation
+  {
+    uint32_t oldBlockIndex{};
+    uint64_t oldOffset{};
+    uint32_t newBlockIndex{};
+    uint64_t newOffset{};
+
+    /// @brief The allocator node of the new range, which is needed to free it
+    uint32_t newNode{};
+
+    /// @brief The padded size of the range, not the size that was originally requested
+    uint64_t size{};
+  };
+
+  /// @brief A BufferHeapRelocation without pointers, which can be uploaded to a storage buffer
+  ///
+  /// Offsets that are stored in GPU memory (such as the first index and vertex offset of indirect draw commands) can
+  /// be patched by a compute pass that reads the table. The layout matches this std430 struct:
+  /// @code{.glsl}
+  /// struct Relocation { uint oldBlockIndex; uint oldOffset; uint newBlockIndex; uint newOffset; uint size; };
+  /// @endcode
+  struct BufferHeapRelocationRange
+  {
+    uint32_t oldBlockIndex{};
+    uint32_t oldOffset{};
+    uint32_t newBlockIndex{};
+    uint32_t newOffset{};
+
+    /// @brief The padded size of the range, in bytes
+    uint32_t size{};
+  };
+
+  /// @brief Suballocates ranges from a small number of large buffers
+  ///
+  /// Creating one buffer per mesh can result in thousands of buffer objects, which bloats driver bookkeeping and
+  /// prevents draws from sharing bindings. A BufferHeap instead manages a list of large blocks, each with a
+  /// constant-time TLSF offset allocator. Allocations that do not fit in any existing block cause a new block to be
+  /// created. Allocations larger than the block size get a dedicated block that is destroyed when they are freed.
+  class BufferHeap
+  {
+  public:
+    /// @brief Constructs the heap. No buffers are created until the first allocation
+    /// @param blockSize The size of each buffer, in bytes. Rounded up to a multiple of alignment
+    /// @param alignment The alignment of every allocation's offset, in bytes. Must be a power of two
+    /// @param storageFlags The storage flags of each buffer
+    explicit BufferHeap(uint64_t blockSize,
+                        uint64_t alignment = 16,
+                        BufferStorageFlags storageFlags = BufferStorageFlag::DYNAMIC_STORAGE);
+    BufferHeap(BufferHeap&& old) noexcept = default;
+    BufferHeap& operator=(BufferHeap&& old) noexcept = default;
+    BufferHeap(const BufferHeap&) = delete;
+    BufferHeap& operator=(const BufferHeap&) = delete;
+    ~BufferHeap();
+
+    /// @brief Allocates an uninitialized range
+    /// @param size The size of the allocation, in bytes
+    [[nodiscard]] BufferHeapAllocation Allocate(uint64_t size);
+
+    /// @brief Allocates a range and uploads data to it
+    /// @note The heap must have been created with BufferStorageFlag::DYNAMIC_STORAGE
+    [[nodiscard]] BufferHeapAllocation Allocate(TriviallyCopyableByteSpan data);
+
+    /// @brief Frees an allocation
+    ///
+    /// The range can be reused immediately. The caller is responsible for making sure that the GPU is not using it.
+    void Free(BufferHeapAllocation& allocation);
+
+    /// @brief Resizes an allocation, preserving its contents up to the smaller of the old and new sizes
+    ///
+    /// If the allocation's padded size already accommodates newSize, it is resized in place. Otherwise, a new range is
+    /// allocated, the contents are copied on the GPU, and the old range is freed.
+    void Reallocate(BufferHeapAllocation& allocation, uint64_t newSize);
+
+    /// @brief Incrementally compacts the heap by moving allocations into fuller blocks and towards the start of blocks
+    /// @param info Limits on the amount of data that is moved by this call. Call once per frame to spread out the cost
+    /// @return A relocation table describing every allocation that was moved
+    ///
+    /// Allocations in the least occupied blocks are moved first. Each move is performed on the GPU with CopyBuffer, and
+    /// the old range is freed immediately, as GL orders the copy before any subsequent command that reads or writes the
+    /// old range. Non-dedicated blocks that become empty are destroyed, except for the last one.
+    ///
+    /// The caller must update every copy of a moved allocation, for example with ApplyRelocations. Offsets that are
+    /// stored in GPU memory (such as indirect draw commands) must be patched too, either on the CPU or by uploading the
+    /// table returned by GetRelocationRanges for a compute pass.
+    ///
+    /// @note Mapped memory is not ordered with GL commands. For heaps created with BufferStorageFlag::MAP_MEMORY, the
+    /// caller must ensure the GPU has finished the copies before writing to a freed range through the mapped pointer
+    std::vector<BufferHeapRelocation> Defragment(const BufferHeapDefragmentInfo& info = {});
+
+    /// @brief Updates an allocation if it appears in a relocation table returned by Defragment
+    /// @return True if the allocation was moved
+    ///
+    /// The requested size of the allocation is preserved. The relocation table must be applied to allocations as they
+    /// were before the call to Defragment that produced it, and before any other allocation is made from this heap.
+    bool ApplyRelocations(std::span<const BufferHeapRelocation> relocations, BufferHeapAllocation& allocation) const;
+
+    [[nodiscard]] BufferHeapStats GetStats() const;
+
+    [[nodiscard]] uint64_t BlockSize() const noexcept
+    {
+      return blockSize_;
+    }
+
+    [[nodiscard]] uint64_t Alignment() const noexcept
+    {
+      return alignment_;
+    }
+
+  private:
+    struct Block
+    {
+      Buffer buffer;
+      detail::OffsetAllocator allocator;
+      bool isDedicated{};
+    };
+
+    uint32_t CreateBlock(uint64_t size, bool isDedicated);
+    uint64_t ToGranules(uint64_t size) const;
+
+    uint64_t blockSize_{};
+    uint64_t alignment_{};
+    BufferStorageFlags storageFlags_{};
+    std::vector<std::unique_ptr<Block>> blocks_;
+  };
+
+  /// @brief Converts a relocation table returned by BufferHeap::Defragment to a form that can be uploaded
+  ///
+  /// The order is preserved. An offset that was moved more than once is found by applying the ranges in order, like
+  /// BufferHeap::ApplyRelocations does.
+  /// @note Offsets and sizes must fit in 32 bits
+  [[nodiscard]] std::vector<BufferHeapRelocationRange> GetRelocationRanges(
+    std::span<const BufferHeapRelocation> relocations);
+} // namespace Fwog
@@ -61,6 +61,7 @@ namespace Fwog
 
     int32_t maxCombinedShaderOutputResources; // GL_MAX_COMBINED_SHADER_OUTPUT_RESOURCES
     int32_t maxCombinedTextureImageUnits;     // GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS
+    int32_t maxTextureImageUnits;             // GL_MAX_TEXTURE_IMAGE_UNITS
 
     // int32_t maxTextureBufferSize; // GL_MAX_TEXTURE_BUFFER_SIZE
 
@@ -78,6 +79,8 @@ namespace Fwog
   struct DeviceFeatures
   {
     bool bindlessTextures{}; // GL_ARB_bindless_texture
+    bool nvxGpuMemoryInfo{}; // GL_NVX_gpu_memory_info
+    bool atiMeminfo{};       // GL_ATI_meminfo
   };
 
   struct DeviceProperties
@@ -110,6 +113,20 @@ namespace Fwog
   /// of state deduplication.
   void InvalidatePipelineState();
 
+  /// @brief Enables or disables deferred destruction of GL objects
+  ///
+  /// When enabled, destroying a Buffer, Texture, GraphicsPipeline, or ComputePipeline does not immediately delete its
+  /// GL object. Instead, the object is queued and deleted by ProcessDeferredDestruction after the GPU has finished
+  /// every command that was submitted before it was destroyed. This prevents the driver from stalling or keeping a
+  /// shadow copy when a resource that may still be in use is destroyed (e.g., when a buffer is recreated each frame).
+  void SetDeferredDestructionEnabled(bool enabled);
+
+  /// @brief Deletes the queued GL objects that are no longer in use by the GPU, without blocking
+  ///
+  /// Call once per frame when deferred destruction is enabled. Objects that are still queued when Terminate is called
+  /// are deleted then.
+  void ProcessDeferredDestruction();
+
   /// @brief Query device properties
   /// @return A DeviceProperties struct containing information about the OpenGL context and device limits
   /// @note This call can replace most calls to glGet.
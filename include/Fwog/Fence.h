@@ -20,9 +20,17 @@ namespace Fwog
 
     /// @brief Waits for the fence to be signaled and returns
     /// @return How long (in nanoseconds) the fence blocked
-    /// @todo Add timeout parameter
     uint64_t Wait();
 
+    /// @brief Waits for the fence to be signaled or for a timeout to expire
+    /// @param timeoutNanoseconds The maximum amount of time to block
+    /// @return True if the fence was signaled. If so, the fence can be signaled again
+    [[nodiscard]] bool TryWait(uint64_t timeoutNanoseconds);
+
+    /// @brief Checks whether the fence has been signaled without blocking
+    /// @return True if the GPU has finished all the commands that preceded the fence
+    [[nodiscard]] bool IsSignaled();
+
   private:
     void DeleteSync();
 
@@ -0,0 +1,172 @@
+#pragma once
+#include <Fwog/Config.h>
+#include <Fwog/Timeline.h>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace Fwog
+{
+  /// @brief Statistics describing how often the CPU had to wait for the GPU in a FrameContext
+  struct FrameContextStats
+  {
+    /// @brief The number of frames that have begun
+    uint64_t frameCount{};
+
+    /// @brief The number of frames that had to wait for the GPU to finish an older frame
+    uint64_t stallCount{};
+
+    /// @brief The number of calls to BeginFrame that timed out
+    uint64_t timeoutCount{};
+
+    /// @brief The total time spent waiting for the GPU, in nanoseconds
+    uint64_t totalStallNanoseconds{};
+
+    /// @brief The time spent waiting for the GPU in the most recent frame, in nanoseconds
+    uint64_t lastStallNanoseconds{};
+  };
+
+  /// @brief Paces the CPU so that it records at most N frames ahead of the GPU, and owns a set of resources per frame
+  /// @tparam Resources The per-frame resources, such as upload rings, indirect command buffers, or timer queries
+  /// @tparam N The maximum number of frames in flight
+  ///
+  /// A timeline value is signaled at the end of every frame. When a frame begins, only the value from N frames ago is
+  /// waited on, after which that frame's resources are no longer in use by the GPU and can be overwritten without the implicit
+  /// synchronization that the driver would otherwise perform.
+  ///
+  /// Usage:
+  /// @code
+  /// if (frames.BeginFrame())
+  /// {
+  ///   auto& resources = frames.Current();
+  ///   // ... write to and use resources ...
+  ///   frames.EndFrame();
+  /// }
+  /// @endcode
+  template<class Resources, uint32_t N = 3>
+    requires(N > 0)
+  class FrameContext
+  {
+  public:
+    /// @brief Constructs the frame context
+    /// @param createResources A callable taking the frame index (0 to N - 1) and returning that frame's resources
+    /// @param timeoutNanoseconds The maximum amount of time BeginFrame may block
+    template<class F>
+    explicit FrameContext(F&& createResources, uint64_t timeoutNanoseconds = UINT64_MAX)
+      : timeoutNanoseconds_(timeoutNanoseconds)
+    {
+      resources_.reserve(N);
+      for (uint32_t i = 0; i < N; i++)
+      {
+        resources_.emplace_back(createResources(i));
+      }
+    }
+
+    FrameContext(FrameContext&& old) noexcept = default;
+    FrameContext& operator=(FrameContext&& old) noexcept = default;
+    FrameContext(const FrameContext&) = delete;
+    FrameContext& operator=(const FrameContext&) = delete;
+    ~FrameContext() = default;
+
+    /// @brief Begins a frame, waiting for the GPU to finish the frame that last used the current resources
+    /// @return False if the timeout expired. In that case, the frame has not begun and BeginFrame should be called again
+    /// later (e.g. on the next iteration of the main loop)
+    [[nodiscard]] bool BeginFrame()
+    {
+      FWOG_ASSERT(!isFrameActive_ && "EndFrame must be called before another frame can begin");
+
+      stats_.lastStallNanoseconds = 0;
+
+      // Poll first so that frames that don't wait aren't counted as stalls
+      if (!timeline_.IsComplete(frameValues_[frameIndex_]))
+      {
+        const auto start = std::chrono::steady_clock::now();
+        const bool signaled = timeline_.Wait(frameValues_[frameIndex_], timeoutNanoseconds_);
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        stats_.lastStallNanoseconds =
+          static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        stats_.totalStallNanoseconds += stats_.lastStallNanoseconds;
+
+        if (!signaled)
+        {
+          stats_.timeoutCount++;
+          return false;
+        }
+
+        stats_.stallCount++;
+      }
+
+      stats_.frameCount++;
+      isFrameActive_ = true;
+      return true;
+    }
+
+    /// @brief Ends the frame, signaling a timeline value that protects the current resources
+    void EndFrame()
+    {
+      FWOG_ASSERT(isFrameActive_ && "BeginFrame must be called before a frame can end");
+
+      frameValues_[frameIndex_] = timeline_.Signal();
+      frameIndex_ = (frameIndex_ + 1) % N;
+      isFrameActive_ = false;
+    }
+
+    /// @brief Gets the resources of the current frame
+    [[nodiscard]] Resources& Current() noexcept
+    {
+      return resources_[frameIndex_];
+    }
+
+    [[nodiscard]] const Resources& Current() const noexcept
+    {
+      return resources_[frameIndex_];
+    }
+
+    /// @brief Gets the resources of a frame
+    /// @param frameIndex A value from 0 to N - 1
+    [[nodiscard]] Resources& operator[](uint32_t frameIndex) noexcept
+    {
+      return resources_[frameIndex];
+    }
+
+    /// @brief Gets the index of the current frame's resources, from 0 to N - 1
+    [[nodiscard]] uint32_t FrameIndex() const noexcept
+    {
+      return frameIndex_;
+    }
+
+    [[nodiscard]] static constexpr uint32_t FramesInFlight() noexcept
+    {
+      return N;
+    }
+
+    /// @brief Gets the timeline that is signaled at the end of every frame
+    [[nodiscard]] Timeline& GetTimeline() noexcept
+    {
+      return timeline_;
+    }
+
+    [[nodiscard]] const FrameContextStats& GetStats() const noexcept
+    {
+      return stats_;
+    }
+
+    void SetTimeout(uint64_t timeoutNanoseconds) noexcept
+    {
+      timeoutNanoseconds_ = timeoutNanoseconds;
+    }
+
+  private:
+    uint64_t timeoutNanoseconds_{};
+    uint32_t frameIndex_{};
+    bool isFrameActive_ = false;
+    std::vector<Resources> resources_;
+    Timeline timeline_;
+
+    // The timeline value that protects each frame's resources, or zero if they have never been used
+    std::array<uint64_t, N> frameValues_{};
+    FrameContextStats stats_{};
+  };
+} // namespace Fwog
@@ -0,0 +1,90 @@
+#pragma once
+#include <Fwog/Config.h>
+#include <Fwog/BasicTypes.h>
+#include <Fwog/Buffer.h>
+#include <Fwog/Rendering.h>
+#include <concepts>
+#include <cstdint>
+
+namespace Fwog
+{
+  /// @brief A persistent list of indirect draw commands and a draw count, both of which are written by the GPU
+  /// @tparam Command Either DrawIndirectCommand or DrawIndexedIndirectCommand
+  ///
+  /// The list is meant to be regenerated every frame by a compute shader (e.g., one that performs culling) that
+  /// appends commands by atomically incrementing the count. Both buffers are allocated once, so regenerating the list
+  /// does not allocate or upload anything.
+  ///
+  /// Usage:
+  /// @code
+  /// drawList.Reset();
+  /// Fwog::BeginCompute();
+  /// Fwog::Cmd::BindStorageBuffer(0, drawList.GetCommandBuffer());
+  /// Fwog::Cmd::BindStorageBuffer(1, drawList.GetCountBuffer());
+  /// // ... dispatch a shader that appends commands ...
+  /// Fwog::EndCompute();
+  ///
+  /// Fwog::BeginRendering(...);
+  /// Fwog::MemoryBarrier(Fwog::MemoryBarrierBit::COMMAND_BUFFER_BIT);
+  /// drawList.Draw();
+  /// Fwog::EndRendering();
+  /// @endcode
+  template<class Command>
+    requires(std::same_as<Command, DrawIndirectCommand> || std::same_as<Command, DrawIndexedIndirectCommand>)
+  class IndirectDrawList
+  {
+  public:
+    /// @brief Constructs an empty list
+    /// @param capacity The maximum number of commands the list can hold
+    explicit IndirectDrawList(uint32_t capacity) : capacity_(capacity), commands_(capacity), count_()
+    {
+      FWOG_ASSERT(capacity > 0);
+      Reset();
+    }
+
+    /// @brief Sets the draw count to zero on the GPU
+    ///
+    /// The command buffer is left untouched, since commands past the draw count are never read.
+    void Reset()
+    {
+      count_.ClearSubData({.internalFormat = Format::R32_UINT});
+    }
+
+    /// @brief Draws the commands in the list, up to the count written by the GPU
+    ///
+    /// Valid in rendering scopes. For indexed commands, an index buffer must be bound.
+    void Draw() const
+    {
+      if constexpr (std::same_as<Command, DrawIndexedIndirectCommand>)
+      {
+        Cmd::DrawIndexedIndirectCount(commands_, 0, count_, 0, capacity_, sizeof(Command));
+      }
+      else
+      {
+        Cmd::DrawIndirectCount(commands_, 0, count_, 0, capacity_, sizeof(Command));
+      }
+    }
+
+    /// @brief Gets the buffer holding the commands, to be bound as a storage buffer by the pass that writes them
+    [[nodiscard]] const TypedBuffer<Command>& GetCommandBuffer() const noexcept
+    {
+      return commands_;
+    }
+
+    /// @brief Gets the buffer holding the draw count, a single uint32_t
+    [[nodiscard]] const TypedBuffer<uint32_t>& GetCountBuffer() const noexcept
+    {
+      return count_;
+    }
+
+    [[nodiscard]] uint32_t Capacity() const noexcept
+    {
+      return capacity_;
+    }
+
+  private:
+    uint32_t capacity_{};
+    TypedBuffer<Command> commands_;
+    TypedBuffer<uint32_t> count_;
+  };
+} // namespace Fwog
@@ -0,0 +1,75 @@
+#pragma once
+#include <Fwog/Config.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Fwog
+{
+  /// @brief The kind of object that a resource is
+  enum class ResourceCategory
+  {
+    BUFFER,
+    TEXTURE,
+
+    /// @brief Views alias the storage of a texture, so they are not included in the byte totals
+    TEXTURE_VIEW,
+  };
+
+  /// @brief The live resources of one category that have the same name
+  struct ResourceUsage
+  {
+    ResourceCategory category{};
+
+    /// @brief The name that the resources were created with, which may be empty
+    std::string name;
+
+    uint32_t count{};
+
+    /// @brief The estimated size of the resources. For views, the size of the subresources they view
+    uint64_t bytes{};
+  };
+
+  /// @brief The estimated memory used by live resources
+  ///
+  /// Sizes are computed from the parameters that resources were created with, including mip levels, array layers,
+  /// samples, and block-compressed formats. Drivers may pad or compress resources, so the actual usage can differ.
+  struct MemoryUsage
+  {
+    uint32_t bufferCount{};
+    uint64_t bufferBytes{};
+    uint32_t textureCount{};
+    uint64_t textureBytes{};
+    uint32_t textureViewCount{};
+
+    /// @brief Usage grouped by category and name, sorted by size in descending order
+    std::vector<ResourceUsage> resources;
+  };
+
+  /// @brief Video memory as reported by the driver
+  struct DeviceMemoryInfo
+  {
+    /// @brief The video memory that is available for new resources, in bytes
+    uint64_t availableBytes{};
+
+    /// @brief The total video memory, in bytes. Only reported by GL_NVX_gpu_memory_info
+    std::optional<uint64_t> dedicatedBytes;
+
+    /// @brief The memory that has been evicted from video memory to make room for other resources, in bytes, and the
+    ///        number of evictions. Only reported by GL_NVX_gpu_memory_info
+    std::optional<uint64_t> evictedBytes;
+    std::optional<uint32_t> evictionCount;
+  };
+
+  /// @brief Gets the estimated memory used by every live Buffer, Texture, and TextureView
+  ///
+  /// Resources are counted until their GL object is deleted. With deferred destruction enabled, this is after
+  /// ProcessDeferredDestruction has deleted them, as they occupy memory until then.
+  [[nodiscard]] MemoryUsage GetMemoryUsage();
+
+  /// @brief Queries the driver for the amount of video memory that is available
+  /// @return The memory info, or nullopt if neither GL_NVX_gpu_memory_info nor GL_ATI_meminfo is supported
+  /// @note With GL_ATI_meminfo, availableBytes is the free memory of the texture pool
+  [[nodiscard]] std::optional<DeviceMemoryInfo> QueryDeviceMemoryInfo();
+} // namespace Fwog
@@ -0,0 +1,95 @@
+#pragma once
+#include <Fwog/Config.h>
+#include <Fwog/BasicTypes.h>
+#include <Fwog/Buffer.h>
+#include <Fwog/Pipeline.h>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace Fwog
+{
+  class Texture;
+
+  /// @brief How each texel of a generated level is computed from the level before it
+  enum class MipmapFilter
+  {
+    /// @brief The average of the 2x2 texels it covers
+    BOX,
+
+    /// @brief A 6x6 Kaiser-windowed sinc filter. Sharper than BOX, and clamped to the range of the texels it reads to
+    ///        avoid ringing. Not supported for integer formats
+    KAISER,
+
+    /// @brief The minimum of the 2x2 texels it covers, for each component
+    MIN,
+
+    /// @brief The maximum of the 2x2 texels it covers, for each component
+    MAX,
+  };
+
+  /// @brief Parameters for MipmapGenerator::Generate
+  struct MipmapGenerateInfo
+  {
+    MipmapFilter filter = MipmapFilter::BOX;
+
+    /// @brief The level that the levels after it are generated from
+    uint32_t baseLevel = 0;
+
+    /// @brief Whether RGB is filtered in linear space and stored with the sRGB transfer function. This is implied for
+    ///        sRGB formats, and can be set for UNORM textures that hold sRGB-encoded data
+    bool srgb = false;
+  };
+
+  /// @brief Fills the mip chain of a texture with compute shaders
+  ///
+  /// An alternative to Texture::GenMipmaps that has defined filtering, supports integer formats, and filters sRGB
+  /// images in linear space.
+  ///
+  /// BOX, MIN, and MAX are reduced in the style of AMD's single pass downsampler: each workgroup reduces a 64x64 tile
+  /// into the six levels after it in shared memory, and the last workgroup to finish reduces the rest. Chains of up to
+  /// 13 levels whose sixth generated level fits in a 64x64 tile (such as the full chain of a 4096x4096 texture) are
+  /// generated in a single dispatch if the device has enough image units. Other chains take one dispatch per six
+  /// levels. KAISER needs texels from neighboring tiles, so it uses one dispatch per level.
+  ///
+  /// Each level is half the size of the previous one (rounded down), so the last row or column of levels with an odd
+  /// size does not contribute to the next level. Use power-of-two textures if every texel must be covered, such as for
+  /// conservative min/max pyramids.
+  ///
+  /// Supported image types are TEX_2D, TEX_2D_ARRAY, TEX_CUBEMAP, and TEX_CUBEMAP_ARRAY, in which case every layer (or
+  /// face) is filtered independently. The format must be usable with image load/store, or be R8G8B8A8_SRGB.
+  class MipmapGenerator
+  {
+  public:
+    MipmapGenerator();
+    MipmapGenerator(MipmapGenerator&& old) noexcept = default;
+    MipmapGenerator& operator=(MipmapGenerator&& old) noexcept = default;
+    MipmapGenerator(const MipmapGenerator&) = delete;
+    MipmapGenerator& operator=(const MipmapGenerator&) = delete;
+    ~MipmapGenerator() = default;
+
+    /// @brief Generates every level after info.baseLevel
+    /// @throws PipelineCompilationException the first time a combination of format and filter is used
+    /// @note Must be called outside of a rendering or compute scope. A memory barrier must be issued before the
+    ///       generated levels are read. If the base level was written with image stores, a memory barrier must also be
+    ///       issued before this is called
+    void Generate(Texture& texture, const MipmapGenerateInfo& info = {});
+
+  private:
+    struct PipelineEntry
+    {
+      Format storageFormat;
+      MipmapFilter filter;
+      bool srgb;
+      bool singlePass;
+      ComputePipeline pipeline;
+    };
+
+    const ComputePipeline& GetPipeline(Format storageFormat, MipmapFilter filter, bool srgb, bool singlePass);
+
+    bool supportsSinglePass_;
+    std::vector<PipelineEntry> pipelines_;
+    Buffer uniformBuffer_;
+    std::optional<Buffer> counterBuffer_;
+  };
+} // namespace Fwog
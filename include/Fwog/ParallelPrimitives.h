@@ -0,0 +1,164 @@
+#pragma once
+#include <Fwog/Config.h>
+#include <Fwog/BasicTypes.h>
+#include <Fwog/Buffer.h>
+#include <Fwog/Pipeline.h>
+#include <cstdint>
+#include <optional>
+
+namespace Fwog
+{
+  /// @brief Parameters for the compute kernels used by PrefixSum, StreamCompaction, and RadixSort
+  ///
+  /// Each workgroup processes a tile of workgroupSize * itemsPerInvocation elements. The best values depend on the
+  /// device, so they are compiled into the kernels when the object is constructed.
+  struct ParallelPrimitivesInfo
+  {
+    /// @brief The number of invocations in each workgroup. Must be a power of two
+    uint32_t workgroupSize = 256;
+
+    /// @brief The number of consecutive elements each invocation processes
+    uint32_t itemsPerInvocation = 4;
+  };
+
+  /// @brief Computes exclusive prefix sums of 32-bit unsigned integers in a single pass
+  ///
+  /// Tiles are scanned with decoupled look-back: each workgroup publishes its tile's sum as soon as it is known, then
+  /// sums the published values of its predecessors until it reaches one that has published an inclusive prefix. Tiles
+  /// are assigned in the order that workgroups start, so a workgroup only ever waits on workgroups that are running.
+  ///
+  /// The sum of all elements must be less than 2^30, as the upper two bits of each tile's status are used as flags. Larger
+  /// sums are not detected in release builds, and corrupt the output.
+  class PrefixSum
+  {
+  public:
+    /// @throws PipelineCompilationException
+    explicit PrefixSum(const ParallelPrimitivesInfo& info = {});
+    PrefixSum(PrefixSum&& old) noexcept = default;
+    PrefixSum& operator=(PrefixSum&& old) noexcept = default;
+    PrefixSum(const PrefixSum&) = delete;
+    PrefixSum& operator=(const PrefixSum&) = delete;
+    ~PrefixSum() = default;
+
+    /// @brief Writes the sum of all elements before each element of input to the same index of output
+    /// @param input A buffer of at least count uint32_ts
+    /// @param output A buffer of at least count uint32_ts. May be the same buffer as input
+    /// @param count The number of elements to scan
+    /// @pre The sum of the first count elements of input is less than 2^30. In debug builds, this waits for the scan to
+    ///      finish and asserts that it is
+    /// @note Must be called outside of a rendering or compute scope. A memory barrier must be issued before the output
+    ///       is consumed
+    void ExclusiveScan(const Buffer& input, Buffer& output, uint32_t count);
+
+  private:
+    friend class RadixSort;
+
+    // Records the scan in the current compute scope
+    void RecordExclusiveScan(const Buffer& input, Buffer& output, uint32_t count);
+
+    uint32_t tileSize_;
+    ComputePipeline scanPipeline_;
+    Buffer uniformBuffer_;
+    std::optional<Buffer> stateBuffer_;
+  };
+
+  /// @brief The output of StreamCompaction::Compact
+  ///
+  /// The layout is such that a buffer holding this can be given directly to Cmd::DispatchIndirect to launch work for
+  /// the compacted elements.
+  struct CompactionResult
+  {
+    DispatchIndirectCommand dispatch;
+    uint32_t count;
+  };
+
+  /// @brief Copies the elements of a buffer whose flags are nonzero to a contiguous range, preserving their order
+  ///
+  /// Compaction is fused with a PrefixSum-style single-pass scan of the flags.
+  class StreamCompaction
+  {
+  public:
+    /// @throws PipelineCompilationException
+    explicit StreamCompaction(const ParallelPrimitivesInfo& info = {});
+    StreamCompaction(StreamCompaction&& old) noexcept = default;
+    StreamCompaction& operator=(StreamCompaction&& old) noexcept = default;
+    StreamCompaction(const StreamCompaction&) = delete;
+    StreamCompaction& operator=(const StreamCompaction&) = delete;
+    ~StreamCompaction() = default;
+
+    /// @brief Copies values[i] to output for every i where flags[i] is nonzero
+    /// @param values A buffer of at least count uint32_ts
+    /// @param flags A buffer of at least count uint32_ts
+    /// @param output A buffer with room for every selected element. Must not alias values or flags
+    /// @param result A buffer of at least sizeof(CompactionResult) that receives the number of selected elements and
+    ///        an indirect dispatch command with enough workgroups of dispatchGroupSize invocations to process them
+    /// @param count The number of elements to consider. Must be less than 2^30
+    /// @param dispatchGroupSize The workgroup size of the shader that will consume the output
+    /// @note Must be called outside of a rendering or compute scope. A memory barrier must be issued before the output
+    ///       is consumed
+    void Compact(const Buffer& values,
+                 const Buffer& flags,
+                 Buffer& output,
+                 Buffer& result,
+                 uint32_t count,
+                 uint32_t dispatchGroupSize = 64);
+
+    /// @brief Writes every index i where flags[i] is nonzero to output
+    ///
+    /// Same as Compact, but values[i] is replaced with i.
+    void CompactIndices(const Buffer& flags,
+                        Buffer& output,
+                        Buffer& result,
+                        uint32_t count,
+                        uint32_t dispatchGroupSize = 64);
+
+  private:
+    void Record(const Buffer* values,
+                const Buffer& flags,
+                Buffer& output,
+                Buffer& result,
+                uint32_t count,
+                uint32_t dispatchGroupSize);
+
+    uint32_t tileSize_;
+    ComputePipeline compactPipeline_;
+    Buffer uniformBuffer_;
+    std::optional<Buffer> stateBuffer_;
+  };
+
+  /// @brief Sorts 32-bit unsigned integer keys and their associated 32-bit values
+  ///
+  /// A least significant digit radix sort that processes eight bits per pass. Each pass counts the digits of each tile,
+  /// scans the counts with PrefixSum to find where each tile's elements go, and then scatters the elements. The sort
+  /// is stable.
+  class RadixSort
+  {
+  public:
+    /// @throws PipelineCompilationException
+    explicit RadixSort(const ParallelPrimitivesInfo& info = {});
+    RadixSort(RadixSort&& old) noexcept = default;
+    RadixSort& operator=(RadixSort&& old) noexcept = default;
+    RadixSort(const RadixSort&) = delete;
+    RadixSort& operator=(const RadixSort&) = delete;
+    ~RadixSort() = default;
+
+    /// @brief Sorts key/value pairs in ascending order of their keys
+    /// @param keys A buffer of at least count uint32_ts. Receives the sorted keys
+    /// @param values A buffer of at least count uint32_ts. Receives the values in the order of their sorted keys
+    /// @param count The number of pairs to sort. Must be less than 2^30
+    /// @param keyBits The number of low bits of the keys that are significant. Fewer bits require fewer passes
+    /// @note Must be called outside of a rendering or compute scope. A memory barrier must be issued before the output
+    ///       is consumed
+    void SortPairs(Buffer& keys, Buffer& values, uint32_t count, uint32_t keyBits = 32);
+
+  private:
+    uint32_t tileSize_;
+    PrefixSum prefixSum_;
+    ComputePipeline histogramPipeline_;
+    ComputePipeline scatterPipeline_;
+    Buffer uniformBuffer_;
+    std::optional<Buffer> keysScratch_;
+    std::optional<Buffer> valuesScratch_;
+    std::optional<Buffer> histogramBuffer_;
+  };
+} // namespace Fwog
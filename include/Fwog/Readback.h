@@ -0,0 +1,90 @@
+#pragma once
+#include <Fwog/Config.h>
+#include <Fwog/BasicTypes.h>
+#include <Fwog/Buffer.h>
+#include <Fwog/Fence.h>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+namespace Fwog
+{
+  class Texture;
+
+  /// @brief Parameters for ReadbackTexture
+  struct ReadbackTextureInfo
+  {
+    const Texture& sourceTexture;
+    uint32_t level = 0;
+    Offset3D sourceOffset = {};
+    Extent3D extent = {};
+    UploadFormat format = UploadFormat::INFER_FORMAT;
+    UploadType type = UploadType::INFER_TYPE;
+  };
+
+  /// @brief A pending copy of GPU data into CPU-visible memory
+  ///
+  /// Poll IsReady() each frame and consume Data() once it returns true. This lets results such as GPU culling
+  /// statistics, luminance histograms, or screenshots be retrieved without stalling the pipeline.
+  ///
+  /// The mapped buffer backing the result is returned to a pool when the result is destroyed.
+  class ReadbackResult
+  {
+  public:
+    ReadbackResult(ReadbackResult&& old) noexcept = default;
+    ReadbackResult& operator=(ReadbackResult&& old) noexcept;
+    ReadbackResult(const ReadbackResult&) = delete;
+    ReadbackResult& operator=(const ReadbackResult&) = delete;
+    ~ReadbackResult();
+
+    /// @brief Checks whether the GPU has finished writing the data, without blocking
+    [[nodiscard]] bool IsReady();
+
+    /// @brief Blocks until the GPU has finished writing the data
+    void Wait();
+
+    /// @brief Gets the data that was read back
+    /// @note IsReady() must have returned true, or Wait() must have been called
+    [[nodiscard]] std::span<const std::byte> Data() const;
+
+    /// @brief Gets the data that was read back, reinterpreted as an array of T
+    template<class T>
+      requires std::is_trivially_copyable_v<T>
+    [[nodiscard]] std::span<const T> DataAs() const
+    {
+      auto data = Data();
+      return {reinterpret_cast<const T*>(data.data()), data.size_bytes() / sizeof(T)};
+    }
+
+    /// @brief Gets the size of the data, in bytes
+    [[nodiscard]] size_t Size() const noexcept
+    {
+      return size_;
+    }
+
+  private:
+    friend ReadbackResult ReadbackBuffer(const Buffer& source, uint64_t sourceOffset, uint64_t size);
+    friend ReadbackResult ReadbackTexture(const ReadbackTextureInfo& info);
+
+    ReadbackResult(Buffer&& buffer, size_t size);
+
+    Buffer buffer_;
+    Fence fence_;
+    size_t size_{};
+    bool isReady_ = false;
+  };
+
+  /// @brief Asynchronously copies a range of a buffer into CPU-visible memory
+  /// @param source The buffer to read from
+  /// @param sourceOffset The offset in the source buffer, in bytes
+  /// @param size The amount of data to read, in bytes. If size is WHOLE_BUFFER, the rest of the source buffer is read
+  [[nodiscard]] ReadbackResult ReadbackBuffer(const Buffer& source,
+                                              uint64_t sourceOffset = 0,
+                                              uint64_t size = WHOLE_BUFFER);
+
+  /// @brief Asynchronously copies a region of a texture into CPU-visible memory
+  ///
+  /// The texels are tightly packed, except that each row is padded to a multiple of four bytes.
+  [[nodiscard]] ReadbackResult ReadbackTexture(const ReadbackTextureInfo& info);
+} // namespace Fwog
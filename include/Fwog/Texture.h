@@ -11,11 +11,13 @@ namespace Fwog
   class Sampler;
   class Texture;
   class TextureView;
+  class UploadQueue;
 
   namespace detail
   {
     class SamplerCache;
     uint32_t GetHandle(const Texture& texture);
+    uint64_t GetBlockCompressedImageSize(Format format, uint32_t width, uint32_t height, uint32_t depth);
   } // namespace detail
 
   /// @brief Parameters for the constructor of Texture
@@ -38,6 +40,8 @@ namespace Fwog
     ComponentSwizzle g = ComponentSwizzle::G;
     ComponentSwizzle b = ComponentSwizzle::B;
     ComponentSwizzle a = ComponentSwizzle::A;
+
+    bool operator==(const ComponentMapping&) const noexcept = default;
   };
 
   /// @brief Parameters for the constructor of TextureView
@@ -52,6 +56,8 @@ namespace Fwog
     uint32_t numLevels = 0;
     uint32_t minLayer = 0;
     uint32_t numLayers = 0;
+
+    bool operator==(const TextureViewCreateInfo&) const noexcept = default;
   };
 
   /// @brief Parameters for Texture::UpdateImage
@@ -142,6 +148,22 @@ namespace Fwog
     /// @note info.data must be in a compatible compressed image format
     void UpdateCompressedImage(const CompressedTextureUpdateInfo& info);
 
+    /// @brief Updates a subresource of the image without waiting for the driver to consume the data
+    ///
+    /// The data is copied into a pooled staging buffer, from which the GPU copies it into the image. info.pixels can be
+    /// freed as soon as this returns. Staging buffers are recycled once a fence signals that the GPU is done with them.
+    /// If too much staging memory is in flight, this waits for the oldest uploads to finish.
+    /// @param info The subresource and data to upload
+    /// @note info.format must not be a compressed image format
+    void UpdateImageAsync(const TextureUpdateInfo& info);
+
+    /// @brief Updates a subresource of the image without waiting for the driver to consume the data
+    ///
+    /// Same as UpdateImageAsync, but for compressed images.
+    /// @param info The subresource and data to upload
+    /// @note Image must be in a compressed image format
+    void UpdateCompressedImageAsync(const CompressedTextureUpdateInfo& info);
+
     /// @brief Clears a subresource of the image to a specified value
     /// @param info The subresource and value to clear it with
     void ClearImage(const TextureClearInfo& info);
@@ -165,10 +187,21 @@ namespace Fwog
     /// @return A new texture view
     [[nodiscard]] TextureView CreateSwizzleView(ComponentMapping components);
 
+    /// @brief Gets a view of the texture, creating it if this texture has no view with the same parameters
+    ///
+    /// Unlike the TextureView constructors and the Create*View functions, this returns a reference to a shared OpenGL
+    /// texture view. It is kept alive until this texture and every TextureView that references it have been destroyed,
+    /// so views can be requested every frame without creating a GL object (and framebuffers that use it) each time.
+    /// @param viewInfo Parameters of the view
+    /// @note Every caller that requests the same parameters gets the same GL object, so state that belongs to it,
+    ///       such as its bindless handle and debug label, is shared too. Use a unique view for those
+    [[nodiscard]] TextureView CreateCachedView(const TextureViewCreateInfo& viewInfo);
+
     /// @brief Generates and makes resident a bindless handle from the image and a sampler. Only available if GL_ARB_bindless_texture is supported
     /// @param sampler The sampler to bind to the texture
     /// @return A bindless texture handle that can be placed in a buffer and used to construct a combined texture sampler in a shader
-    /// @todo Improve this
+    /// @note The texture can only have one handle, which stays resident until it is destroyed. BindlessTextureTable
+    ///       supports several samplers per texture and limits residency
     [[nodiscard]] uint64_t GetBindlessHandle(Sampler sampler);
 
     [[nodiscard]] const TextureCreateInfo& GetCreateInfo() const noexcept
@@ -190,6 +223,7 @@ namespace Fwog
 
   protected:
     friend void CopyBufferToTexture(const CopyBufferToTextureInfo& copy);
+    friend class UploadQueue;
 
     void subImageInternal(const TextureUpdateInfo& info);
 
@@ -227,8 +261,11 @@ namespace Fwog
     }
 
   private:
+    friend class Texture;
+
     TextureView();
     TextureViewCreateInfo viewInfo_{};
+    bool isCached_ = false; // The GL texture is owned by the context's view cache
   };
 
   /// @brief Encapsulates an OpenGL sampler
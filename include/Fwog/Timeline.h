@@ -0,0 +1,77 @@
+#pragma once
+#include <Fwog/Config.h>
+#include <cstdint>
+#include <deque>
+
+namespace Fwog
+{
+  /// @brief A monotonically increasing counter that is advanced by the GPU, used for CPU-GPU synchronization
+  ///
+  /// Each call to Signal() inserts a fence into the command stream and returns a new value. Once the GPU has executed
+  /// every command that preceded the fence, the timeline's completed value is at least that value. Since commands
+  /// complete in order, a single timeline can track the lifetime of any number of resources by remembering the value
+  /// that was signaled after each resource was last used.
+  ///
+  /// Unlike Fence, a timeline can be signaled again while earlier values are still pending, and it can be polled or
+  /// waited on with a timeout.
+  ///
+  /// Usage:
+  /// @code
+  /// // ... use a resource ...
+  /// uint64_t lastUse = timeline.Signal();
+  /// // Later:
+  /// if (timeline.IsComplete(lastUse))
+  /// {
+  ///   // The resource can be safely overwritten
+  /// }
+  /// @endcode
+  class Timeline
+  {
+  public:
+    explicit Timeline();
+    Timeline(Timeline&& old) noexcept;
+    Timeline& operator=(Timeline&& old) noexcept;
+    Timeline(const Timeline&) = delete;
+    Timeline& operator=(const Timeline&) = delete;
+    ~Timeline();
+
+    /// @brief Inserts a fence into the command stream
+    /// @return The value that the timeline will reach once the GPU has executed every previously submitted command
+    uint64_t Signal();
+
+    /// @brief Gets the greatest value that the GPU is known to have reached, without blocking
+    [[nodiscard]] uint64_t GetCompletedValue();
+
+    /// @brief Checks whether the GPU has reached a value, without blocking
+    /// @param value A value returned by Signal(). Zero is always complete
+    [[nodiscard]] bool IsComplete(uint64_t value);
+
+    /// @brief Waits for the GPU to reach a value or for a timeout to expire
+    /// @param value A value returned by Signal(). Zero is always complete
+    /// @param timeoutNanoseconds The maximum amount of time to block
+    /// @return True if the value was reached
+    bool Wait(uint64_t value, uint64_t timeoutNanoseconds = UINT64_MAX);
+
+    /// @brief Gets the value that was returned by the most recent call to Signal()
+    [[nodiscard]] uint64_t GetSignaledValue() const noexcept
+    {
+      return signaledValue_;
+    }
+
+  private:
+    struct Point
+    {
+      uint64_t value;
+      void* sync;
+    };
+
+    // Deletes the syncs of every pending point up to and including value
+    void Retire(uint64_t value);
+
+    uint64_t signaledValue_{};
+    uint64_t completedValue_{};
+
+    // Points that the GPU has not been observed to reach, ordered by value
+    std::deque<Point> pending_;
+  };
+} // namespace Fwog
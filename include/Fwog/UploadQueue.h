@@ -0,0 +1,118 @@
+#pragma once
+#include <Fwog/Config.h>
+#include <Fwog/BasicTypes.h>
+#include <Fwog/Buffer.h>
+#include <Fwog/Timeline.h>
+#include <Fwog/Texture.h>
+#include <cstdint>
+#include <deque>
+#include <variant>
+#include <vector>
+
+namespace Fwog
+{
+  /// @brief Batches buffer and texture uploads through a persistently mapped staging ring
+  ///
+  /// Uploading from client memory with Buffer::UpdateData or Texture::UpdateImage makes the driver copy or synchronize
+  /// at a time of its choosing. An UploadQueue instead copies data into a staging buffer immediately and records the
+  /// matching CopyBuffer or CopyBufferToTexture operation. Flush() executes every recorded operation and inserts a fence
+  /// that protects the staging memory they read from. The memory is recycled when the GPU has signaled the fence.
+  ///
+  /// If the staging ring is full, the oldest flushed batch is waited on. If no flushed batch exists, the pending
+  /// operations are flushed first. This bounds the amount of staging memory, and thus the upload cost per Flush().
+  ///
+  /// Usage:
+  /// @code
+  /// queue.UploadBuffer(vertexBuffer, vertices);
+  /// queue.UploadImage(texture, {.extent = texture.Extent(), .pixels = pixels});
+  /// queue.Flush();
+  /// @endcode
+  ///
+  /// @note Targets must remain alive until the next call to Flush()
+  class UploadQueue
+  {
+  public:
+    /// @brief Constructs the queue
+    /// @param stagingSize The size of the staging ring, in bytes. Rounded up to a multiple of 16, so that every staging
+    /// offset is suitably aligned for buffer copies and for uploads of any pixel type. Single uploads cannot be larger
+    /// than this
+    explicit UploadQueue(size_t stagingSize);
+    UploadQueue(UploadQueue&& old) noexcept = default;
+    UploadQueue& operator=(UploadQueue&& old) noexcept = default;
+    UploadQueue(const UploadQueue&) = delete;
+    UploadQueue& operator=(const UploadQueue&) = delete;
+    ~UploadQueue();
+
+    /// @brief Stages data to be copied into a buffer
+    /// @param target The buffer to upload to. Does not need to have been created with BufferStorageFlag::DYNAMIC_STORAGE
+    /// @param data The data to upload
+    /// @param targetOffset The offset in the target buffer, in bytes
+    void UploadBuffer(Buffer& target, TriviallyCopyableByteSpan data, uint64_t targetOffset = 0);
+
+    /// @brief Stages an image to be copied into a texture. The parameters are the same as Texture::UpdateImage
+    void UploadImage(Texture& target, const TextureUpdateInfo& info);
+
+    /// @brief Stages a compressed image to be copied into a texture. The parameters are the same as
+    /// Texture::UpdateCompressedImage
+    void UploadCompressedImage(Texture& target, const CompressedTextureUpdateInfo& info);
+
+    /// @brief Executes every staged operation
+    void Flush();
+
+    /// @brief Gets the size of the staging ring, in bytes
+    [[nodiscard]] size_t StagingSize() const noexcept
+    {
+      return stagingSize_;
+    }
+
+    /// @brief Gets the number of bytes that have been staged since the last Flush()
+    [[nodiscard]] size_t PendingBytes() const noexcept
+    {
+      return static_cast<size_t>(head_ - pendingStart_);
+    }
+
+  private:
+    struct BufferCopy
+    {
+      Buffer* target;
+      uint64_t stagingOffset;
+      uint64_t targetOffset;
+      uint64_t size;
+    };
+
+    struct ImageCopy
+    {
+      Texture* target;
+      uint64_t stagingOffset;
+      TextureUpdateInfo info;
+    };
+
+    struct CompressedImageCopy
+    {
+      Texture* target;
+      uint64_t stagingOffset;
+      CompressedTextureUpdateInfo info;
+    };
+
+    struct Batch
+    {
+      uint64_t timelineValue;
+      uint64_t end;
+    };
+
+    // Returns the offset of size bytes of free staging memory
+    uint64_t Allocate(size_t size);
+
+    size_t stagingSize_{};
+    Buffer stagingBuffer_;
+
+    // Monotonic positions in the ring. The staging offset of a position is position % stagingSize_
+    uint64_t head_{};
+    uint64_t tail_{};
+    uint64_t pendingStart_{};
+
+    std::vector<std::variant<BufferCopy, ImageCopy, CompressedImageCopy>> pendingCopies_;
+    std::deque<Batch> batches_;
+    Timeline timeline_;
+  };
+} // namespace Fwog
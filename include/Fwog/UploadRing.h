@@ -0,0 +1,115 @@
+#pragma once
+#include <Fwog/Config.h>
+#include <Fwog/Buffer.h>
+#include <Fwog/Timeline.h>
+#include <cstdint>
+#include <vector>
+
+namespace Fwog
+{
+  class UploadRing;
+
+  /// @brief A range of an UploadRing's buffer that was written by the CPU this frame
+  ///
+  /// The range can be bound directly with Cmd::BindUniformBuffer or Cmd::BindStorageBuffer:
+  /// @code
+  /// auto alloc = ring.AllocateUniform(uniforms);
+  /// Fwog::Cmd::BindUniformBuffer(0, alloc.GetBuffer(), alloc.offset, alloc.size);
+  /// @endcode
+  struct UploadRingAllocation
+  {
+    /// @brief Gets the buffer that contains this allocation
+    [[nodiscard]] const Buffer& GetBuffer() const noexcept;
+
+    /// @brief The ring this allocation was made from
+    /// @note Moving the ring invalidates this pointer, so allocations must not be used after their ring is moved
+    const UploadRing* ring = nullptr;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+
+    /// @brief A pointer to the mapped memory backing this allocation
+    void* data = nullptr;
+  };
+
+  /// @brief A persistently mapped buffer that is split into per-frame regions for streaming small, short-lived data
+  ///
+  /// Each frame, allocations are linearly suballocated from the current region. When a frame ends, the ring's timeline
+  /// is signaled. That region is not written to again until the GPU has reached the signaled value, which happens
+  /// after framesInFlight frames. This avoids the implicit synchronization (or driver-side copies) that occur
+  /// when a buffer that may still be in use by the GPU is updated with Buffer::UpdateData.
+  ///
+  /// Usage:
+  /// @code
+  /// ring.BeginFrame();
+  /// // ... allocate and draw ...
+  /// ring.EndFrame();
+  /// @endcode
+  class UploadRing
+  {
+  public:
+    /// @brief Constructs the ring
+    /// @param frameSize The number of bytes that can be allocated each frame
+    /// @param framesInFlight The number of frames the CPU may record ahead of the GPU
+    explicit UploadRing(size_t frameSize, uint32_t framesInFlight = 3);
+    UploadRing(UploadRing&& old) noexcept = default;
+    UploadRing& operator=(UploadRing&& old) noexcept = default;
+    UploadRing(const UploadRing&) = delete;
+    UploadRing& operator=(const UploadRing&) = delete;
+    ~UploadRing() = default;
+
+    /// @brief Begins a frame, waiting for the GPU to finish consuming the region that will be written to
+    void BeginFrame();
+
+    /// @brief Ends a frame, signaling a timeline value that protects the current region
+    void EndFrame();
+
+    /// @brief Allocates uninitialized memory from the current frame's region
+    /// @param size The size of the allocation, in bytes
+    /// @param alignment The required alignment of the allocation's offset. Must be a power of two
+    /// @note The sum of all allocations made in a frame (including alignment) must not exceed the frame size
+    [[nodiscard]] UploadRingAllocation Allocate(size_t size, size_t alignment);
+
+    /// @brief Allocates and copies data that is suitable for binding as a uniform buffer
+    ///
+    /// The allocation is aligned to DeviceLimits::uniformBufferOffsetAlignment.
+    [[nodiscard]] UploadRingAllocation AllocateUniform(TriviallyCopyableByteSpan data);
+
+    /// @brief Allocates and copies data that is suitable for binding as a storage buffer
+    ///
+    /// The allocation is aligned to DeviceLimits::shaderStorageBufferOffsetAlignment.
+    [[nodiscard]] UploadRingAllocation AllocateStorage(TriviallyCopyableByteSpan data);
+
+    [[nodiscard]] const Buffer& GetBuffer() const noexcept
+    {
+      return buffer_;
+    }
+
+    /// @brief Gets the number of bytes that can be allocated each frame
+    [[nodiscard]] size_t FrameSize() const noexcept
+    {
+      return frameSize_;
+    }
+
+    /// @brief Gets the number of bytes allocated in the current frame, including alignment padding
+    [[nodiscard]] size_t FrameBytesUsed() const noexcept
+    {
+      return head_ - frameIndex_ * frameSize_;
+    }
+
+  private:
+    size_t frameSize_{};
+    uint32_t framesInFlight_{};
+    uint32_t frameIndex_{};
+    size_t head_{};
+    Buffer buffer_;
+    Timeline timeline_;
+
+    // The timeline value that protects each region, or zero if the region has never been used
+    std::vector<uint64_t> regionValues_;
+  };
+
+  inline const Buffer& UploadRingAllocation::GetBuffer() const noexcept
+  {
+    return ring->GetBuffer();
+  }
+} // namespace Fwog
@@ -34,6 +34,12 @@ namespace Fwog::detail
 
   bool IsBlockCompressedFormat(Format format);
 
+  // The size of a texel of client pixel data with the given format and type, in bytes
+  uint32_t TexelSizeGL(GLenum format, GLenum type);
+
+  // The number of bytes of client memory that a pixel transfer operation reads or writes
+  uint64_t PixelDataSizeGL(GLenum format, GLenum type, Extent3D extent, uint32_t rowLength, uint32_t imageHeight);
+
   ////////////////////////////////////////////////////////// pipeline
   GLenum CullModeToGL(CullMode mode);
   GLenum PolygonModeToGL(PolygonMode mode);
@@ -2,12 +2,18 @@
 #include <Fwog/Context.h>
 
 #include <Fwog/BasicTypes.h>
+#include <Fwog/Buffer.h>
+#include <Fwog/Timeline.h>
 #include <Fwog/detail/FramebufferCache.h>
 #include <Fwog/detail/PipelineManager.h>
+#include <Fwog/detail/ResourceRegistry.h>
 #include <Fwog/detail/SamplerCache.h>
+#include <Fwog/detail/TextureViewCache.h>
 #include <Fwog/detail/VertexArrayCache.h>
 
+#include <deque>
 #include <memory>
+#include <vector>
 
 #include FWOG_OPENGL_HEADER
 
@@ -15,6 +21,30 @@ namespace Fwog::detail
 {
   constexpr int MAX_COLOR_ATTACHMENTS = 8;
 
+  // A GL object whose deletion has been postponed until the GPU has reached a timeline value
+  struct DeferredDestruction
+  {
+    enum class Type
+    {
+      BUFFER,
+      TEXTURE,
+      GRAPHICS_PIPELINE,
+      COMPUTE_PIPELINE,
+    };
+
+    Type type;
+    uint32_t id;
+    uint64_t bindlessHandle; // Textures only
+    uint64_t timelineValue;
+  };
+
+  // A staging buffer that is read by an asynchronous upload until the GPU has reached a timeline value
+  struct InFlightStagingBuffer
+  {
+    Buffer buffer;
+    uint64_t timelineValue;
+  };
+
   struct ContextState
   {
     DeviceProperties properties;
@@ -69,13 +99,33 @@ namespace Fwog::detail
     PrimitiveTopology currentTopology{};
     IndexType currentIndexType{};
 
+    // Declared before the caches, as the view cache removes views from it when it is destroyed
+    detail::ResourceRegistry resourceRegistry;
+
     detail::FramebufferCache fboCache;
     detail::VertexArrayCache vaoCache;
     detail::SamplerCache samplerCache;
+    detail::TextureViewCache textureViewCache;
+
+    // Mapped buffers that are recycled by ReadbackBuffer and ReadbackTexture
+    std::vector<Buffer> readbackBufferPool;
+
+    // Mapped buffers that are recycled by Texture::UpdateImageAsync and Texture::UpdateCompressedImageAsync
+    std::vector<Buffer> stagingBufferPool;
+    std::deque<InFlightStagingBuffer> inFlightStagingBuffers;
+    Timeline stagingTimeline;
+
+    bool isDeferredDestructionEnabled = false;
+    Timeline destructionTimeline;
+    std::deque<DeferredDestruction> deferredDestructions;
   } inline* context = nullptr;
 
   // Clears all resource bindings.
   // This is called at the beginning of rendering/compute scopes 
   // or when the pipeline state has been invalidated, but only in debug mode.
   void ZeroResourceBindings();
+
+  // Queues an object for destruction if deferred destruction is enabled.
+  // Returns false if the caller must delete the object immediately.
+  bool TryDeferDestruction(DeferredDestruction::Type type, uint32_t id, uint64_t bindlessHandle = 0);
 } // namespace Fwog::detail
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <vector>
 #include <optional>
+#include <span>
 
 namespace Fwog::detail
 {
@@ -50,6 +51,9 @@ namespace Fwog::detail
 
     void RemoveTexture(const Texture& texture);
 
+    // Removes every framebuffer that references any of the textures in a single pass
+    void RemoveTextures(std::span<const uint32_t> textureIds);
+
   private:
     std::vector<RenderAttachments> framebufferCacheKey_;
     std::vector<uint32_t> framebufferCacheValue_;
@@ -0,0 +1,84 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Fwog::detail
+{
+  // A two-level segregated fit (TLSF) allocator that manages offsets into an abstract range of units.
+  // Allocation and deallocation are O(1). No memory is touched, so it is suitable for suballocating GPU memory.
+  //
+  // Free regions are binned by size with a tiny floating point representation (5 exponent bits + 3 mantissa bits).
+  // Two levels of bitmasks allow the smallest bin that can satisfy an allocation to be found with two bit scans.
+  // Adjacent free regions are coalesced when an allocation is freed.
+  class OffsetAllocator
+  {
+  public:
+    static constexpr uint32_t NO_SPACE = 0xFFFFFFFF;
+
+    struct Allocation
+    {
+      uint32_t offset = NO_SPACE;
+      uint32_t node = NO_SPACE;
+    };
+
+    struct Stats
+    {
+      uint32_t totalFree{};
+      uint32_t largestFreeRegion{};
+      uint32_t freeRegionCount{};
+      uint32_t allocationCount{};
+    };
+
+    explicit OffsetAllocator(uint32_t size);
+
+    // Returns an allocation with offset == NO_SPACE if no free region is large enough
+    [[nodiscard]] Allocation Allocate(uint32_t size);
+    void Free(Allocation allocation);
+
+    [[nodiscard]] uint32_t Size() const noexcept
+    {
+      return size_;
+    }
+
+    [[nodiscard]] uint32_t AllocationSize(Allocation allocation) const;
+    [[nodiscard]] Stats GetStats() const;
+
+    // Returns every live allocation, sorted by offset
+    [[nodiscard]] std::vector<Allocation> GetAllocations() const;
+
+  private:
+    static constexpr uint32_t NUM_TOP_BINS = 32;
+    static constexpr uint32_t BINS_PER_LEAF = 8;
+    static constexpr uint32_t TOP_BINS_INDEX_SHIFT = 3;
+    static constexpr uint32_t LEAF_BINS_INDEX_MASK = 0x7;
+    static constexpr uint32_t NUM_LEAF_BINS = NUM_TOP_BINS * BINS_PER_LEAF;
+    static constexpr uint32_t UNUSED = 0xFFFFFFFF;
+
+    struct Node
+    {
+      uint32_t dataOffset = 0;
+      uint32_t dataSize = 0;
+      uint32_t binListPrev = UNUSED;
+      uint32_t binListNext = UNUSED;
+      uint32_t neighborPrev = UNUSED;
+      uint32_t neighborNext = UNUSED;
+      bool used = false;
+    };
+
+    uint32_t InsertNodeIntoBin(uint32_t size, uint32_t dataOffset);
+    void RemoveNodeFromBin(uint32_t nodeIndex);
+    uint32_t AcquireNode();
+
+    uint32_t size_{};
+    uint32_t freeStorage_{};
+    uint32_t allocationCount_{};
+
+    uint32_t usedBinsTop_{};
+    std::array<uint8_t, NUM_TOP_BINS> usedBins_{};
+    std::array<uint32_t, NUM_LEAF_BINS> binIndices_{};
+
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> freeNodes_;
+  };
+} // namespace Fwog::detail
@@ -0,0 +1,40 @@
+#pragma once
+#include "Fwog/MemoryUsage.h"
+#include "Fwog/Texture.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Fwog::detail
+{
+  // Drivers may pad textures, so this is only an estimate
+  uint64_t EstimateTextureSize(const TextureCreateInfo& createInfo);
+
+  // Tracks the estimated size of every live buffer, texture, and texture view for GetMemoryUsage. Resources are removed
+  // when their GL object is deleted, rather than when the object that owns it is destroyed
+  class ResourceRegistry
+  {
+  public:
+    void AddBuffer(uint32_t id, uint64_t bytes, std::string_view name);
+    void AddTexture(uint32_t id, ResourceCategory category, uint64_t bytes, std::string_view name);
+    void RemoveBuffer(uint32_t id);
+
+    // Textures and views share a namespace, so this removes either
+    void RemoveTexture(uint32_t id);
+
+    [[nodiscard]] MemoryUsage GetUsage() const;
+
+  private:
+    struct Resource
+    {
+      ResourceCategory category;
+      uint64_t bytes;
+      std::string name;
+    };
+
+    std::unordered_map<uint32_t, Resource> buffers_;
+    std::unordered_map<uint32_t, Resource> textures_;
+  };
+} // namespace Fwog::detail
@@ -0,0 +1,61 @@
+#pragma once
+#include "Fwog/Texture.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace Fwog::detail
+{
+  // Owns the views created by Texture::CreateCachedView, so that views with the same parameters share one GL texture.
+  // Each view is refcounted by the TextureView objects that reference it. A view stays in the cache while its parent
+  // exists, even when nothing references it, so views that are recreated every frame are only created once. Views are
+  // deleted once their parent has been deleted and they are no longer referenced.
+  class TextureViewCache
+  {
+  public:
+    TextureViewCache() = default;
+    TextureViewCache(const TextureViewCache&) = delete;
+    TextureViewCache& operator=(const TextureViewCache&) = delete;
+    TextureViewCache(TextureViewCache&&) noexcept = default;
+    TextureViewCache& operator=(TextureViewCache&&) noexcept = default;
+
+    ~TextureViewCache()
+    {
+      Clear();
+    }
+
+    // Returns a cached view and adds a reference to it, or nullopt if there is none
+    std::optional<uint32_t> Acquire(uint32_t parentId, const TextureViewCreateInfo& viewInfo);
+
+    // Adds a view that was just created, with one reference
+    void Insert(uint32_t parentId, const TextureViewCreateInfo& viewInfo, uint32_t viewId);
+
+    void Release(uint32_t viewId);
+
+    // Must be called when a texture is deleted. Views of it that are not referenced are deleted
+    void RemoveParent(uint32_t parentId);
+
+    [[nodiscard]] size_t Size() const
+    {
+      return views_.size();
+    }
+
+    void Clear();
+
+  private:
+    struct View
+    {
+      TextureViewCreateInfo viewInfo;
+      uint32_t refCount;
+      bool isOrphaned; // The parent has been deleted
+    };
+
+    void Destroy(uint32_t viewId);
+
+    std::unordered_map<uint32_t, View> views_;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> viewsOfParent_;
+  };
+} // namespace Fwog::detail
@@ -0,0 +1,255 @@
+#include <Fwog/BindlessTextureTable.h>
+#include <Fwog/detail/ContextState.h>
+
+#include <algorithm>
+#include <new>
+#include <numeric>
+#include <utility>
+
+#include FWOG_OPENGL_HEADER
+
+namespace Fwog
+{
+  namespace
+  {
+    uint64_t MakeKey(uint32_t texture, uint32_t sampler)
+    {
+      return (static_cast<uint64_t>(texture) << 32) | sampler;
+    }
+  } // namespace
+
+  BindlessTextureTable::BindlessTextureTable(const BindlessTextureTableCreateInfo& createInfo)
+    : isSupported_(detail::context->properties.features.bindlessTextures),
+      residencyBudget_(createInfo.residencyBudget),
+      slots_(createInfo.capacity),
+      freeSlots_(createInfo.capacity),
+      handleBuffer_(sizeof(uint64_t) * createInfo.capacity, BufferStorageFlag::DYNAMIC_STORAGE)
+  {
+    FWOG_ASSERT(createInfo.capacity > 0);
+
+    // Slots are handed out from the back, so this makes the first slot 0
+    std::iota(freeSlots_.rbegin(), freeSlots_.rend(), 0u);
+
+    if (!isSupported_)
+    {
+      handleBuffer_.ClearSubData({.internalFormat = Format::R32_UINT});
+      return;
+    }
+
+    fallbackTexture_ = CreateTexture2D({1, 1}, Format::R8G8B8A8_UNORM, "Bindless fallback");
+    const uint8_t white[4] = {255, 255, 255, 255};
+    fallbackTexture_->UpdateImage({.extent = {1, 1, 1}, .format = UploadFormat::RGBA, .pixels = white});
+    fallbackHandle_ = glGetTextureSamplerHandleARB(fallbackTexture_->Handle(), Sampler(SamplerState{}).Handle());
+    glMakeTextureHandleResidentARB(fallbackHandle_);
+
+    const auto fallbackHandles = std::vector<uint64_t>(createInfo.capacity, fallbackHandle_);
+    handleBuffer_.UpdateData(std::span(fallbackHandles));
+  }
+
+  BindlessTextureTable::BindlessTextureTable(BindlessTextureTable&& old) noexcept
+    : isSupported_(old.isSupported_),
+      residencyBudget_(old.residencyBudget_),
+      residentBytes_(std::exchange(old.residentBytes_, 0)),
+      evictionCount_(old.evictionCount_),
+      commitIndex_(old.commitIndex_),
+      dirtyBegin_(old.dirtyBegin_),
+      dirtyEnd_(old.dirtyEnd_),
+      slots_(std::move(old.slots_)),
+      freeSlots_(std::move(old.freeSlots_)),
+      slotOfKey_(std::move(old.slotOfKey_)),
+      fallbackTexture_(std::move(old.fallbackTexture_)),
+      fallbackHandle_(std::exchange(old.fallbackHandle_, 0)),
+      handleBuffer_(std::move(old.handleBuffer_))
+  {
+    // The old table must not make the handles non-resident
+    old.slots_.clear();
+  }
+
+  BindlessTextureTable& BindlessTextureTable::operator=(BindlessTextureTable&& old) noexcept
+  {
+    if (&old == this)
+      return *this;
+    this->~BindlessTextureTable();
+    return *new (this) BindlessTextureTable(std::move(old));
+  }
+
+  BindlessTextureTable::~BindlessTextureTable()
+  {
+    if (!isSupported_)
+    {
+      return;
+    }
+
+    for (auto& slot : slots_)
+    {
+      if (slot.isResident)
+      {
+        glMakeTextureHandleNonResidentARB(slot.handle);
+      }
+    }
+
+    if (fallbackHandle_ != 0)
+    {
+      glMakeTextureHandleNonResidentARB(fallbackHandle_);
+    }
+  }
+
+  uint32_t BindlessTextureTable::Add(Texture& texture, const SamplerState& samplerState)
+  {
+    const auto sampler = Sampler(samplerState);
+    const auto key = MakeKey(texture.Handle(), sampler.Handle());
+    if (auto it = slotOfKey_.find(key); it != slotOfKey_.end())
+    {
+      return it->second;
+    }
+
+    FWOG_ASSERT(!freeSlots_.empty() && "The bindless texture table is full");
+    const auto index = freeSlots_.back();
+    freeSlots_.pop_back();
+
+    auto& slot = slots_[index];
+    slot = Slot{
+      .key = key,
+      .handle = isSupported_ ? glGetTextureSamplerHandleARB(texture.Handle(), sampler.Handle()) : 0,
+      .size = detail::EstimateTextureSize(texture.GetCreateInfo()),
+    };
+    slotOfKey_.emplace(key, index);
+    return index;
+  }
+
+  void BindlessTextureTable::Remove(uint32_t index)
+  {
+    FWOG_ASSERT(index < slots_.size() && slots_[index].key != 0);
+
+    // The handle is invalid as soon as it is non-resident, so the slot can't wait for the next commit to be updated
+    auto& slot = slots_[index];
+    if (slot.isResident)
+    {
+      MakeNonResident(slot);
+      if (isSupported_)
+      {
+        handleBuffer_.UpdateData(fallbackHandle_, sizeof(uint64_t) * index);
+      }
+    }
+
+    slotOfKey_.erase(slot.key);
+    slot = {};
+    freeSlots_.push_back(index);
+  }
+
+  void BindlessTextureTable::MarkUsed(uint32_t index)
+  {
+    FWOG_ASSERT(index < slots_.size() && slots_[index].key != 0);
+    slots_[index].isUsed = true;
+  }
+
+  void BindlessTextureTable::MarkAllUsed()
+  {
+    for (auto& slot : slots_)
+    {
+      slot.isUsed = slot.key != 0;
+    }
+  }
+
+  void BindlessTextureTable::Commit()
+  {
+    commitIndex_++;
+
+    std::vector<uint32_t> evictionCandidates;
+    for (uint32_t i = 0; i < slots_.size(); i++)
+    {
+      auto& slot = slots_[i];
+      if (slot.isUsed)
+      {
+        slot.lastUsedCommit = commitIndex_;
+        slot.isUsed = false;
+        if (!slot.isResident)
+        {
+          MakeResident(slot);
+          MarkDirty(i);
+        }
+      }
+      else if (slot.isResident)
+      {
+        evictionCandidates.push_back(i);
+      }
+    }
+
+    // Handles that are used by this commit are never evicted, so the budget can be exceeded
+    if (residencyBudget_ != 0 && residentBytes_ > residencyBudget_)
+    {
+      std::ranges::sort(evictionCandidates, {}, [this](uint32_t i) { return slots_[i].lastUsedCommit; });
+      for (auto i : evictionCandidates)
+      {
+        if (residentBytes_ <= residencyBudget_)
+        {
+          break;
+        }
+        MakeNonResident(slots_[i]);
+        MarkDirty(i);
+        evictionCount_++;
+      }
+    }
+
+    if (dirtyBegin_ >= dirtyEnd_ || !isSupported_)
+    {
+      dirtyBegin_ = dirtyEnd_ = 0;
+      return;
+    }
+
+    std::vector<uint64_t> handles;
+    handles.reserve(dirtyEnd_ - dirtyBegin_);
+    for (uint32_t i = dirtyBegin_; i < dirtyEnd_; i++)
+    {
+      handles.push_back(slots_[i].isResident ? slots_[i].handle : fallbackHandle_);
+    }
+    handleBuffer_.UpdateData(std::span(handles), sizeof(uint64_t) * dirtyBegin_);
+    dirtyBegin_ = dirtyEnd_ = 0;
+  }
+
+  BindlessTextureTableStats BindlessTextureTable::GetStats() const
+  {
+    BindlessTextureTableStats stats{
+      .slotCount = static_cast<uint32_t>(slots_.size() - freeSlots_.size()),
+      .residentBytes = residentBytes_,
+      .evictionCount = evictionCount_,
+    };
+    for (const auto& slot : slots_)
+    {
+      stats.residentCount += slot.isResident;
+    }
+    return stats;
+  }
+
+  void BindlessTextureTable::MakeResident(Slot& slot)
+  {
+    if (isSupported_)
+    {
+      glMakeTextureHandleResidentARB(slot.handle);
+    }
+    slot.isResident = true;
+    residentBytes_ += slot.size;
+  }
+
+  void BindlessTextureTable::MakeNonResident(Slot& slot)
+  {
+    if (isSupported_)
+    {
+      glMakeTextureHandleNonResidentARB(slot.handle);
+    }
+    slot.isResident = false;
+    residentBytes_ -= slot.size;
+  }
+
+  void BindlessTextureTable::MarkDirty(uint32_t index)
+  {
+    if (dirtyBegin_ >= dirtyEnd_)
+    {
+      dirtyBegin_ = index;
+      dirtyEnd_ = index + 1;
+      return;
+    }
+    dirtyBegin_ = std::min(dirtyBegin_, index);
+    dirtyEnd_ = std::max(dirtyEnd_, index + 1);
+  }
+} // namespace Fwog
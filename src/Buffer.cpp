@@ -1,11 +1,12 @@
 #include <Fwog/Buffer.h>
 #include <Fwog/detail/ApiToEnum.h>
+#include <Fwog/detail/ContextState.h>
 #include <utility>
 #include FWOG_OPENGL_HEADER
 
 namespace Fwog
 {
-  Buffer::Buffer(const void* data, size_t size, BufferStorageFlags storageFlags)
+  Buffer::Buffer(const void* data, size_t size, BufferStorageFlags storageFlags, std::string_view name)
     : size_(std::max(size, static_cast<size_t>(1))), storageFlags_(storageFlags)
   {
     GLbitfield glflags = detail::BufferStorageFlagsToGL(storageFlags);
@@ -14,15 +15,26 @@ namespace Fwog
     if (storageFlags & BufferStorageFlag::MAP_MEMORY)
     {
       // GL_MAP_UNSYNCHRONIZED_BIT should be used if the user can map and unmap buffers at their own will
-      constexpr GLenum access = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+      GLenum access = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT;
+      access |= storageFlags & BufferStorageFlag::MAP_NON_COHERENT ? GL_MAP_FLUSH_EXPLICIT_BIT : GL_MAP_COHERENT_BIT;
       mappedMemory_ = glMapNamedBufferRange(id_, 0, size_, access);
     }
+
+    if (!name.empty())
+    {
+      glObjectLabel(GL_BUFFER, id_, static_cast<GLsizei>(name.length()), name.data());
+    }
+
+    detail::context->resourceRegistry.AddBuffer(id_, size_, name);
   }
 
-  Buffer::Buffer(size_t size, BufferStorageFlags storageFlags) : Buffer(nullptr, size, storageFlags) {}
+  Buffer::Buffer(size_t size, BufferStorageFlags storageFlags, std::string_view name)
+    : Buffer(nullptr, size, storageFlags, name)
+  {
+  }
 
-  Buffer::Buffer(TriviallyCopyableByteSpan data, BufferStorageFlags storageFlags)
-    : Buffer(data.data(), data.size_bytes(), storageFlags)
+  Buffer::Buffer(TriviallyCopyableByteSpan data, BufferStorageFlags storageFlags, std::string_view name)
+    : Buffer(data.data(), data.size_bytes(), storageFlags, name)
   {
   }
 
@@ -50,7 +62,11 @@ namespace Fwog
       {
         glUnmapNamedBuffer(id_);
       }
-      glDeleteBuffers(1, &id_);
+      if (!detail::TryDeferDestruction(detail::DeferredDestruction::Type::BUFFER, id_))
+      {
+        glDeleteBuffers(1, &id_);
+        detail::context->resourceRegistry.RemoveBuffer(id_);
+      }
     }
   }
 
@@ -67,14 +83,49 @@ namespace Fwog
     glNamedBufferSubData(id_, static_cast<GLuint>(offset), static_cast<GLuint>(size), data);
   }
 
+  void Buffer::FlushMappedRange(size_t offset, size_t size)
+  {
+    FWOG_ASSERT(mappedMemory_ && "FlushMappedRange can only be called on mapped buffers");
+    if (size == WHOLE_BUFFER)
+    {
+      size = size_ - offset;
+    }
+    FWOG_ASSERT(offset + size <= size_);
+
+    if (storageFlags_ & BufferStorageFlag::MAP_NON_COHERENT)
+    {
+      glFlushMappedNamedBufferRange(id_, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size));
+    }
+  }
+
+  void Buffer::InvalidateMappedRange([[maybe_unused]] size_t offset, [[maybe_unused]] size_t size)
+  {
+    FWOG_ASSERT(mappedMemory_ && "InvalidateMappedRange can only be called on mapped buffers");
+    FWOG_ASSERT(size == WHOLE_BUFFER || offset + size <= size_);
+
+    if (storageFlags_ & BufferStorageFlag::MAP_NON_COHERENT)
+    {
+      glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+    }
+  }
+
   void Buffer::ClearSubData(const BufferClearInfo& clear)
   {
+    const auto size = clear.size == WHOLE_BUFFER ? size_ - clear.offset : clear.size;
+    FWOG_ASSERT(clear.offset + size <= size_);
+
+    const GLenum format = clear.uploadFormat == UploadFormat::INFER_FORMAT
+                            ? detail::UploadFormatToGL(detail::FormatToUploadFormat(clear.internalFormat))
+                            : detail::UploadFormatToGL(clear.uploadFormat);
+    const GLenum type = clear.uploadType == UploadType::INFER_TYPE ? detail::FormatToTypeGL(clear.internalFormat)
+                                                                   : detail::UploadTypeToGL(clear.uploadType);
+
     glClearNamedBufferSubData(id_,
                               detail::FormatToGL(clear.internalFormat),
                               clear.offset,
-                              clear.size,
-                              detail::UploadFormatToGL(clear.uploadFormat),
-                              detail::UploadTypeToGL(clear.uploadType),
+                              size,
+                              format,
+                              type,
                               clear.data);
   }
 
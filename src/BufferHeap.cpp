@@ -0,0 +1,323 @@
+#include <Fwog/BufferHeap.h>
+#include <Fwog/Rendering.h>
+
+#include <algorithm>
+
+namespace Fwog
+{
+  BufferHeap::BufferHeap(uint64_t blockSize, uint64_t alignment, BufferStorageFlags storageFlags)
+    : blockSize_(blockSize), alignment_(alignment), storageFlags_(storageFlags)
+  {
+    FWOG_ASSERT(blockSize > 0);
+    FWOG_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+    FWOG_ASSERT(ToGranules(blockSize) < detail::OffsetAllocator::NO_SPACE && "Block size is too large for the alignment");
+  }
+
+  BufferHeap::~BufferHeap() = default;
+
+  BufferHeapAllocation BufferHeap::Allocate(uint64_t size)
+  {
+    FWOG_ASSERT(size > 0);
+
+    const uint64_t granules = ToGranules(size);
+    FWOG_ASSERT(granules < detail::OffsetAllocator::NO_SPACE && "Allocation is too large for the alignment");
+
+    auto tryAllocate = [&](uint32_t blockIndex) -> BufferHeapAllocation
+    {
+      auto& block = *blocks_[blockIndex];
+      const auto alloc = block.allocator.Allocate(static_cast<uint32_t>(granules));
+      if (alloc.offset == detail::OffsetAllocator::NO_SPACE)
+      {
+        return {};
+      }
+
+      return BufferHeapAllocation{
+        .buffer = &block.buffer,
+        .offset = alloc.offset * alignment_,
+        .size = size,
+        .blockIndex = blockIndex,
+        .node = alloc.node,
+      };
+    };
+
+    if (size > blockSize_)
+    {
+      return tryAllocate(CreateBlock(granules * alignment_, true));
+    }
+
+    for (uint32_t i = 0; i < blocks_.size(); i++)
+    {
+      if (blocks_[i] && !blocks_[i]->isDedicated)
+      {
+        if (auto alloc = tryAllocate(i); alloc.IsValid())
+        {
+          return alloc;
+        }
+      }
+    }
+
+    return tryAllocate(CreateBlock(blockSize_, false));
+  }
+
+  BufferHeapAllocation BufferHeap::Allocate(TriviallyCopyableByteSpan data)
+  {
+    auto alloc = Allocate(data.size_bytes());
+    alloc.buffer->UpdateData(data, alloc.offset);
+    return alloc;
+  }
+
+  void BufferHeap::Free(BufferHeapAllocation& allocation)
+  {
+    FWOG_ASSERT(allocation.IsValid());
+    FWOG_ASSERT(allocation.blockIndex < blocks_.size() && blocks_[allocation.blockIndex]);
+
+    auto& block = blocks_[allocation.blockIndex];
+    FWOG_ASSERT(&block->buffer == allocation.buffer && "Allocation does not belong to this heap");
+
+    block->allocator.Free({static_cast<uint32_t>(allocation.offset / alignment_), allocation.node});
+
+    if (block->isDedicated)
+    {
+      block.reset();
+    }
+
+    allocation = {};
+  }
+
+  void BufferHeap::Reallocate(BufferHeapAllocation& allocation, uint64_t newSize)
+  {
+    FWOG_ASSERT(allocation.IsValid());
+    FWOG_ASSERT(newSize > 0);
+
+    const auto& block = *blocks_[allocation.blockIndex];
+    const uint64_t paddedSize =
+      uint64_t(block.allocator.AllocationSize({static_cast<uint32_t>(allocation.offset / alignment_), allocation.node})) *
+      alignment_;
+
+    if (newSize <= paddedSize)
+    {
+      allocation.size = newSize;
+      return;
+    }
+
+    auto newAllocation = Allocate(newSize);
+    CopyBuffer({
+      .source = *allocation.buffer,
+      .target = *newAllocation.buffer,
+      .sourceOffset = allocation.offset,
+      .targetOffset = newAllocation.offset,
+      .size = std::min(allocation.size, newSize),
+    });
+    Free(allocation);
+    allocation = newAllocation;
+  }
+
+  std::vector<BufferHeapRelocation> BufferHeap::Defragment(const BufferHeapDefragmentInfo& info)
+  {
+    std::vector<BufferHeapRelocation> relocations;
+
+    // Rank non-dedicated blocks from most to least occupied. Allocations only move to blocks that rank higher than
+    // their own, or to a lower offset in their own block
+    std::vector<uint32_t> blockOrder;
+    for (uint32_t i = 0; i < blocks_.size(); i++)
+    {
+      if (blocks_[i] && !blocks_[i]->isDedicated)
+      {
+        blockOrder.push_back(i);
+      }
+    }
+
+    std::vector<uint32_t> blockFree(blocks_.size());
+    for (auto i : blockOrder)
+    {
+      blockFree[i] = blocks_[i]->allocator.GetStats().totalFree;
+    }
+    std::ranges::stable_sort(blockOrder, {}, [&](uint32_t i) { return blockFree[i]; });
+
+    uint64_t bytesMoved = 0;
+
+    // Evacuate the least occupied blocks first, starting from the end of each block
+    for (size_t rank = blockOrder.size(); rank-- > 0;)
+    {
+      const uint32_t srcBlockIndex = blockOrder[rank];
+      auto candidates = blocks_[srcBlockIndex]->allocator.GetAllocations();
+
+      for (auto it = candidates.rbegin(); it != candidates.rend(); ++it)
+      {
+        auto& srcAllocator = blocks_[srcBlockIndex]->allocator;
+        const uint32_t granules = srcAllocator.AllocationSize(*it);
+        const uint64_t size = uint64_t(granules) * alignment_;
+
+        if (relocations.size() >= info.maxMoves || bytesMoved + size > info.maxBytesToMove)
+        {
+          break;
+        }
+
+        // Find a better location, trying the most occupied blocks first
+        uint32_t dstBlockIndex = detail::OffsetAllocator::NO_SPACE;
+        detail::OffsetAllocator::Allocation dst{};
+        for (size_t dstRank = 0; dstRank <= rank; dstRank++)
+        {
+          auto& dstAllocator = blocks_[blockOrder[dstRank]]->allocator;
+          dst = dstAllocator.Allocate(granules);
+          if (dst.offset == detail::OffsetAllocator::NO_SPACE)
+          {
+            continue;
+          }
+
+          if (dstRank == rank && dst.offset >= it->offset)
+          {
+            // Moving within the same block is only useful if it makes the allocation lower
+            dstAllocator.Free(dst);
+            break;
+          }
+
+          dstBlockIndex = blockOrder[dstRank];
+          break;
+        }
+
+        if (dstBlockIndex == detail::OffsetAllocator::NO_SPACE)
+        {
+          continue;
+        }
+
+        const auto relocation = BufferHeapRelocation{
+          .oldBlockIndex = srcBlockIndex,
+          .oldOffset = it->offset * alignment_,
+          .newBlockIndex = dstBlockIndex,
+          .newOffset = dst.offset * alignment_,
+          .newNode = dst.node,
+          .size = size,
+        };
+
+        CopyBuffer({
+          .source = blocks_[srcBlockIndex]->buffer,
+          .target = blocks_[dstBlockIndex]->buffer,
+          .sourceOffset = relocation.oldOffset,
+          .targetOffset = relocation.newOffset,
+          .size = size,
+        });
+        srcAllocator.Free(*it);
+
+        relocations.push_back(relocation);
+        bytesMoved += size;
+      }
+    }
+
+    // Release blocks that were emptied, but keep one around so the next allocation doesn't have to create it again
+    for (size_t rank = blockOrder.size(); rank-- > 1;)
+    {
+      auto& block = blocks_[blockOrder[rank]];
+      if (block->allocator.GetStats().allocationCount == 0)
+      {
+        block.reset();
+      }
+    }
+
+    return relocations;
+  }
+
+  BufferHeapStats BufferHeap::GetStats() const
+  {
+    BufferHeapStats stats{};
+
+    for (const auto& block : blocks_)
+    {
+      if (!block)
+      {
+        continue;
+      }
+
+      const auto blockStats = block->allocator.GetStats();
+      const uint64_t blockBytes = uint64_t(block->allocator.Size()) * alignment_;
+      const uint64_t freeBytes = uint64_t(blockStats.totalFree) * alignment_;
+
+      stats.totalBytes += blockBytes;
+      stats.freeBytes += freeBytes;
+      stats.usedBytes += blockBytes - freeBytes;
+      stats.largestFreeRegion = std::max(stats.largestFreeRegion, uint64_t(blockStats.largestFreeRegion) * alignment_);
+      stats.allocationCount += blockStats.allocationCount;
+      stats.freeRegionCount += blockStats.freeRegionCount;
+      stats.blockCount++;
+    }
+
+    if (stats.freeBytes > 0)
+    {
+      stats.fragmentation = 1.0f - float(double(stats.largestFreeRegion) / double(stats.freeBytes));
+    }
+
+    return stats;
+  }
+
+  uint32_t BufferHeap::CreateBlock(uint64_t size, bool isDedicated)
+  {
+    // The buffer is rounded up to whole granules, so the last granule can't extend past the end of it
+    const auto granules = ToGranules(size);
+    auto block = std::unique_ptr<Block>(new Block{
+      .buffer = Buffer(granules * alignment_, storageFlags_),
+      .allocator = detail::OffsetAllocator(static_cast<uint32_t>(granules)),
+      .isDedicated = isDedicated,
+    });
+
+    // Reuse the slot of a destroyed dedicated block so block indices stay small
+    if (auto it = std::find(blocks_.begin(), blocks_.end(), nullptr); it != blocks_.end())
+    {
+      *it = std::move(block);
+      return static_cast<uint32_t>(it - blocks_.begin());
+    }
+
+    blocks_.emplace_back(std::move(block));
+    return static_cast<uint32_t>(blocks_.size() - 1);
+  }
+
+  bool BufferHeap::ApplyRelocations(std::span<const BufferHeapRelocation> relocations,
+                                    BufferHeapAllocation& allocation) const
+  {
+    // Relocations are in the order they were performed, so an allocation that was moved more than once is followed
+    // through each of its moves. A range that was vacated by one move can't be confused with a later move's source
+    bool moved = false;
+    for (const auto& relocation : relocations)
+    {
+      if (relocation.oldBlockIndex == allocation.blockIndex && relocation.oldOffset == allocation.offset)
+      {
+        allocation.blockIndex = relocation.newBlockIndex;
+        allocation.offset = relocation.newOffset;
+        allocation.node = relocation.newNode;
+        moved = true;
+      }
+    }
+
+    if (moved)
+    {
+      // Resolve the buffer after following every move, as only the final block is guaranteed to still exist
+      FWOG_ASSERT(allocation.blockIndex < blocks_.size() && blocks_[allocation.blockIndex]);
+      allocation.buffer = &blocks_[allocation.blockIndex]->buffer;
+    }
+
+    return moved;
+  }
+
+  uint64_t BufferHeap::ToGranules(uint64_t size) const
+  {
+    return (size + alignment_ - 1) / alignment_;
+  }
+
+  std::vector<BufferHeapRelocationRange> GetRelocationRanges(std::span<const BufferHeapRelocation> relocations)
+  {
+    std::vector<BufferHeapRelocationRange> ranges;
+    ranges.reserve(relocations.size());
+    for (const auto& relocation : relocations)
+    {
+      FWOG_ASSERT(relocation.oldOffset + relocation.size <= UINT32_MAX &&
+                  relocation.newOffset + relocation.size <= UINT32_MAX);
+      ranges.push_back({
+        .oldBlockIndex = relocation.oldBlockIndex,
+        .oldOffset = static_cast<uint32_t>(relocation.oldOffset),
+        .newBlockIndex = relocation.newBlockIndex,
+        .newOffset = static_cast<uint32_t>(relocation.newOffset),
+        .size = static_cast<uint32_t>(relocation.size),
+      });
+    }
+    return ranges;
+  }
+} // namespace Fwog
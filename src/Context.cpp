@@ -2,6 +2,8 @@
 #include <Fwog/detail/ContextState.h>
 #include FWOG_OPENGL_HEADER
 
+#include <vector>
+
 namespace Fwog
 {
   namespace detail
@@ -30,8 +32,64 @@ namespace Fwog
         glBindSampler(i, 0);
       }
     }
+
+    bool TryDeferDestruction(DeferredDestruction::Type type, uint32_t id, uint64_t bindlessHandle)
+    {
+      if (context == nullptr || !context->isDeferredDestructionEnabled)
+      {
+        return false;
+      }
+
+      // The object may be referenced by any command submitted so far, all of which precede the next signaled value
+      const uint64_t timelineValue = context->destructionTimeline.GetSignaledValue() + 1;
+      context->deferredDestructions.push_back({type, id, bindlessHandle, timelineValue});
+      return true;
+    }
   } // namespace detail
 
+  // Deletes every queued object whose timeline value has been reached, batching deletions of the same type
+  static void DestroyDeferredObjects(uint64_t completedValue)
+  {
+    using Type = detail::DeferredDestruction::Type;
+    auto& queue = detail::context->deferredDestructions;
+
+    std::vector<GLuint> buffers;
+    std::vector<GLuint> textures;
+    while (!queue.empty() && queue.front().timelineValue <= completedValue)
+    {
+      const auto& object = queue.front();
+      switch (object.type)
+      {
+      case Type::BUFFER:
+        buffers.push_back(object.id);
+        detail::context->resourceRegistry.RemoveBuffer(object.id);
+        break;
+      case Type::TEXTURE:
+        detail::context->resourceRegistry.RemoveTexture(object.id);
+        if (object.bindlessHandle != 0)
+        {
+          glMakeTextureHandleNonResidentARB(object.bindlessHandle);
+        }
+        textures.push_back(object.id);
+        break;
+      case Type::GRAPHICS_PIPELINE: detail::DestroyGraphicsPipelineInternal(object.id); break;
+      case Type::COMPUTE_PIPELINE: detail::DestroyComputePipelineInternal(object.id); break;
+      }
+      queue.pop_front();
+    }
+
+    if (!buffers.empty())
+    {
+      glDeleteBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+    }
+
+    if (!textures.empty())
+    {
+      detail::context->fboCache.RemoveTextures(textures);
+      glDeleteTextures(static_cast<GLsizei>(textures.size()), textures.data());
+    }
+  }
+
   static void QueryGlDeviceProperties(Fwog::DeviceProperties& properties)
   {
     properties.vendor = reinterpret_cast<const char*>(glGetString(GL_VENDOR));
@@ -101,6 +159,7 @@ namespace Fwog
 
     glGetIntegerv(GL_MAX_COMBINED_SHADER_OUTPUT_RESOURCES, &limits.maxCombinedShaderOutputResources);
     glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &limits.maxCombinedTextureImageUnits);
+    glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &limits.maxTextureImageUnits);
 
     glGetIntegerv(GL_MAX_COMPUTE_SHARED_MEMORY_SIZE, &limits.maxComputeSharedMemorySize);
     glGetIntegerv(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS, &limits.maxComputeWorkGroupInvocations);
@@ -129,6 +188,14 @@ namespace Fwog
       {
         features.bindlessTextures = true;
       }
+      else if (extensionString == "GL_NVX_gpu_memory_info")
+      {
+        features.nvxGpuMemoryInfo = true;
+      }
+      else if (extensionString == "GL_ATI_meminfo")
+      {
+        features.atiMeminfo = true;
+      }
     }
   }
 
@@ -144,10 +211,36 @@ namespace Fwog
   void Terminate()
   {
     FWOG_ASSERT(Fwog::detail::context && "Fwog has already been terminated");
+
+    // Release pooled buffers first, as their deletion may be deferred
+    Fwog::detail::context->readbackBufferPool.clear();
+    Fwog::detail::context->stagingBufferPool.clear();
+    Fwog::detail::context->inFlightStagingBuffers.clear();
+
+    DestroyDeferredObjects(UINT64_MAX);
     delete Fwog::detail::context;
     Fwog::detail::context = nullptr;
   }
 
+  void SetDeferredDestructionEnabled(bool enabled)
+  {
+    Fwog::detail::context->isDeferredDestructionEnabled = enabled;
+  }
+
+  void ProcessDeferredDestruction()
+  {
+    auto* context = Fwog::detail::context;
+    auto& queue = context->deferredDestructions;
+
+    // Objects that were destroyed since the last call are protected by a new timeline value
+    if (!queue.empty() && queue.back().timelineValue > context->destructionTimeline.GetSignaledValue())
+    {
+      context->destructionTimeline.Signal();
+    }
+
+    DestroyDeferredObjects(context->destructionTimeline.GetCompletedValue());
+  }
+
   void InvalidatePipelineState()
   {
     auto* context = Fwog::detail::context;
@@ -1,4 +1,5 @@
 #include <Fwog/Fence.h>
+#include <chrono>
 #include <numeric>
 #include <utility>
 #include <new>
@@ -32,19 +33,36 @@ namespace Fwog
   uint64_t Fence::Wait()
   {
     FWOG_ASSERT(sync_ != nullptr);
-    GLuint id;
-    glGenQueries(1, &id);
-    glBeginQuery(GL_TIME_ELAPSED, id);
+    // Measured on the CPU, since a GPU timer query would add a query object and a pipeline stall to every wait
+    const auto start = std::chrono::steady_clock::now();
     GLenum result = glClientWaitSync(reinterpret_cast<GLsync>(sync_),
                                      GL_SYNC_FLUSH_COMMANDS_BIT,
                                      std::numeric_limits<GLuint64>::max());
-    FWOG_ASSERT(result == GL_CONDITION_SATISFIED);
-    glEndQuery(GL_TIME_ELAPSED);
-    uint64_t elapsed;
-    glGetQueryObjectui64v(id, GL_QUERY_RESULT, &elapsed);
-    glDeleteQueries(1, &id);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    FWOG_ASSERT(result == GL_CONDITION_SATISFIED || result == GL_ALREADY_SIGNALED);
     DeleteSync();
-    return elapsed;
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+  }
+
+  bool Fence::TryWait(uint64_t timeoutNanoseconds)
+  {
+    FWOG_ASSERT(sync_ != nullptr);
+    GLenum result = glClientWaitSync(reinterpret_cast<GLsync>(sync_), GL_SYNC_FLUSH_COMMANDS_BIT, timeoutNanoseconds);
+    FWOG_ASSERT(result != GL_WAIT_FAILED);
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+      return false;
+    }
+    DeleteSync();
+    return true;
+  }
+
+  bool Fence::IsSignaled()
+  {
+    FWOG_ASSERT(sync_ != nullptr);
+    GLenum result = glClientWaitSync(reinterpret_cast<GLsync>(sync_), GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    FWOG_ASSERT(result != GL_WAIT_FAILED);
+    return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
   }
 
   void Fence::DeleteSync()
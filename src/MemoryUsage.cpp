@@ -0,0 +1,61 @@
+#include <Fwog/MemoryUsage.h>
+#include <Fwog/detail/ContextState.h>
+
+#include FWOG_OPENGL_HEADER
+
+namespace Fwog
+{
+  namespace
+  {
+    // The loader doesn't define the tokens of these extensions
+    constexpr GLenum GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX = 0x9047;
+    constexpr GLenum GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX = 0x9049;
+    constexpr GLenum GPU_MEMORY_INFO_EVICTION_COUNT_NVX = 0x904A;
+    constexpr GLenum GPU_MEMORY_INFO_EVICTED_MEMORY_NVX = 0x904B;
+    constexpr GLenum TEXTURE_FREE_MEMORY_ATI = 0x87FC;
+
+    // Both extensions report sizes in KiB
+    uint64_t KibToBytes(GLint kib)
+    {
+      return static_cast<uint64_t>(kib) * 1024;
+    }
+  } // namespace
+
+  MemoryUsage GetMemoryUsage()
+  {
+    return detail::context->resourceRegistry.GetUsage();
+  }
+
+  std::optional<DeviceMemoryInfo> QueryDeviceMemoryInfo()
+  {
+    const auto& features = detail::context->properties.features;
+
+    if (features.nvxGpuMemoryInfo)
+    {
+      GLint dedicated{};
+      GLint available{};
+      GLint evictionCount{};
+      GLint evicted{};
+      glGetIntegerv(GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &dedicated);
+      glGetIntegerv(GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available);
+      glGetIntegerv(GPU_MEMORY_INFO_EVICTION_COUNT_NVX, &evictionCount);
+      glGetIntegerv(GPU_MEMORY_INFO_EVICTED_MEMORY_NVX, &evicted);
+      return DeviceMemoryInfo{
+        .availableBytes = KibToBytes(available),
+        .dedicatedBytes = KibToBytes(dedicated),
+        .evictedBytes = KibToBytes(evicted),
+        .evictionCount = static_cast<uint32_t>(evictionCount),
+      };
+    }
+
+    if (features.atiMeminfo)
+    {
+      // Total free memory, largest free block, total free auxiliary memory, and largest free auxiliary block
+      GLint textureMemory[4]{};
+      glGetIntegerv(TEXTURE_FREE_MEMORY_ATI, textureMemory);
+      return DeviceMemoryInfo{.availableBytes = KibToBytes(textureMemory[0])};
+    }
+
+    return std::nullopt;
+  }
+} // namespace Fwog
@@ -0,0 +1,621 @@
+#include <Fwog/Context.h>
+#include <Fwog/MipmapGenerator.h>
+#include <Fwog/Rendering.h>
+#include <Fwog/Shader.h>
+#include <Fwog/Texture.h>
+#include <Fwog/detail/ApiToEnum.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+#include <string>
+#include <string_view>
+
+#include FWOG_OPENGL_HEADER
+
+namespace Fwog
+{
+  namespace
+  {
+    // Each workgroup of the reduction reduces a tile of this many texels into the next LEVELS_PER_TILE levels
+    constexpr uint32_t TILE_SIZE = 64;
+    constexpr uint32_t LEVELS_PER_TILE = 6;
+
+    // The last workgroup only reduces one tile of level 6, so a chain can be generated in a single pass if it has at
+    // most this many levels and level 6 fits in a tile. Level 6 of a 4096x4096 chain is 64x64
+    constexpr uint32_t MAX_SINGLE_PASS_LEVELS = 2 * LEVELS_PER_TILE + 1;
+
+    // A chain can't have more levels than this, so it never needs more passes than this
+    constexpr uint32_t MAX_PASSES = (32 + LEVELS_PER_TILE - 2) / LEVELS_PER_TILE;
+
+    constexpr uint32_t KAISER_WORKGROUP_SIZE = 8;
+
+    struct ReduceUniforms
+    {
+      uint32_t levelCount;
+      uint32_t workgroupCount;
+    };
+
+    enum class ValueKind
+    {
+      FLOAT,
+      UINT,
+      SINT,
+    };
+
+    struct StorageFormatInfo
+    {
+      Format storageFormat;
+      std::string_view layoutQualifier;
+      ValueKind kind;
+      bool isSrgb;
+    };
+
+    // Shared by every pipeline. Defines injected before it:
+    // FORMAT: the image format layout qualifier
+    // VALUE_KIND: 0 for float, 1 for unsigned integer, and 2 for signed integer formats
+    // SRGB: 1 if RGB is stored with the sRGB transfer function
+    constexpr std::string_view commonSource = R"(
+#if VALUE_KIND == 1
+  #define Value uvec4
+  #define IMAGE uimage2DArray
+#elif VALUE_KIND == 2
+  #define Value ivec4
+  #define IMAGE iimage2DArray
+#else
+  #define Value vec4
+  #define IMAGE image2DArray
+#endif
+
+#if SRGB
+vec3 SrgbToLinear(vec3 c)
+{
+  return mix(c / 12.92, pow((c + 0.055) / 1.055, vec3(2.4)), greaterThan(c, vec3(0.04045)));
+}
+
+vec3 LinearToSrgb(vec3 c)
+{
+  return mix(c * 12.92, 1.055 * pow(c, vec3(1.0 / 2.4)) - 0.055, greaterThan(c, vec3(0.0031308)));
+}
+#endif
+
+Value Decode(Value texel)
+{
+#if SRGB
+  texel.rgb = SrgbToLinear(texel.rgb);
+#endif
+  return texel;
+}
+
+Value Encode(Value value)
+{
+#if SRGB
+  value.rgb = LinearToSrgb(clamp(value.rgb, 0.0, 1.0));
+#endif
+  return value;
+}
+)";
+
+    // Reduces up to 13 levels in the style of AMD's single pass downsampler (SPD). Each workgroup reduces a 64x64 tile
+    // of the source level into the six levels after it, keeping intermediate results in shared memory. In single pass
+    // mode, the last workgroup of each layer to finish then reduces level 6 into the remaining levels.
+    // Defines injected before it:
+    // FILTER_BOX, FILTER_MIN, or FILTER_MAX
+    // SINGLE_PASS: 1 if 13 levels can be bound at once, 0 otherwise
+    constexpr std::string_view reduceSource = R"(
+layout(local_size_x = 256) in;
+
+#if SINGLE_PASS
+  #define IMAGE_COUNT 13
+#else
+  #define IMAGE_COUNT 7
+#endif
+
+// i_levels[0] is the source level of the dispatch, and the rest are the levels after it
+layout(binding = 0, FORMAT) uniform coherent IMAGE i_levels[IMAGE_COUNT];
+
+layout(binding = 0, std140) uniform Uniforms
+{
+  uint levelCount;     // The number of bound levels, including the source level
+  uint workgroupCount; // The number of workgroups per layer
+}uniforms;
+
+// One counter per layer
+layout(binding = 0, std430) coherent buffer Counters
+{
+  uint finishedWorkgroups[];
+};
+
+shared Value s_values[16][16];
+shared bool s_isLastWorkgroup;
+
+Value Reduce4(Value a, Value b, Value c, Value d)
+{
+#if defined(FILTER_MIN)
+  return min(min(a, b), min(c, d));
+#elif defined(FILTER_MAX)
+  return max(max(a, b), max(c, d));
+#elif VALUE_KIND == 0
+  return (a + b + c + d) * 0.25;
+#else
+  // The sum could overflow, so the quotient and remainder of each term are summed separately
+  Value mask = Value(3);
+  return (a >> 2) + (b >> 2) + (c >> 2) + (d >> 2) + (((a & mask) + (b & mask) + (c & mask) + (d & mask)) >> 2);
+#endif
+}
+
+void Store(uint level, ivec2 coord, Value value)
+{
+  if (level < uniforms.levelCount && all(lessThan(coord, imageSize(i_levels[level]).xy)))
+  {
+    imageStore(i_levels[level], ivec3(coord, gl_WorkGroupID.z), Encode(value));
+  }
+}
+
+Value Load(uint level, ivec2 coord)
+{
+  // Tiles may extend past the edge of the level
+  coord = min(coord, imageSize(i_levels[level]).xy - 1);
+  return Decode(imageLoad(i_levels[level], ivec3(coord, gl_WorkGroupID.z)));
+}
+
+// Reduces a 64x64 tile of srcLevel into the six levels after it
+void ReduceTile(uint srcLevel, ivec2 tile)
+{
+  uint index = gl_LocalInvocationIndex;
+  ivec2 thread = ivec2(index % 16, index / 16);
+
+  // Each invocation reduces a 4x4 block of the source into 2x2 texels of the first level, then one texel of the second
+  Value quad[4];
+  for (int i = 0; i < 4; i++)
+  {
+    ivec2 offset = ivec2(i % 2, i / 2);
+    ivec2 src = tile * 64 + thread * 4 + offset * 2;
+    quad[i] = Reduce4(Load(srcLevel, src),
+                      Load(srcLevel, src + ivec2(1, 0)),
+                      Load(srcLevel, src + ivec2(0, 1)),
+                      Load(srcLevel, src + ivec2(1, 1)));
+    Store(srcLevel + 1, tile * 32 + thread * 2 + offset, quad[i]);
+  }
+
+  Value value = Reduce4(quad[0], quad[1], quad[2], quad[3]);
+  Store(srcLevel + 2, tile * 16 + thread, value);
+  s_values[thread.y][thread.x] = value;
+
+  // The remaining levels (8x8 to 1x1 texels per tile) are reduced in shared memory
+  for (uint level = 3, size = 8; level <= 6; level++, size /= 2)
+  {
+    barrier();
+
+    ivec2 coord = ivec2(index % size, index / size);
+    bool isActive = index < size * size;
+    if (isActive)
+    {
+      ivec2 src = coord * 2;
+      value = Reduce4(s_values[src.y][src.x],
+                      s_values[src.y][src.x + 1],
+                      s_values[src.y + 1][src.x],
+                      s_values[src.y + 1][src.x + 1]);
+      Store(srcLevel + level, tile * int(size) + coord, value);
+    }
+
+    barrier();
+
+    if (isActive)
+    {
+      s_values[coord.y][coord.x] = value;
+    }
+  }
+}
+
+void main()
+{
+  ReduceTile(0, ivec2(gl_WorkGroupID.xy));
+
+#if SINGLE_PASS
+  if (uniforms.levelCount <= 7)
+  {
+    return;
+  }
+
+  // Make this workgroup's writes to level 6 visible before announcing that it has finished
+  memoryBarrierImage();
+  barrier();
+
+  if (gl_LocalInvocationIndex == 0)
+  {
+    s_isLastWorkgroup = atomicAdd(finishedWorkgroups[gl_WorkGroupID.z], 1) == uniforms.workgroupCount - 1;
+  }
+
+  barrier();
+
+  if (!s_isLastWorkgroup)
+  {
+    return;
+  }
+
+  // Every other workgroup of this layer has finished, so the counter can be reset for the next call
+  if (gl_LocalInvocationIndex == 0)
+  {
+    finishedWorkgroups[gl_WorkGroupID.z] = 0;
+  }
+
+  ReduceTile(6, ivec2(0));
+#endif
+}
+)";
+
+    // Filters one level with a separable 6x6 Kaiser-windowed sinc. Each destination texel is centered between the middle
+    // two taps of its footprint. Defines injected before it:
+    // KAISER_WEIGHTS: a float[6] initializer that sums to one
+    constexpr std::string_view kaiserSource = R"(
+layout(local_size_x = KAISER_WORKGROUP_SIZE, local_size_y = KAISER_WORKGROUP_SIZE) in;
+
+layout(binding = 0, FORMAT) uniform readonly IMAGE i_source;
+layout(binding = 1, FORMAT) uniform writeonly IMAGE i_destination;
+
+const float weights[6] = KAISER_WEIGHTS;
+
+void main()
+{
+  ivec2 coord = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(coord, imageSize(i_destination).xy)))
+  {
+    return;
+  }
+
+  int layer = int(gl_GlobalInvocationID.z);
+  ivec2 sourceMax = imageSize(i_source).xy - 1;
+
+  float infinity = uintBitsToFloat(0x7F800000u);
+  Value sum = Value(0);
+  Value lo = Value(infinity);
+  Value hi = Value(-infinity);
+  for (int y = 0; y < 6; y++)
+  {
+    for (int x = 0; x < 6; x++)
+    {
+      ivec2 src = clamp(coord * 2 - 2 + ivec2(x, y), ivec2(0), sourceMax);
+      Value texel = Decode(imageLoad(i_source, ivec3(src, layer)));
+      sum += weights[x] * weights[y] * texel;
+      lo = min(lo, texel);
+      hi = max(hi, texel);
+    }
+  }
+
+  // The negative lobes of the filter would otherwise ring around edges
+  imageStore(i_destination, ivec3(coord, layer), Encode(clamp(sum, lo, hi)));
+}
+)";
+
+    const StorageFormatInfo* GetStorageFormatInfo(Format format)
+    {
+      // Formats that can be used for image load/store, and R8G8B8A8_SRGB, which is accessed through a UNORM view
+      static constexpr StorageFormatInfo formats[] = {
+        {Format::R8_UNORM, "r8", ValueKind::FLOAT, false},
+        {Format::R8_SNORM, "r8_snorm", ValueKind::FLOAT, false},
+        {Format::R16_UNORM, "r16", ValueKind::FLOAT, false},
+        {Format::R16_SNORM, "r16_snorm", ValueKind::FLOAT, false},
+        {Format::R8G8_UNORM, "rg8", ValueKind::FLOAT, false},
+        {Format::R8G8_SNORM, "rg8_snorm", ValueKind::FLOAT, false},
+        {Format::R16G16_UNORM, "rg16", ValueKind::FLOAT, false},
+        {Format::R16G16_SNORM, "rg16_snorm", ValueKind::FLOAT, false},
+        {Format::R8G8B8A8_UNORM, "rgba8", ValueKind::FLOAT, false},
+        {Format::R8G8B8A8_SNORM, "rgba8_snorm", ValueKind::FLOAT, false},
+        {Format::R10G10B10A2_UNORM, "rgb10_a2", ValueKind::FLOAT, false},
+        {Format::R16G16B16A16_UNORM, "rgba16", ValueKind::FLOAT, false},
+        {Format::R16G16B16A16_SNORM, "rgba16_snorm", ValueKind::FLOAT, false},
+        {Format::R16_FLOAT, "r16f", ValueKind::FLOAT, false},
+        {Format::R16G16_FLOAT, "rg16f", ValueKind::FLOAT, false},
+        {Format::R16G16B16A16_FLOAT, "rgba16f", ValueKind::FLOAT, false},
+        {Format::R32_FLOAT, "r32f", ValueKind::FLOAT, false},
+        {Format::R32G32_FLOAT, "rg32f", ValueKind::FLOAT, false},
+        {Format::R32G32B32A32_FLOAT, "rgba32f", ValueKind::FLOAT, false},
+        {Format::R11G11B10_FLOAT, "r11f_g11f_b10f", ValueKind::FLOAT, false},
+        {Format::R10G10B10A2_UINT, "rgb10_a2ui", ValueKind::UINT, false},
+        {Format::R8_UINT, "r8ui", ValueKind::UINT, false},
+        {Format::R16_UINT, "r16ui", ValueKind::UINT, false},
+        {Format::R32_UINT, "r32ui", ValueKind::UINT, false},
+        {Format::R8G8_UINT, "rg8ui", ValueKind::UINT, false},
+        {Format::R16G16_UINT, "rg16ui", ValueKind::UINT, false},
+        {Format::R32G32_UINT, "rg32ui", ValueKind::UINT, false},
+        {Format::R8G8B8A8_UINT, "rgba8ui", ValueKind::UINT, false},
+        {Format::R16G16B16A16_UINT, "rgba16ui", ValueKind::UINT, false},
+        {Format::R32G32B32A32_UINT, "rgba32ui", ValueKind::UINT, false},
+        {Format::R8_SINT, "r8i", ValueKind::SINT, false},
+        {Format::R16_SINT, "r16i", ValueKind::SINT, false},
+        {Format::R32_SINT, "r32i", ValueKind::SINT, false},
+        {Format::R8G8_SINT, "rg8i", ValueKind::SINT, false},
+        {Format::R16G16_SINT, "rg16i", ValueKind::SINT, false},
+        {Format::R32G32_SINT, "rg32i", ValueKind::SINT, false},
+        {Format::R8G8B8A8_SINT, "rgba8i", ValueKind::SINT, false},
+        {Format::R16G16B16A16_SINT, "rgba16i", ValueKind::SINT, false},
+        {Format::R32G32B32A32_SINT, "rgba32i", ValueKind::SINT, false},
+      };
+
+      // sRGB formats can't be used for image load/store, so they are decoded and encoded in the shader
+      static constexpr StorageFormatInfo srgbFormat = {Format::R8G8B8A8_UNORM, "rgba8", ValueKind::FLOAT, true};
+      if (format == Format::R8G8B8A8_SRGB)
+      {
+        return &srgbFormat;
+      }
+
+      const auto* it = std::ranges::find(formats, format, &StorageFormatInfo::storageFormat);
+      return it != std::end(formats) ? it : nullptr;
+    }
+
+    // The zeroth-order modified Bessel function of the first kind
+    double BesselI0(double x)
+    {
+      double sum = 1;
+      double term = 1;
+      for (int k = 1; k < 32; k++)
+      {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+      }
+      return sum;
+    }
+
+    // Weights of a Lanczos-like filter for 2x downsampling: sinc(d / 2) windowed by a Kaiser window with a radius of
+    // three source texels
+    std::array<float, 6> ComputeKaiserWeights()
+    {
+      constexpr double radius = 3;
+      constexpr double alpha = 4;
+
+      std::array<double, 6> weights{};
+      double total = 0;
+      for (int i = 0; i < 6; i++)
+      {
+        // Distance from the center of the destination texel in source texels
+        const double d = i - 2.5;
+        const double x = std::numbers::pi * d / 2;
+        const double sinc = x == 0 ? 1 : std::sin(x) / x;
+        const double r = d / radius;
+        const double window = BesselI0(alpha * std::sqrt(std::max(0.0, 1 - r * r))) / BesselI0(alpha);
+        weights[i] = sinc * window;
+        total += weights[i];
+      }
+
+      std::array<float, 6> normalized{};
+      for (int i = 0; i < 6; i++)
+      {
+        normalized[i] = static_cast<float>(weights[i] / total);
+      }
+      return normalized;
+    }
+
+    std::string GetKaiserWeightsDefine()
+    {
+      std::string define = "#define KAISER_WEIGHTS float[6](";
+      for (auto weight : ComputeKaiserWeights())
+      {
+        if (define.back() != '(')
+        {
+          define += ", ";
+        }
+        define += std::to_string(weight);
+      }
+      return define + ")\n";
+    }
+
+    uint32_t GetLayerCount(const TextureCreateInfo& createInfo)
+    {
+      switch (createInfo.imageType)
+      {
+      case ImageType::TEX_2D: return 1;
+      case ImageType::TEX_2D_ARRAY: return createInfo.arrayLayers;
+      case ImageType::TEX_CUBEMAP: return 6;
+      case ImageType::TEX_CUBEMAP_ARRAY: return createInfo.arrayLayers;
+      default: FWOG_UNREACHABLE; return 0;
+      }
+    }
+
+    uint64_t GetUniformStride(size_t size)
+    {
+      const auto alignment = static_cast<uint64_t>(GetDeviceProperties().limits.uniformBufferOffsetAlignment);
+      return (size + alignment - 1) / alignment * alignment;
+    }
+
+    bool SupportsSinglePass()
+    {
+      const auto& limits = GetDeviceProperties().limits;
+      const auto required = static_cast<int32_t>(MAX_SINGLE_PASS_LEVELS);
+      return limits.maxImageUnits >= required && limits.maxCombinedImageUniforms >= required;
+    }
+  } // namespace
+
+  MipmapGenerator::MipmapGenerator()
+    : supportsSinglePass_(SupportsSinglePass()),
+      uniformBuffer_(GetUniformStride(sizeof(ReduceUniforms)) * MAX_PASSES, BufferStorageFlag::DYNAMIC_STORAGE)
+  {
+  }
+
+  const ComputePipeline& MipmapGenerator::GetPipeline(Format storageFormat, MipmapFilter filter, bool srgb, bool singlePass)
+  {
+    for (const auto& entry : pipelines_)
+    {
+      if (entry.storageFormat == storageFormat && entry.filter == filter && entry.srgb == srgb &&
+          entry.singlePass == singlePass)
+      {
+        return entry.pipeline;
+      }
+    }
+
+    const auto* formatInfo = GetStorageFormatInfo(storageFormat);
+    FWOG_ASSERT(formatInfo);
+
+    auto source = std::string("#version 460 core\n");
+    source += "#define FORMAT " + std::string(formatInfo->layoutQualifier) + "\n";
+    source += "#define VALUE_KIND " + std::to_string(static_cast<int>(formatInfo->kind)) + "\n";
+    source += srgb ? "#define SRGB 1\n" : "#define SRGB 0\n";
+    source += commonSource;
+
+    switch (filter)
+    {
+    case MipmapFilter::BOX: source += "#define FILTER_BOX\n"; break;
+    case MipmapFilter::MIN: source += "#define FILTER_MIN\n"; break;
+    case MipmapFilter::MAX: source += "#define FILTER_MAX\n"; break;
+    case MipmapFilter::KAISER:
+      source += "#define KAISER_WORKGROUP_SIZE " + std::to_string(KAISER_WORKGROUP_SIZE) + "\n";
+      source += GetKaiserWeightsDefine();
+      break;
+    }
+
+    if (filter == MipmapFilter::KAISER)
+    {
+      source += kaiserSource;
+    }
+    else
+    {
+      source += singlePass ? "#define SINGLE_PASS 1\n" : "#define SINGLE_PASS 0\n";
+      source += reduceSource;
+    }
+
+    auto shader = Shader(PipelineStage::COMPUTE_SHADER, source);
+    auto pipeline = ComputePipeline({.name = "Generate mipmaps", .shader = &shader});
+    pipelines_.push_back({storageFormat, filter, srgb, singlePass, std::move(pipeline)});
+    return pipelines_.back().pipeline;
+  }
+
+  void MipmapGenerator::Generate(Texture& texture, const MipmapGenerateInfo& info)
+  {
+    const auto& createInfo = texture.GetCreateInfo();
+    FWOG_ASSERT(info.baseLevel < createInfo.mipLevels);
+
+    const auto* formatInfo = GetStorageFormatInfo(createInfo.format);
+    FWOG_ASSERT(formatInfo && "The format must be usable with image load/store, or be R8G8B8A8_SRGB");
+
+    const bool srgb = info.srgb || formatInfo->isSrgb;
+    FWOG_ASSERT(!(srgb && formatInfo->kind != ValueKind::FLOAT) && "Integer formats can't be sRGB");
+    FWOG_ASSERT(!(info.filter == MipmapFilter::KAISER && formatInfo->kind != ValueKind::FLOAT) &&
+                "Integer formats can't be filtered with KAISER");
+
+    const uint32_t levelCount = createInfo.mipLevels - info.baseLevel;
+    if (levelCount < 2)
+    {
+      return;
+    }
+
+    // Every supported image type can be viewed as a 2D array, so the shaders only handle that. Levels of the view are
+    // bound directly, as the format of the view can differ from that of the texture. The view is cached, so generating
+    // mipmaps for the same texture again doesn't create another GL object
+    const uint32_t layerCount = GetLayerCount(createInfo);
+    auto view = texture.CreateCachedView({
+      .viewType = ImageType::TEX_2D_ARRAY,
+      .format = formatInfo->storageFormat,
+      .minLevel = 0,
+      .numLevels = createInfo.mipLevels,
+      .minLayer = 0,
+      .numLayers = layerCount,
+    });
+    const auto glFormat = detail::FormatToGL(formatInfo->storageFormat);
+    auto bindLevel = [&](uint32_t unit, uint32_t level)
+    { glBindImageTexture(unit, view.Handle(), level, GL_TRUE, 0, GL_READ_WRITE, glFormat); };
+
+    auto levelExtent = [&](uint32_t level)
+    {
+      return Extent2D{
+        std::max(createInfo.extent.width >> level, 1u),
+        std::max(createInfo.extent.height >> level, 1u),
+      };
+    };
+
+    if (info.filter == MipmapFilter::KAISER)
+    {
+      BeginCompute("Generate mipmaps");
+      Cmd::BindComputePipeline(GetPipeline(formatInfo->storageFormat, info.filter, srgb, false));
+      for (uint32_t level = info.baseLevel + 1; level < createInfo.mipLevels; level++)
+      {
+        if (level > info.baseLevel + 1)
+        {
+          MemoryBarrier(MemoryBarrierBit::IMAGE_ACCESS_BIT);
+        }
+
+        bindLevel(0, level - 1);
+        bindLevel(1, level);
+        const auto extent = levelExtent(level);
+        Cmd::Dispatch((extent.width + KAISER_WORKGROUP_SIZE - 1) / KAISER_WORKGROUP_SIZE,
+                      (extent.height + KAISER_WORKGROUP_SIZE - 1) / KAISER_WORKGROUP_SIZE,
+                      layerCount);
+      }
+      EndCompute();
+      return;
+    }
+
+    struct Pass
+    {
+      uint32_t baseLevel;
+      uint32_t levelCount;
+      Extent2D workgroups;
+    };
+
+    auto workgroupsForLevel = [&](uint32_t level)
+    {
+      const auto extent = levelExtent(level);
+      return Extent2D{(extent.width + TILE_SIZE - 1) / TILE_SIZE, (extent.height + TILE_SIZE - 1) / TILE_SIZE};
+    };
+
+    const bool isSinglePass = supportsSinglePass_ && levelCount > LEVELS_PER_TILE + 1 &&
+                              levelCount <= MAX_SINGLE_PASS_LEVELS &&
+                              workgroupsForLevel(info.baseLevel + LEVELS_PER_TILE) == Extent2D{1, 1};
+
+    std::array<Pass, MAX_PASSES> passes{};
+    uint32_t passCount = 0;
+    if (isSinglePass)
+    {
+      passes[passCount++] = {info.baseLevel, levelCount, workgroupsForLevel(info.baseLevel)};
+    }
+    else
+    {
+      // Each dispatch reads the last level written by the previous one
+      for (uint32_t level = info.baseLevel; level + 1 < createInfo.mipLevels; level += LEVELS_PER_TILE)
+      {
+        const auto count = std::min(LEVELS_PER_TILE + 1, createInfo.mipLevels - level);
+        passes[passCount++] = {level, count, workgroupsForLevel(level)};
+      }
+    }
+
+    const auto uniformStride = GetUniformStride(sizeof(ReduceUniforms));
+    for (uint32_t i = 0; i < passCount; i++)
+    {
+      const auto& pass = passes[i];
+      uniformBuffer_.UpdateData(
+        ReduceUniforms{
+          .levelCount = pass.levelCount,
+          .workgroupCount = pass.workgroups.width * pass.workgroups.height,
+        },
+        i * uniformStride);
+    }
+
+    // The shader resets each counter after using it, so they only need to be cleared when they are created
+    const auto counterSize = sizeof(uint32_t) * static_cast<size_t>(layerCount);
+    if (!counterBuffer_ || counterBuffer_->Size() < counterSize)
+    {
+      counterBuffer_.emplace(counterSize);
+      counterBuffer_->ClearSubData({.offset = 0, .size = counterSize, .internalFormat = Format::R32_UINT});
+    }
+
+    BeginCompute("Generate mipmaps");
+    Cmd::BindComputePipeline(GetPipeline(formatInfo->storageFormat, info.filter, srgb, isSinglePass));
+    Cmd::BindStorageBuffer(0, *counterBuffer_);
+    for (uint32_t i = 0; i < passCount; i++)
+    {
+      const auto& pass = passes[i];
+      if (i > 0)
+      {
+        MemoryBarrier(MemoryBarrierBit::IMAGE_ACCESS_BIT);
+      }
+
+      Cmd::BindUniformBuffer(0, uniformBuffer_, i * uniformStride, sizeof(ReduceUniforms));
+      for (uint32_t level = 0; level < pass.levelCount; level++)
+      {
+        bindLevel(level, pass.baseLevel + level);
+      }
+      Cmd::Dispatch(pass.workgroups.width, pass.workgroups.height, layerCount);
+    }
+    EndCompute();
+  }
+} // namespace Fwog
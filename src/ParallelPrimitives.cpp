@@ -0,0 +1,602 @@
+#include <Fwog/Context.h>
+#include <Fwog/ParallelPrimitives.h>
+#include <Fwog/Readback.h>
+#include <Fwog/Rendering.h>
+#include <Fwog/Shader.h>
+
+#include <algorithm>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+
+namespace Fwog
+{
+  namespace
+  {
+    constexpr uint32_t RADIX_BITS = 8;
+    constexpr uint32_t RADIX = 1 << RADIX_BITS;
+
+    struct ScanUniforms
+    {
+      uint32_t count;
+    };
+
+    struct CompactUniforms
+    {
+      uint32_t count;
+      uint32_t writeIndices;
+      uint32_t dispatchGroupSize;
+    };
+
+    struct RadixSortUniforms
+    {
+      uint32_t count;
+      uint32_t shift;
+      uint32_t tileCount;
+    };
+
+    // Shared by the prefix sum and stream compaction kernels. When COMPACT is nonzero, the input is a list of flags
+    // that are scanned as zero or one, and the scan is used to scatter the selected elements instead of being written
+    constexpr std::string_view scanSource = R"(
+layout(local_size_x = WORKGROUP_SIZE) in;
+
+#if COMPACT
+layout(binding = 0, std140) uniform Uniforms
+{
+  uint count;
+  uint writeIndices;
+  uint dispatchGroupSize;
+}uniforms;
+#else
+layout(binding = 0, std140) uniform Uniforms
+{
+  uint count;
+}uniforms;
+#endif
+
+layout(binding = 0, std430) readonly buffer InputBuffer
+{
+  uint inputValues[];
+};
+
+layout(binding = 1, std430) writeonly buffer OutputBuffer
+{
+  uint outputValues[];
+};
+
+// Tile indices are handed out in the order that workgroups start, so every predecessor of a tile is already running
+// when the tile looks back at it. overflow is set if a prefix doesn't fit in the value bits of a status
+layout(binding = 2, std430) coherent buffer StateBuffer
+{
+  uint tileCounter;
+  uint overflow;
+  uint tileStatus[];
+};
+
+#if COMPACT
+layout(binding = 3, std430) readonly buffer ValuesBuffer
+{
+  uint values[];
+};
+
+layout(binding = 4, std430) writeonly buffer ResultBuffer
+{
+  uint groupCountX;
+  uint groupCountY;
+  uint groupCountZ;
+  uint compactedCount;
+};
+#endif
+
+// A tile's status is zero until it publishes one of these flags, along with a value in the lower 30 bits
+#define STATUS_AGGREGATE 0x40000000u // The sum of the tile
+#define STATUS_PREFIX 0x80000000u    // The sum of the tile and all preceding tiles
+#define STATUS_VALUE_MASK 0x3FFFFFFFu
+
+shared uint s_scan[WORKGROUP_SIZE];
+shared uint s_tileIndex;
+shared uint s_tilePrefix;
+
+// Returns the sum of value over the preceding invocations in the workgroup, and the sum over all of them in total
+uint WorkgroupExclusiveScan(uint value, out uint total)
+{
+  uint index = gl_LocalInvocationIndex;
+  s_scan[index] = value;
+  barrier();
+
+  for (uint offset = 1; offset < WORKGROUP_SIZE; offset *= 2)
+  {
+    uint addend = index >= offset ? s_scan[index - offset] : 0;
+    barrier();
+    s_scan[index] += addend;
+    barrier();
+  }
+
+  total = s_scan[WORKGROUP_SIZE - 1];
+  return s_scan[index] - value;
+}
+
+void main()
+{
+  if (gl_LocalInvocationIndex == 0)
+  {
+    s_tileIndex = atomicAdd(tileCounter, 1);
+  }
+
+  barrier();
+
+  uint tileIndex = s_tileIndex;
+  uint first = tileIndex * TILE_SIZE + gl_LocalInvocationIndex * ITEMS_PER_INVOCATION;
+
+  uint items[ITEMS_PER_INVOCATION];
+  uint invocationSum = 0;
+  for (uint i = 0; i < ITEMS_PER_INVOCATION; i++)
+  {
+    uint index = first + i;
+    uint item = index < uniforms.count ? inputValues[index] : 0;
+#if COMPACT
+    item = item != 0 ? 1 : 0;
+#endif
+    items[i] = item;
+    invocationSum += item;
+  }
+
+  uint tileSum;
+  uint invocationPrefix = WorkgroupExclusiveScan(invocationSum, tileSum);
+
+  if (gl_LocalInvocationIndex == 0)
+  {
+    if (tileSum > STATUS_VALUE_MASK)
+    {
+      atomicOr(overflow, 1);
+    }
+
+    uint tilePrefix = 0;
+    if (tileIndex == 0)
+    {
+      atomicExchange(tileStatus[0], STATUS_PREFIX | tileSum);
+    }
+    else
+    {
+      atomicExchange(tileStatus[tileIndex], STATUS_AGGREGATE | tileSum);
+
+      // Accumulate the sums of preceding tiles until one with an inclusive prefix is found
+      uint predecessor = tileIndex - 1;
+      while (true)
+      {
+        uint status = atomicOr(tileStatus[predecessor], 0);
+        if ((status & ~STATUS_VALUE_MASK) == 0)
+        {
+          continue;
+        }
+
+        tilePrefix += status & STATUS_VALUE_MASK;
+        if ((status & STATUS_PREFIX) != 0)
+        {
+          break;
+        }
+
+        predecessor--;
+      }
+
+      if (tilePrefix + tileSum > STATUS_VALUE_MASK)
+      {
+        atomicOr(overflow, 1);
+      }
+
+      atomicExchange(tileStatus[tileIndex], STATUS_PREFIX | (tilePrefix + tileSum));
+    }
+
+    s_tilePrefix = tilePrefix;
+
+#if COMPACT
+    uint tileCount = max((uniforms.count + TILE_SIZE - 1) / TILE_SIZE, 1);
+    if (tileIndex == tileCount - 1)
+    {
+      uint total = tilePrefix + tileSum;
+      compactedCount = total;
+      groupCountX = (total + uniforms.dispatchGroupSize - 1) / uniforms.dispatchGroupSize;
+      groupCountY = 1;
+      groupCountZ = 1;
+    }
+#endif
+  }
+
+  barrier();
+
+  uint prefix = s_tilePrefix + invocationPrefix;
+  for (uint i = 0; i < ITEMS_PER_INVOCATION; i++)
+  {
+    uint index = first + i;
+    if (index >= uniforms.count)
+    {
+      break;
+    }
+
+#if COMPACT
+    if (items[i] != 0)
+    {
+      outputValues[prefix] = uniforms.writeIndices != 0 ? index : values[index];
+    }
+#else
+    outputValues[index] = prefix;
+#endif
+    prefix += items[i];
+  }
+}
+)";
+
+    // Both radix sort kernels visit a tile's elements in rows of WORKGROUP_SIZE, in the same order
+    constexpr std::string_view radixUniformsSource = R"(
+layout(local_size_x = WORKGROUP_SIZE) in;
+
+layout(binding = 0, std140) uniform Uniforms
+{
+  uint count;
+  uint shift;
+  uint tileCount;
+}uniforms;
+
+uint GetElementIndex(uint row)
+{
+  return gl_WorkGroupID.x * TILE_SIZE + row * WORKGROUP_SIZE + gl_LocalInvocationIndex;
+}
+)";
+
+    constexpr std::string_view radixHistogramSource = R"(
+layout(binding = 0, std430) readonly buffer KeysBuffer
+{
+  uint keys[];
+};
+
+// Stored digit-major, so an exclusive scan yields the offset of each tile's elements with each digit
+layout(binding = 1, std430) writeonly buffer HistogramBuffer
+{
+  uint tileHistograms[];
+};
+
+shared uint s_histogram[RADIX];
+
+void main()
+{
+  for (uint digit = gl_LocalInvocationIndex; digit < RADIX; digit += WORKGROUP_SIZE)
+  {
+    s_histogram[digit] = 0;
+  }
+
+  barrier();
+
+  for (uint row = 0; row < ITEMS_PER_INVOCATION; row++)
+  {
+    uint index = GetElementIndex(row);
+    if (index < uniforms.count)
+    {
+      atomicAdd(s_histogram[(keys[index] >> uniforms.shift) & (RADIX - 1)], 1);
+    }
+  }
+
+  barrier();
+
+  for (uint digit = gl_LocalInvocationIndex; digit < RADIX; digit += WORKGROUP_SIZE)
+  {
+    tileHistograms[digit * uniforms.tileCount + gl_WorkGroupID.x] = s_histogram[digit];
+  }
+}
+)";
+
+    constexpr std::string_view radixScatterSource = R"(
+layout(binding = 0, std430) readonly buffer KeysInBuffer
+{
+  uint keysIn[];
+};
+
+layout(binding = 1, std430) writeonly buffer KeysOutBuffer
+{
+  uint keysOut[];
+};
+
+layout(binding = 2, std430) readonly buffer TileOffsetsBuffer
+{
+  uint tileOffsets[];
+};
+
+layout(binding = 3, std430) readonly buffer ValuesInBuffer
+{
+  uint valuesIn[];
+};
+
+layout(binding = 4, std430) writeonly buffer ValuesOutBuffer
+{
+  uint valuesOut[];
+};
+
+#define INVALID_DIGIT RADIX
+
+// Where the next element of the tile with each digit goes
+shared uint s_offsets[RADIX];
+shared uint s_digits[WORKGROUP_SIZE];
+
+void main()
+{
+  for (uint digit = gl_LocalInvocationIndex; digit < RADIX; digit += WORKGROUP_SIZE)
+  {
+    s_offsets[digit] = tileOffsets[digit * uniforms.tileCount + gl_WorkGroupID.x];
+  }
+
+  for (uint row = 0; row < ITEMS_PER_INVOCATION; row++)
+  {
+    uint index = GetElementIndex(row);
+    bool valid = index < uniforms.count;
+    uint key = valid ? keysIn[index] : 0;
+    uint digit = valid ? (key >> uniforms.shift) & (RADIX - 1) : INVALID_DIGIT;
+
+    s_digits[gl_LocalInvocationIndex] = digit;
+    barrier();
+
+    // Elements with the same digit keep their order within the row, which makes the sort stable
+    uint rank = 0;
+    for (uint i = 0; i < gl_LocalInvocationIndex; i++)
+    {
+      rank += s_digits[i] == digit ? 1 : 0;
+    }
+
+    if (valid)
+    {
+      uint destination = s_offsets[digit] + rank;
+      keysOut[destination] = key;
+      valuesOut[destination] = valuesIn[index];
+    }
+
+    barrier();
+
+    if (valid)
+    {
+      atomicAdd(s_offsets[digit], 1);
+    }
+  }
+}
+)";
+
+    ComputePipeline CreatePipeline(std::string_view name,
+                                   const ParallelPrimitivesInfo& info,
+                                   std::string_view defines,
+                                   std::initializer_list<std::string_view> sources)
+    {
+      FWOG_ASSERT(info.workgroupSize > 0 && (info.workgroupSize & (info.workgroupSize - 1)) == 0 &&
+                  "Workgroup size must be a power of two");
+      FWOG_ASSERT(info.itemsPerInvocation > 0);
+
+      auto source = std::string("#version 460 core\n");
+      source += "#define WORKGROUP_SIZE " + std::to_string(info.workgroupSize) + "\n";
+      source += "#define ITEMS_PER_INVOCATION " + std::to_string(info.itemsPerInvocation) + "\n";
+      source += "#define TILE_SIZE (WORKGROUP_SIZE * ITEMS_PER_INVOCATION)\n";
+      source += "#define RADIX " + std::to_string(RADIX) + "\n";
+      source += defines;
+      for (auto part : sources)
+      {
+        source += part;
+      }
+
+      auto shader = Shader(PipelineStage::COMPUTE_SHADER, source);
+      return ComputePipeline({.name = name, .shader = &shader});
+    }
+
+    uint64_t GetUniformStride(size_t size)
+    {
+      const auto alignment = static_cast<uint64_t>(GetDeviceProperties().limits.uniformBufferOffsetAlignment);
+      return (size + alignment - 1) / alignment * alignment;
+    }
+
+    uint32_t GetTileCount(uint32_t count, uint32_t tileSize)
+    {
+      const auto tileCount = std::max((count + tileSize - 1) / tileSize, 1u);
+      FWOG_ASSERT(tileCount <= static_cast<uint32_t>(GetDeviceProperties().limits.maxComputeWorkGroupCount[0]) &&
+                  "Too many elements for one dispatch");
+      return tileCount;
+    }
+
+    // Reallocates a scratch buffer if it is smaller than size. Old contents are not preserved
+    void EnsureSize(std::optional<Buffer>& buffer, size_t size)
+    {
+      if (!buffer || buffer->Size() < size)
+      {
+        buffer.emplace(size);
+      }
+    }
+
+    // The largest sum that fits in the value bits of a tile's status
+    constexpr uint32_t MAX_SCAN_SUM = (1u << 30) - 1;
+
+    // Resets the tile counter, overflow flag, and statuses used by the single-pass scan
+    void ResetScanState(std::optional<Buffer>& stateBuffer, uint32_t tileCount)
+    {
+      const auto size = sizeof(uint32_t) * (2 + static_cast<size_t>(tileCount));
+      EnsureSize(stateBuffer, size);
+
+      // A previous scan may still be writing to the state
+      MemoryBarrier(MemoryBarrierBit::BUFFER_UPDATE_BIT);
+      stateBuffer->ClearSubData({.offset = 0, .size = size, .internalFormat = Format::R32_UINT});
+    }
+  } // namespace
+
+  PrefixSum::PrefixSum(const ParallelPrimitivesInfo& info)
+    : tileSize_(info.workgroupSize * info.itemsPerInvocation),
+      scanPipeline_(CreatePipeline("Prefix sum", info, "#define COMPACT 0\n", {scanSource})),
+      uniformBuffer_(sizeof(ScanUniforms), BufferStorageFlag::DYNAMIC_STORAGE)
+  {
+  }
+
+  void PrefixSum::ExclusiveScan(const Buffer& input, Buffer& output, uint32_t count)
+  {
+    BeginCompute("Prefix sum");
+    RecordExclusiveScan(input, output, count);
+    EndCompute();
+
+#ifdef FWOG_DEBUG
+    // The sum can only be checked on the GPU, so this waits for the scan to finish
+    MemoryBarrier(MemoryBarrierBit::BUFFER_UPDATE_BIT);
+    auto overflow = ReadbackBuffer(*stateBuffer_, sizeof(uint32_t), sizeof(uint32_t));
+    overflow.Wait();
+    FWOG_ASSERT(overflow.DataAs<uint32_t>()[0] == 0 && "The sum of the elements must be less than 2^30");
+#endif
+  }
+
+  void PrefixSum::RecordExclusiveScan(const Buffer& input, Buffer& output, uint32_t count)
+  {
+    const auto tileCount = GetTileCount(count, tileSize_);
+    ResetScanState(stateBuffer_, tileCount);
+    uniformBuffer_.UpdateData(ScanUniforms{.count = count});
+
+    Cmd::BindComputePipeline(scanPipeline_);
+    Cmd::BindUniformBuffer(0, uniformBuffer_);
+    Cmd::BindStorageBuffer(0, input);
+    Cmd::BindStorageBuffer(1, output);
+    Cmd::BindStorageBuffer(2, *stateBuffer_);
+    Cmd::Dispatch(tileCount, 1, 1);
+  }
+
+  StreamCompaction::StreamCompaction(const ParallelPrimitivesInfo& info)
+    : tileSize_(info.workgroupSize * info.itemsPerInvocation),
+      compactPipeline_(CreatePipeline("Stream compaction", info, "#define COMPACT 1\n", {scanSource})),
+      uniformBuffer_(sizeof(CompactUniforms), BufferStorageFlag::DYNAMIC_STORAGE)
+  {
+  }
+
+  void StreamCompaction::Compact(const Buffer& values,
+                                 const Buffer& flags,
+                                 Buffer& output,
+                                 Buffer& result,
+                                 uint32_t count,
+                                 uint32_t dispatchGroupSize)
+  {
+    Record(&values, flags, output, result, count, dispatchGroupSize);
+  }
+
+  void StreamCompaction::CompactIndices(const Buffer& flags,
+                                        Buffer& output,
+                                        Buffer& result,
+                                        uint32_t count,
+                                        uint32_t dispatchGroupSize)
+  {
+    Record(nullptr, flags, output, result, count, dispatchGroupSize);
+  }
+
+  void StreamCompaction::Record(const Buffer* values,
+                                const Buffer& flags,
+                                Buffer& output,
+                                Buffer& result,
+                                uint32_t count,
+                                uint32_t dispatchGroupSize)
+  {
+    FWOG_ASSERT(dispatchGroupSize > 0);
+    FWOG_ASSERT(result.Size() >= sizeof(CompactionResult));
+    FWOG_ASSERT(count <= MAX_SCAN_SUM && "Too many elements for the scan");
+
+    // The last tile writes the result, so there must be at least one even if there are no elements
+    const auto tileCount = GetTileCount(count, tileSize_);
+    ResetScanState(stateBuffer_, tileCount);
+    uniformBuffer_.UpdateData(CompactUniforms{
+      .count = count,
+      .writeIndices = values == nullptr,
+      .dispatchGroupSize = dispatchGroupSize,
+    });
+
+    BeginCompute("Stream compaction");
+    Cmd::BindComputePipeline(compactPipeline_);
+    Cmd::BindUniformBuffer(0, uniformBuffer_);
+    Cmd::BindStorageBuffer(0, flags);
+    Cmd::BindStorageBuffer(1, output);
+    Cmd::BindStorageBuffer(2, *stateBuffer_);
+    // The values binding is unused when indices are written, but something must be bound to it
+    Cmd::BindStorageBuffer(3, values ? *values : flags);
+    Cmd::BindStorageBuffer(4, result);
+    Cmd::Dispatch(tileCount, 1, 1);
+    EndCompute();
+  }
+
+  RadixSort::RadixSort(const ParallelPrimitivesInfo& info)
+    : tileSize_(info.workgroupSize * info.itemsPerInvocation),
+      prefixSum_(info),
+      histogramPipeline_(
+        CreatePipeline("Radix sort histogram", info, {}, {radixUniformsSource, radixHistogramSource})),
+      scatterPipeline_(CreatePipeline("Radix sort scatter", info, {}, {radixUniformsSource, radixScatterSource})),
+      uniformBuffer_(GetUniformStride(sizeof(RadixSortUniforms)) * (32 / RADIX_BITS),
+                     BufferStorageFlag::DYNAMIC_STORAGE)
+  {
+  }
+
+  void RadixSort::SortPairs(Buffer& keys, Buffer& values, uint32_t count, uint32_t keyBits)
+  {
+    FWOG_ASSERT(keyBits > 0 && keyBits <= 32);
+
+    // The digit counts of all tiles sum to count
+    FWOG_ASSERT(count <= MAX_SCAN_SUM && "Too many elements for the scan");
+
+    if (count <= 1)
+    {
+      return;
+    }
+
+    const auto tileCount = GetTileCount(count, tileSize_);
+    const auto passCount = (keyBits + RADIX_BITS - 1) / RADIX_BITS;
+    const auto uniformStride = GetUniformStride(sizeof(RadixSortUniforms));
+    const auto histogramCount = RADIX * tileCount;
+
+    EnsureSize(keysScratch_, sizeof(uint32_t) * static_cast<size_t>(count));
+    EnsureSize(valuesScratch_, sizeof(uint32_t) * static_cast<size_t>(count));
+    EnsureSize(histogramBuffer_, sizeof(uint32_t) * static_cast<size_t>(histogramCount));
+
+    for (uint32_t pass = 0; pass < passCount; pass++)
+    {
+      uniformBuffer_.UpdateData(
+        RadixSortUniforms{
+          .count = count,
+          .shift = pass * RADIX_BITS,
+          .tileCount = tileCount,
+        },
+        pass * uniformStride);
+    }
+
+    BeginCompute("Radix sort");
+    for (uint32_t pass = 0; pass < passCount; pass++)
+    {
+      // Passes alternate between the caller's buffers and the scratch buffers
+      Buffer& keysIn = pass % 2 == 0 ? keys : *keysScratch_;
+      Buffer& keysOut = pass % 2 == 0 ? *keysScratch_ : keys;
+      Buffer& valuesIn = pass % 2 == 0 ? values : *valuesScratch_;
+      Buffer& valuesOut = pass % 2 == 0 ? *valuesScratch_ : values;
+
+      Cmd::BindComputePipeline(histogramPipeline_);
+      Cmd::BindUniformBuffer(0, uniformBuffer_, pass * uniformStride, sizeof(RadixSortUniforms));
+      Cmd::BindStorageBuffer(0, keysIn);
+      Cmd::BindStorageBuffer(1, *histogramBuffer_);
+      Cmd::Dispatch(tileCount, 1, 1);
+
+      // The digit counts are scanned in place to get the offsets
+      MemoryBarrier(MemoryBarrierBit::SHADER_STORAGE_BIT);
+      prefixSum_.RecordExclusiveScan(*histogramBuffer_, *histogramBuffer_, histogramCount);
+
+      MemoryBarrier(MemoryBarrierBit::SHADER_STORAGE_BIT);
+      Cmd::BindComputePipeline(scatterPipeline_);
+      Cmd::BindUniformBuffer(0, uniformBuffer_, pass * uniformStride, sizeof(RadixSortUniforms));
+      Cmd::BindStorageBuffer(0, keysIn);
+      Cmd::BindStorageBuffer(1, keysOut);
+      Cmd::BindStorageBuffer(2, *histogramBuffer_);
+      Cmd::BindStorageBuffer(3, valuesIn);
+      Cmd::BindStorageBuffer(4, valuesOut);
+      Cmd::Dispatch(tileCount, 1, 1);
+
+      MemoryBarrier(MemoryBarrierBit::SHADER_STORAGE_BIT);
+    }
+    EndCompute();
+
+    // After an odd number of passes, the sorted pairs are in the scratch buffers
+    if (passCount % 2 != 0)
+    {
+      MemoryBarrier(MemoryBarrierBit::BUFFER_UPDATE_BIT);
+      CopyBuffer({.source = *keysScratch_, .target = keys, .size = sizeof(uint32_t) * static_cast<uint64_t>(count)});
+      CopyBuffer(
+        {.source = *valuesScratch_, .target = values, .size = sizeof(uint32_t) * static_cast<uint64_t>(count)});
+    }
+  }
+} // namespace Fwog
@@ -1,5 +1,6 @@
 #include <Fwog/Context.h>
 #include <Fwog/Pipeline.h>
+#include <Fwog/detail/ContextState.h>
 #include <Fwog/detail/PipelineManager.h>
 
 #include <utility>
@@ -15,7 +16,8 @@ namespace Fwog
 
   GraphicsPipeline::~GraphicsPipeline()
   {
-    if (id_ != 0)
+    if (id_ != 0 &&
+        !detail::TryDeferDestruction(detail::DeferredDestruction::Type::GRAPHICS_PIPELINE, static_cast<uint32_t>(id_)))
     {
       detail::DestroyGraphicsPipelineInternal(id_);
     }
@@ -52,7 +54,8 @@ namespace Fwog
 
   ComputePipeline::~ComputePipeline()
   {
-    if (id_ != 0)
+    if (id_ != 0 &&
+        !detail::TryDeferDestruction(detail::DeferredDestruction::Type::COMPUTE_PIPELINE, static_cast<uint32_t>(id_)))
     {
       detail::DestroyComputePipelineInternal(id_);
     }
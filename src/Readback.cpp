@@ -0,0 +1,159 @@
+#include <Fwog/Readback.h>
+#include <Fwog/Rendering.h>
+#include <Fwog/Texture.h>
+#include <Fwog/detail/ApiToEnum.h>
+#include <Fwog/detail/ContextState.h>
+
+#include <algorithm>
+#include <bit>
+#include <new>
+#include <utility>
+
+namespace Fwog
+{
+  namespace
+  {
+    // Pooled buffers are at least this large, so small readbacks (e.g. counters) share the same size class
+    constexpr size_t MIN_READBACK_BUFFER_SIZE = 4096;
+
+    // Bounds the amount of memory that is kept around by the pool
+    constexpr size_t MAX_POOLED_READBACK_BUFFERS = 16;
+
+    Buffer AcquireReadbackBuffer(size_t size)
+    {
+      auto& pool = detail::context->readbackBufferPool;
+
+      // Take the smallest pooled buffer that is large enough, but don't waste more than half of it
+      auto best = pool.end();
+      for (auto it = pool.begin(); it != pool.end(); ++it)
+      {
+        if (it->Size() >= size && it->Size() / 2 <= size && (best == pool.end() || it->Size() < best->Size()))
+        {
+          best = it;
+        }
+      }
+
+      if (best != pool.end())
+      {
+        auto buffer = std::move(*best);
+        pool.erase(best);
+        return buffer;
+      }
+
+      // Non-coherent mappings can be placed in cached system memory, which makes reading them much faster
+      return Buffer(std::bit_ceil(std::max(size, MIN_READBACK_BUFFER_SIZE)),
+                    BufferStorageFlag::MAP_MEMORY | BufferStorageFlag::MAP_NON_COHERENT |
+                      BufferStorageFlag::CLIENT_STORAGE);
+    }
+
+    void ReleaseReadbackBuffer(Buffer&& buffer)
+    {
+      if (buffer.Handle() == 0 || detail::context == nullptr)
+      {
+        return;
+      }
+
+      auto& pool = detail::context->readbackBufferPool;
+      if (pool.size() >= MAX_POOLED_READBACK_BUFFERS)
+      {
+        pool.erase(pool.begin());
+      }
+      pool.emplace_back(std::move(buffer));
+    }
+  } // namespace
+
+  ReadbackResult::ReadbackResult(Buffer&& buffer, size_t size) : buffer_(std::move(buffer)), size_(size)
+  {
+    buffer_.InvalidateMappedRange(0, size_);
+    fence_.Signal();
+  }
+
+  ReadbackResult& ReadbackResult::operator=(ReadbackResult&& old) noexcept
+  {
+    if (&old == this)
+      return *this;
+    this->~ReadbackResult();
+    return *new (this) ReadbackResult(std::move(old));
+  }
+
+  ReadbackResult::~ReadbackResult()
+  {
+    ReleaseReadbackBuffer(std::move(buffer_));
+  }
+
+  bool ReadbackResult::IsReady()
+  {
+    if (!isReady_)
+    {
+      isReady_ = fence_.IsSignaled();
+    }
+
+    return isReady_;
+  }
+
+  void ReadbackResult::Wait()
+  {
+    if (!isReady_)
+    {
+      fence_.Wait();
+      isReady_ = true;
+    }
+  }
+
+  std::span<const std::byte> ReadbackResult::Data() const
+  {
+    FWOG_ASSERT(isReady_ && "The readback has not completed");
+    return {static_cast<const std::byte*>(buffer_.GetMappedPointer()), size_};
+  }
+
+  ReadbackResult ReadbackBuffer(const Buffer& source, uint64_t sourceOffset, uint64_t size)
+  {
+    if (size == WHOLE_BUFFER)
+    {
+      size = source.Size() - sourceOffset;
+    }
+
+    FWOG_ASSERT(sourceOffset + size <= source.Size());
+
+    auto buffer = AcquireReadbackBuffer(size);
+    CopyBuffer({
+      .source = source,
+      .target = buffer,
+      .sourceOffset = sourceOffset,
+      .targetOffset = 0,
+      .size = size,
+    });
+
+    return ReadbackResult(std::move(buffer), size);
+  }
+
+  ReadbackResult ReadbackTexture(const ReadbackTextureInfo& info)
+  {
+    const auto textureFormat = info.sourceTexture.GetCreateInfo().format;
+    FWOG_ASSERT(!detail::IsBlockCompressedFormat(textureFormat));
+
+    const GLenum format = info.format == UploadFormat::INFER_FORMAT
+                            ? detail::UploadFormatToGL(detail::FormatToUploadFormat(textureFormat))
+                            : detail::UploadFormatToGL(info.format);
+    const GLenum type = info.type == UploadType::INFER_TYPE ? detail::FormatToTypeGL(textureFormat)
+                                                            : detail::UploadTypeToGL(info.type);
+    const auto size = static_cast<size_t>(detail::PixelDataSizeGL(format, type, info.extent, 0, 0));
+
+    auto buffer = AcquireReadbackBuffer(size);
+    CopyTextureToBuffer({
+      .sourceTexture = info.sourceTexture,
+      .targetBuffer = buffer,
+      .level = info.level,
+      .sourceOffset = info.sourceOffset,
+      .targetOffset = 0,
+      .extent = info.extent,
+      .format = info.format,
+      .type = info.type,
+    });
+
+    // Don't leave the readback buffer bound, or later client memory reads would write to it
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    return ReadbackResult(std::move(buffer), size);
+  }
+} // namespace Fwog
@@ -628,7 +628,7 @@ namespace Fwog
     glGetTextureSubImage(const_cast<Texture&>(copy.sourceTexture).Handle(),
                          copy.level,
                          copy.sourceOffset.x,
-                         copy.sourceOffset.z,
+                         copy.sourceOffset.y,
                          copy.sourceOffset.z,
                          copy.extent.width,
                          copy.extent.height,
@@ -1,8 +1,12 @@
+#include <Fwog/Rendering.h>
 #include <Fwog/Texture.h>
 #include <Fwog/detail/ApiToEnum.h>
 #include <Fwog/detail/ContextState.h>
 
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <cstring>
 #include <new>
 #include <utility>
 
@@ -57,6 +61,87 @@ namespace Fwog
     }
   } // namespace detail
 
+  namespace
+  {
+    // Small uploads are rounded up so their staging buffers can be reused by other uploads
+    constexpr size_t MIN_STAGING_BUFFER_SIZE = 64 * 1024;
+
+    // Bounds the amount of memory that is kept around by the pool
+    constexpr size_t MAX_POOLED_STAGING_BUFFERS = 16;
+
+    // Bounds the amount of staging memory that asynchronous uploads can keep alive at once
+    constexpr size_t MAX_IN_FLIGHT_STAGING_BYTES = 256 * 1024 * 1024;
+
+    void ReleaseStagingBuffer(Buffer&& buffer)
+    {
+      auto& pool = detail::context->stagingBufferPool;
+      if (pool.size() >= MAX_POOLED_STAGING_BUFFERS)
+      {
+        pool.erase(pool.begin());
+      }
+      pool.emplace_back(std::move(buffer));
+    }
+
+    Buffer AcquireStagingBuffer(size_t size)
+    {
+      auto& inFlight = detail::context->inFlightStagingBuffers;
+      auto& timeline = detail::context->stagingTimeline;
+
+      size_t inFlightBytes = 0;
+      for (const auto& staging : inFlight)
+      {
+        inFlightBytes += staging.buffer.Size();
+      }
+
+      // Recycle buffers the GPU is done with, waiting for the oldest ones if too much memory is in use.
+      // Timeline values increase monotonically, so the front of the queue always completes first
+      while (!inFlight.empty())
+      {
+        auto& oldest = inFlight.front();
+        if (inFlightBytes + size > MAX_IN_FLIGHT_STAGING_BYTES)
+        {
+          timeline.Wait(oldest.timelineValue);
+        }
+        else if (!timeline.IsComplete(oldest.timelineValue))
+        {
+          break;
+        }
+
+        inFlightBytes -= oldest.buffer.Size();
+        ReleaseStagingBuffer(std::move(oldest.buffer));
+        inFlight.pop_front();
+      }
+
+      // Take the smallest pooled buffer that is large enough, but don't waste more than half of it
+      auto& pool = detail::context->stagingBufferPool;
+      auto best = pool.end();
+      for (auto it = pool.begin(); it != pool.end(); ++it)
+      {
+        if (it->Size() >= size && it->Size() / 2 <= size && (best == pool.end() || it->Size() < best->Size()))
+        {
+          best = it;
+        }
+      }
+
+      if (best != pool.end())
+      {
+        auto buffer = std::move(*best);
+        pool.erase(best);
+        return buffer;
+      }
+
+      return Buffer(std::bit_ceil(std::max(size, MIN_STAGING_BUFFER_SIZE)),
+                    BufferStorageFlag::MAP_MEMORY | BufferStorageFlag::CLIENT_STORAGE);
+    }
+
+    // Keeps a staging buffer alive until the GPU has executed the commands that read from it
+    void SubmitStagingBuffer(Buffer&& buffer)
+    {
+      const auto value = detail::context->stagingTimeline.Signal();
+      detail::context->inFlightStagingBuffers.push_back({std::move(buffer), value});
+    }
+  } // namespace
+
   Texture::Texture(const TextureCreateInfo& createInfo, std::string_view name) : createInfo_(createInfo)
   {
     glCreateTextures(detail::ImageTypeToGL(createInfo.imageType), 1, &id_);
@@ -135,6 +220,11 @@ namespace Fwog
     {
       glObjectLabel(GL_TEXTURE, id_, static_cast<GLsizei>(name.length()), name.data());
     }
+
+    detail::context->resourceRegistry.AddTexture(id_,
+                                                 ResourceCategory::TEXTURE,
+                                                 detail::EstimateTextureSize(createInfo),
+                                                 name);
   }
 
   Texture::Texture(Texture&& old) noexcept
@@ -157,11 +247,20 @@ namespace Fwog
       return;
     }
 
+    // The parent's cached views can no longer be requested, so they are deleted once they are unreferenced
+    Fwog::detail::context->textureViewCache.RemoveParent(id_);
+
+    if (detail::TryDeferDestruction(detail::DeferredDestruction::Type::TEXTURE, id_, bindlessHandle_))
+    {
+      return;
+    }
+
     if (bindlessHandle_ != 0)
     {
       glMakeTextureHandleNonResidentARB(bindlessHandle_);
     }
     glDeleteTextures(1, &id_);
+    Fwog::detail::context->resourceRegistry.RemoveTexture(id_);
     // Ensure that the texture is no longer referenced in the FBO cache
     Fwog::detail::context->fboCache.RemoveTexture(*this);
   }
@@ -219,6 +318,27 @@ namespace Fwog
     return TextureView(createInfo, *this);
   }
 
+  TextureView Texture::CreateCachedView(const TextureViewCreateInfo& viewInfo)
+  {
+    auto& cache = detail::context->textureViewCache;
+
+    TextureView view;
+    view.viewInfo_ = viewInfo;
+    view.createInfo_ = createInfo_;
+    view.isCached_ = true;
+    if (auto cachedId = cache.Acquire(id_, viewInfo))
+    {
+      view.id_ = *cachedId;
+      return view;
+    }
+
+    // The new view takes the GL texture from a temporary, uncached view
+    auto newView = TextureView(viewInfo, *this);
+    view.id_ = std::exchange(newView.id_, 0);
+    cache.Insert(id_, viewInfo, view.id_);
+    return view;
+  }
+
   uint64_t Texture::GetBindlessHandle(Sampler sampler)
   {
     FWOG_ASSERT(detail::context->properties.features.bindlessTextures && "GL_ARB_bindless_texture is not supported");
@@ -241,6 +361,59 @@ namespace Fwog
     subCompressedImageInternal(info);
   }
 
+  void Texture::UpdateImageAsync(const TextureUpdateInfo& info)
+  {
+    FWOG_ASSERT(info.pixels != nullptr);
+
+    const GLenum format = info.format == UploadFormat::INFER_FORMAT
+                            ? detail::UploadFormatToGL(detail::FormatToUploadFormat(createInfo_.format))
+                            : detail::UploadFormatToGL(info.format);
+    const GLenum type = info.type == UploadType::INFER_TYPE ? detail::FormatToTypeGL(createInfo_.format)
+                                                            : detail::UploadTypeToGL(info.type);
+    const auto size = detail::PixelDataSizeGL(format, type, info.extent, info.rowLength, info.imageHeight);
+
+    auto staging = AcquireStagingBuffer(size);
+    std::memcpy(staging.GetMappedPointer(), info.pixels, size);
+
+    CopyBufferToTexture({
+      .sourceBuffer = staging,
+      .targetTexture = *this,
+      .level = info.level,
+      .targetOffset = info.offset,
+      .extent = info.extent,
+      .format = info.format,
+      .type = info.type,
+      .bufferRowLength = info.rowLength,
+      .bufferImageHeight = info.imageHeight,
+    });
+
+    // Don't leave the staging buffer bound, or later client memory uploads would source from it
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    SubmitStagingBuffer(std::move(staging));
+  }
+
+  void Texture::UpdateCompressedImageAsync(const CompressedTextureUpdateInfo& info)
+  {
+    FWOG_ASSERT(info.data != nullptr);
+
+    const auto size = detail::GetBlockCompressedImageSize(createInfo_.format,
+                                                          info.extent.width,
+                                                          info.extent.height,
+                                                          std::max(info.extent.depth, 1u));
+
+    auto staging = AcquireStagingBuffer(size);
+    std::memcpy(staging.GetMappedPointer(), info.data, size);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.Handle());
+    auto stagedInfo = info;
+    stagedInfo.data = nullptr;
+    subCompressedImageInternal(stagedInfo);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    SubmitStagingBuffer(std::move(staging));
+  }
+
   void Texture::subImageInternal(const TextureUpdateInfo& info)
   {
     FWOG_ASSERT(!detail::IsBlockCompressedFormat(createInfo_.format));
@@ -412,6 +585,22 @@ namespace Fwog
     {
       glObjectLabel(GL_TEXTURE, id_, static_cast<GLsizei>(name.length()), name.data());
     }
+
+    // The size of the viewed subresources, which the view does not own
+    const auto viewedInfo = TextureCreateInfo{
+      .imageType = viewInfo.viewType,
+      .format = viewInfo.format,
+      .extent = {std::max(createInfo_.extent.width >> viewInfo.minLevel, 1u),
+                 std::max(createInfo_.extent.height >> viewInfo.minLevel, 1u),
+                 std::max(createInfo_.extent.depth >> viewInfo.minLevel, 1u)},
+      .mipLevels = viewInfo.numLevels,
+      .arrayLayers = viewInfo.numLayers,
+      .sampleCount = createInfo_.sampleCount,
+    };
+    detail::context->resourceRegistry.AddTexture(id_,
+                                                 ResourceCategory::TEXTURE_VIEW,
+                                                 detail::EstimateTextureSize(viewedInfo),
+                                                 name);
   }
 
   TextureView::TextureView(const TextureViewCreateInfo& viewInfo, TextureView& textureView, std::string_view name)
@@ -441,7 +630,10 @@ namespace Fwog
   {
   }
 
-  TextureView::TextureView(TextureView&& old) noexcept : Texture(std::move(old)), viewInfo_(old.viewInfo_) {}
+  TextureView::TextureView(TextureView&& old) noexcept
+    : Texture(std::move(old)), viewInfo_(old.viewInfo_), isCached_(std::exchange(old.isCached_, false))
+  {
+  }
 
   TextureView& TextureView::operator=(TextureView&& old) noexcept
   {
@@ -451,7 +643,14 @@ namespace Fwog
     return *new (this) TextureView(std::move(old));
   }
 
-  TextureView::~TextureView() {}
+  TextureView::~TextureView()
+  {
+    if (isCached_ && id_ != 0)
+    {
+      // The cache deletes the GL texture, so ~Texture must not
+      detail::context->textureViewCache.Release(std::exchange(id_, 0));
+    }
+  }
 
   Sampler::Sampler(const SamplerState& samplerState)
     : Sampler(Fwog::detail::context->samplerCache.CreateOrGetCachedTextureSampler(samplerState))
@@ -0,0 +1,105 @@
+#include <Fwog/Timeline.h>
+
+#include <new>
+#include <utility>
+
+#include FWOG_OPENGL_HEADER
+
+namespace Fwog
+{
+  Timeline::Timeline() {}
+
+  Timeline::Timeline(Timeline&& old) noexcept
+    : signaledValue_(std::exchange(old.signaledValue_, 0)),
+      completedValue_(std::exchange(old.completedValue_, 0)),
+      pending_(std::exchange(old.pending_, {}))
+  {
+  }
+
+  Timeline& Timeline::operator=(Timeline&& old) noexcept
+  {
+    if (this == &old)
+      return *this;
+    this->~Timeline();
+    return *new (this) Timeline(std::move(old));
+  }
+
+  Timeline::~Timeline()
+  {
+    for (const auto& point : pending_)
+    {
+      glDeleteSync(reinterpret_cast<GLsync>(point.sync));
+    }
+  }
+
+  uint64_t Timeline::Signal()
+  {
+    auto* sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    pending_.push_back({++signaledValue_, sync});
+    return signaledValue_;
+  }
+
+  uint64_t Timeline::GetCompletedValue()
+  {
+    // Points complete in order, so polling can stop at the first one that hasn't been reached
+    while (!pending_.empty())
+    {
+      const auto& point = pending_.front();
+      GLenum result = glClientWaitSync(reinterpret_cast<GLsync>(point.sync), GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+      FWOG_ASSERT(result != GL_WAIT_FAILED);
+      if (result == GL_TIMEOUT_EXPIRED)
+      {
+        break;
+      }
+      Retire(point.value);
+    }
+
+    return completedValue_;
+  }
+
+  bool Timeline::IsComplete(uint64_t value)
+  {
+    FWOG_ASSERT(value <= signaledValue_ && "The value has not been signaled");
+    return value <= completedValue_ || value <= GetCompletedValue();
+  }
+
+  bool Timeline::Wait(uint64_t value, uint64_t timeoutNanoseconds)
+  {
+    FWOG_ASSERT(value <= signaledValue_ && "The value has not been signaled");
+    if (value <= completedValue_)
+    {
+      return true;
+    }
+
+    // Only the first point at or after the value needs to be waited on
+    for (const auto& point : pending_)
+    {
+      if (point.value >= value)
+      {
+        GLenum result =
+          glClientWaitSync(reinterpret_cast<GLsync>(point.sync), GL_SYNC_FLUSH_COMMANDS_BIT, timeoutNanoseconds);
+        FWOG_ASSERT(result != GL_WAIT_FAILED);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+          return false;
+        }
+        Retire(point.value);
+        return true;
+      }
+    }
+
+    FWOG_ASSERT(false && "Unreachable");
+    return false;
+  }
+
+  void Timeline::Retire(uint64_t value)
+  {
+    while (!pending_.empty() && pending_.front().value <= value)
+    {
+      glDeleteSync(reinterpret_cast<GLsync>(pending_.front().sync));
+      pending_.pop_front();
+    }
+
+    completedValue_ = value;
+  }
+} // namespace Fwog
@@ -0,0 +1,193 @@
+#include <Fwog/Rendering.h>
+#include <Fwog/UploadQueue.h>
+#include <Fwog/detail/ApiToEnum.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include FWOG_OPENGL_HEADER
+
+namespace Fwog
+{
+  namespace
+  {
+    // Pixel unpack offsets must be a multiple of the size of the upload type. 16 bytes covers every type
+    constexpr uint64_t STAGING_ALIGNMENT = 16;
+
+    uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+      return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // Computes the number of bytes GL reads from client memory for an image upload
+    uint64_t ImageUploadSize(const Texture& texture, const TextureUpdateInfo& info)
+    {
+      const auto textureFormat = texture.GetCreateInfo().format;
+      const GLenum format = info.format == UploadFormat::INFER_FORMAT
+                              ? detail::UploadFormatToGL(detail::FormatToUploadFormat(textureFormat))
+                              : detail::UploadFormatToGL(info.format);
+      const GLenum type = info.type == UploadType::INFER_TYPE ? detail::FormatToTypeGL(textureFormat)
+                                                              : detail::UploadTypeToGL(info.type);
+
+      return detail::PixelDataSizeGL(format, type, info.extent, info.rowLength, info.imageHeight);
+    }
+
+    template<class... Ts>
+    struct Overloaded : Ts...
+    {
+      using Ts::operator()...;
+    };
+  } // namespace
+
+  // Positions in the ring are aligned, not staging offsets. Rounding the size up makes each lap of the ring start at an
+  // aligned position, so the offsets are aligned too
+  UploadQueue::UploadQueue(size_t stagingSize)
+    : stagingSize_(static_cast<size_t>(AlignUp(stagingSize, STAGING_ALIGNMENT))),
+      stagingBuffer_(stagingSize_, BufferStorageFlag::MAP_MEMORY)
+  {
+    FWOG_ASSERT(stagingSize > 0);
+  }
+
+  UploadQueue::~UploadQueue() = default;
+
+  void UploadQueue::UploadBuffer(Buffer& target, TriviallyCopyableByteSpan data, uint64_t targetOffset)
+  {
+    FWOG_ASSERT(targetOffset + data.size_bytes() <= target.Size());
+
+    if (data.empty())
+    {
+      return;
+    }
+
+    const uint64_t stagingOffset = Allocate(data.size_bytes());
+    std::memcpy(static_cast<std::byte*>(stagingBuffer_.GetMappedPointer()) + stagingOffset,
+                data.data(),
+                data.size_bytes());
+
+    pendingCopies_.emplace_back(BufferCopy{&target, stagingOffset, targetOffset, data.size_bytes()});
+  }
+
+  void UploadQueue::UploadImage(Texture& target, const TextureUpdateInfo& info)
+  {
+    FWOG_ASSERT(info.pixels != nullptr);
+
+    const uint64_t size = ImageUploadSize(target, info);
+    const uint64_t stagingOffset = Allocate(size);
+    std::memcpy(static_cast<std::byte*>(stagingBuffer_.GetMappedPointer()) + stagingOffset, info.pixels, size);
+
+    auto stagedInfo = info;
+    stagedInfo.pixels = nullptr;
+    pendingCopies_.emplace_back(ImageCopy{&target, stagingOffset, stagedInfo});
+  }
+
+  void UploadQueue::UploadCompressedImage(Texture& target, const CompressedTextureUpdateInfo& info)
+  {
+    FWOG_ASSERT(info.data != nullptr);
+
+    const uint64_t size = detail::GetBlockCompressedImageSize(target.GetCreateInfo().format,
+                                                              info.extent.width,
+                                                              info.extent.height,
+                                                              std::max(info.extent.depth, 1u));
+    const uint64_t stagingOffset = Allocate(size);
+    std::memcpy(static_cast<std::byte*>(stagingBuffer_.GetMappedPointer()) + stagingOffset, info.data, size);
+
+    auto stagedInfo = info;
+    stagedInfo.data = nullptr;
+    pendingCopies_.emplace_back(CompressedImageCopy{&target, stagingOffset, stagedInfo});
+  }
+
+  void UploadQueue::Flush()
+  {
+    if (pendingCopies_.empty())
+    {
+      return;
+    }
+
+    for (const auto& pendingCopy : pendingCopies_)
+    {
+      std::visit(Overloaded{
+                   [this](const BufferCopy& copy)
+                   {
+                     CopyBuffer({
+                       .source = stagingBuffer_,
+                       .target = *copy.target,
+                       .sourceOffset = copy.stagingOffset,
+                       .targetOffset = copy.targetOffset,
+                       .size = copy.size,
+                     });
+                   },
+                   [this](const ImageCopy& copy)
+                   {
+                     CopyBufferToTexture({
+                       .sourceBuffer = stagingBuffer_,
+                       .targetTexture = *copy.target,
+                       .level = copy.info.level,
+                       .sourceOffset = copy.stagingOffset,
+                       .targetOffset = copy.info.offset,
+                       .extent = copy.info.extent,
+                       .format = copy.info.format,
+                       .type = copy.info.type,
+                       .bufferRowLength = copy.info.rowLength,
+                       .bufferImageHeight = copy.info.imageHeight,
+                     });
+                   },
+                   [this](const CompressedImageCopy& copy)
+                   {
+                     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBuffer_.Handle());
+                     auto info = copy.info;
+                     info.data = reinterpret_cast<const void*>(static_cast<uintptr_t>(copy.stagingOffset));
+                     copy.target->subCompressedImageInternal(info);
+                   },
+                 },
+                 pendingCopy);
+    }
+
+    // Don't leave the staging buffer bound, or later client memory uploads would source from it
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    batches_.push_back({timeline_.Signal(), head_});
+    pendingStart_ = head_;
+    pendingCopies_.clear();
+  }
+
+  uint64_t UploadQueue::Allocate(size_t size)
+  {
+    FWOG_ASSERT(size <= stagingSize_ && "Upload is larger than the staging buffer");
+
+    while (true)
+    {
+      uint64_t position = AlignUp(head_, STAGING_ALIGNMENT);
+
+      // Allocations may not straddle the end of the ring
+      if (position % stagingSize_ + size > stagingSize_)
+      {
+        position = (position / stagingSize_ + 1) * stagingSize_;
+      }
+
+      if (position + size - tail_ <= stagingSize_)
+      {
+        head_ = position + size;
+        return position % stagingSize_;
+      }
+
+      if (!batches_.empty())
+      {
+        // Recycle the oldest batch's staging memory
+        timeline_.Wait(batches_.front().timelineValue);
+        tail_ = batches_.front().end;
+        batches_.pop_front();
+      }
+      else if (!pendingCopies_.empty())
+      {
+        Flush();
+      }
+      else
+      {
+        // Nothing is using the ring, so start over from the beginning
+        head_ = 0;
+        tail_ = 0;
+        pendingStart_ = 0;
+      }
+    }
+  }
+} // namespace Fwog
@@ -0,0 +1,70 @@
+#include <Fwog/Context.h>
+#include <Fwog/UploadRing.h>
+
+#include <cstring>
+
+namespace Fwog
+{
+  namespace
+  {
+    size_t AlignUp(size_t value, size_t alignment)
+    {
+      FWOG_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+      return (value + alignment - 1) & ~(alignment - 1);
+    }
+  } // namespace
+
+  UploadRing::UploadRing(size_t frameSize, uint32_t framesInFlight)
+    : frameSize_(frameSize),
+      framesInFlight_(framesInFlight),
+      buffer_(frameSize * framesInFlight, BufferStorageFlag::MAP_MEMORY),
+      regionValues_(framesInFlight, 0)
+  {
+    FWOG_ASSERT(frameSize > 0);
+    FWOG_ASSERT(framesInFlight > 0);
+  }
+
+  void UploadRing::BeginFrame()
+  {
+    timeline_.Wait(regionValues_[frameIndex_]);
+
+    head_ = frameIndex_ * frameSize_;
+  }
+
+  void UploadRing::EndFrame()
+  {
+    regionValues_[frameIndex_] = timeline_.Signal();
+    frameIndex_ = (frameIndex_ + 1) % framesInFlight_;
+    head_ = frameIndex_ * frameSize_;
+  }
+
+  UploadRingAllocation UploadRing::Allocate(size_t size, size_t alignment)
+  {
+    const size_t offset = AlignUp(head_, alignment);
+    FWOG_ASSERT(offset + size <= (frameIndex_ + 1) * frameSize_ && "UploadRing frame capacity exceeded");
+    head_ = offset + size;
+
+    return UploadRingAllocation{
+      .ring = this,
+      .offset = offset,
+      .size = size,
+      .data = static_cast<std::byte*>(buffer_.GetMappedPointer()) + offset,
+    };
+  }
+
+  UploadRingAllocation UploadRing::AllocateUniform(TriviallyCopyableByteSpan data)
+  {
+    const auto alignment = static_cast<size_t>(GetDeviceProperties().limits.uniformBufferOffsetAlignment);
+    auto allocation = Allocate(data.size_bytes(), alignment);
+    std::memcpy(allocation.data, data.data(), data.size_bytes());
+    return allocation;
+  }
+
+  UploadRingAllocation UploadRing::AllocateStorage(TriviallyCopyableByteSpan data)
+  {
+    const auto alignment = static_cast<size_t>(GetDeviceProperties().limits.shaderStorageBufferOffsetAlignment);
+    auto allocation = Allocate(data.size_bytes(), alignment);
+    std::memcpy(allocation.data, data.data(), data.size_bytes());
+    return allocation;
+  }
+} // namespace Fwog
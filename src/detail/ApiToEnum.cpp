@@ -1,4 +1,5 @@
 #include <Fwog/detail/ApiToEnum.h>
+#include <algorithm>
 #include FWOG_OPENGL_HEADER
 
 namespace Fwog::detail
@@ -35,8 +36,11 @@ namespace Fwog::detail
     // https://gpuopen.com/learn/get-the-most-out-of-smart-access-memory/
     // https://basnieuwenhuizen.nl/the-catastrophe-of-reading-from-vram/
     // https://asawicki.info/news_1740_vulkan_memory_types_on_pc_and_how_to_use_them
-    constexpr GLenum memMapFlags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    constexpr GLenum memMapFlags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT;
     ret |= flags & BufferStorageFlag::MAP_MEMORY ? memMapFlags : 0;
+
+    // Unless the user opts into explicit flushes and invalidations
+    ret |= flags & BufferStorageFlag::MAP_MEMORY && !(flags & BufferStorageFlag::MAP_NON_COHERENT) ? GL_MAP_COHERENT_BIT : 0;
     return ret;
   }
 
@@ -374,6 +378,71 @@ int ImageTypeToDimension(ImageType imageType)
     }
   }
 
+  uint32_t TexelSizeGL(GLenum format, GLenum type)
+  {
+    uint32_t components = 0;
+    switch (format)
+    {
+    case GL_RED:
+    case GL_RED_INTEGER:
+    case GL_DEPTH_COMPONENT:
+    case GL_STENCIL_INDEX: components = 1; break;
+    case GL_RG:
+    case GL_RG_INTEGER: components = 2; break;
+    case GL_RGB:
+    case GL_BGR:
+    case GL_RGB_INTEGER:
+    case GL_BGR_INTEGER: components = 3; break;
+    case GL_RGBA:
+    case GL_BGRA:
+    case GL_RGBA_INTEGER:
+    case GL_BGRA_INTEGER: components = 4; break;
+    default: FWOG_UNREACHABLE; return 0;
+    }
+
+    switch (type)
+    {
+    case GL_UNSIGNED_BYTE:
+    case GL_BYTE: return components;
+    case GL_UNSIGNED_SHORT:
+    case GL_SHORT:
+    case GL_HALF_FLOAT: return 2 * components;
+    case GL_UNSIGNED_INT:
+    case GL_INT:
+    case GL_FLOAT: return 4 * components;
+    case GL_UNSIGNED_BYTE_3_3_2:
+    case GL_UNSIGNED_BYTE_2_3_3_REV: return 1;
+    case GL_UNSIGNED_SHORT_5_6_5:
+    case GL_UNSIGNED_SHORT_5_6_5_REV:
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_4_4_4_4_REV:
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+    case GL_UNSIGNED_SHORT_1_5_5_5_REV: return 2;
+    case GL_UNSIGNED_INT_8_8_8_8:
+    case GL_UNSIGNED_INT_8_8_8_8_REV:
+    case GL_UNSIGNED_INT_10_10_10_2:
+    case GL_UNSIGNED_INT_2_10_10_10_REV: return 4;
+    default: FWOG_UNREACHABLE; return 0;
+    }
+  }
+
+  uint64_t PixelDataSizeGL(GLenum format, GLenum type, Extent3D extent, uint32_t rowLength, uint32_t imageHeight)
+  {
+    // Fwog leaves GL_PACK_ALIGNMENT and GL_UNPACK_ALIGNMENT at their default of 4
+    constexpr uint64_t alignment = 4;
+
+    const uint64_t texelSize = TexelSizeGL(format, type);
+    const uint64_t width = extent.width;
+    const uint64_t height = std::max(extent.height, 1u);
+    const uint64_t depth = std::max(extent.depth, 1u);
+    const uint64_t rowTexels = rowLength != 0 ? rowLength : width;
+    const uint64_t imageRows = imageHeight != 0 ? imageHeight : height;
+
+    // Every row but the last is padded to the alignment
+    const uint64_t rowPitch = (rowTexels * texelSize + alignment - 1) & ~(alignment - 1);
+    return rowPitch * imageRows * (depth - 1) + rowPitch * (height - 1) + width * texelSize;
+  }
+
   GLenum CullModeToGL(CullMode mode)
   {
     switch (mode)
@@ -3,6 +3,8 @@
 #include "Fwog/detail/Hash.h"
 #include FWOG_OPENGL_HEADER
 
+#include <algorithm>
+
 namespace Fwog::detail
 {
   uint32_t FramebufferCache::CreateOrGetCachedFramebuffer(const RenderInfo& renderInfo)
@@ -73,33 +75,35 @@ namespace Fwog::detail
   // Must be called when a texture is deleted, otherwise the cache becomes invalid.
   void FramebufferCache::RemoveTexture(const Texture& texture)
   {
-    const TextureProxy texp = {texture.GetCreateInfo(), detail::GetHandle(texture)};
+    const uint32_t id = detail::GetHandle(texture);
+    RemoveTextures({&id, 1});
+  }
 
-    for (size_t i = 0; i < framebufferCacheKey_.size(); i++)
+  void FramebufferCache::RemoveTextures(std::span<const uint32_t> textureIds)
+  {
+    // Texture names are unique while the textures are alive, so comparing them is sufficient
+    auto isRemoved = [textureIds](const std::optional<TextureProxy>& proxy)
+    { return proxy && std::find(textureIds.begin(), textureIds.end(), proxy->id) != textureIds.end(); };
+
+    for (size_t i = 0; i < framebufferCacheKey_.size();)
     {
       const auto& attachments = framebufferCacheKey_[i];
 
-      for (const auto& ci : attachments.colorAttachments)
-      {
-        if (texp == ci)
-        {
-          framebufferCacheKey_.erase(framebufferCacheKey_.begin() + i);
-          auto fboIt = framebufferCacheValue_.begin() + i;
-          glDeleteFramebuffers(1, &*fboIt);
-          framebufferCacheValue_.erase(fboIt);
-          i--;
-          break;
-        }
-      }
+      const bool referencesTexture =
+        std::any_of(attachments.colorAttachments.begin(),
+                    attachments.colorAttachments.end(),
+                    [&](const TextureProxy& proxy) { return isRemoved(proxy); }) ||
+        isRemoved(attachments.depthAttachment) || isRemoved(attachments.stencilAttachment);
 
-      if (texp == attachments.depthAttachment || texp == attachments.stencilAttachment)
+      if (referencesTexture)
       {
+        glDeleteFramebuffers(1, &framebufferCacheValue_[i]);
         framebufferCacheKey_.erase(framebufferCacheKey_.begin() + i);
-        auto fboIt = framebufferCacheValue_.begin() + i;
-        glDeleteFramebuffers(1, &*fboIt);
-        framebufferCacheValue_.erase(fboIt);
-        i--;
-        continue;
+        framebufferCacheValue_.erase(framebufferCacheValue_.begin() + i);
+      }
+      else
+      {
+        i++;
       }
     }
   }
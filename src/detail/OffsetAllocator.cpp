@@ -0,0 +1,337 @@
+#include <Fwog/Config.h>
+#include <Fwog/detail/OffsetAllocator.h>
+
+#include <algorithm>
+#include <bit>
+
+namespace Fwog::detail
+{
+  namespace
+  {
+    constexpr uint32_t MANTISSA_BITS = 3;
+    constexpr uint32_t MANTISSA_VALUE = 1 << MANTISSA_BITS;
+    constexpr uint32_t MANTISSA_MASK = MANTISSA_VALUE - 1;
+
+    // Bin sizes follow a floating point (exponent + mantissa) distribution
+    uint32_t UintToFloatRoundUp(uint32_t size)
+    {
+      uint32_t exp = 0;
+      uint32_t mantissa = 0;
+
+      if (size < MANTISSA_VALUE)
+      {
+        // Denorm: 0..(MANTISSA_VALUE - 1)
+        mantissa = size;
+      }
+      else
+      {
+        const uint32_t highestSetBit = 31 - static_cast<uint32_t>(std::countl_zero(size));
+        const uint32_t mantissaStartBit = highestSetBit - MANTISSA_BITS;
+        exp = mantissaStartBit + 1;
+        mantissa = (size >> mantissaStartBit) & MANTISSA_MASK;
+
+        const uint32_t lowBitsMask = (1u << mantissaStartBit) - 1;
+
+        // Round up
+        if ((size & lowBitsMask) != 0)
+        {
+          mantissa++;
+        }
+      }
+
+      // + allows the mantissa to overflow into the exponent
+      return (exp << MANTISSA_BITS) + mantissa;
+    }
+
+    uint32_t UintToFloatRoundDown(uint32_t size)
+    {
+      uint32_t exp = 0;
+      uint32_t mantissa = 0;
+
+      if (size < MANTISSA_VALUE)
+      {
+        mantissa = size;
+      }
+      else
+      {
+        const uint32_t highestSetBit = 31 - static_cast<uint32_t>(std::countl_zero(size));
+        const uint32_t mantissaStartBit = highestSetBit - MANTISSA_BITS;
+        exp = mantissaStartBit + 1;
+        mantissa = (size >> mantissaStartBit) & MANTISSA_MASK;
+      }
+
+      return (exp << MANTISSA_BITS) | mantissa;
+    }
+
+    uint32_t FindLowestSetBitAfter(uint32_t bitMask, uint32_t startBitIndex)
+    {
+      if (startBitIndex >= 32)
+      {
+        return OffsetAllocator::NO_SPACE;
+      }
+
+      const uint32_t maskBeforeStartIndex = (1u << startBitIndex) - 1;
+      const uint32_t bitsAfter = bitMask & ~maskBeforeStartIndex;
+      if (bitsAfter == 0)
+      {
+        return OffsetAllocator::NO_SPACE;
+      }
+      return static_cast<uint32_t>(std::countr_zero(bitsAfter));
+    }
+  } // namespace
+
+  OffsetAllocator::OffsetAllocator(uint32_t size) : size_(size)
+  {
+    binIndices_.fill(UNUSED);
+    if (size_ > 0)
+    {
+      InsertNodeIntoBin(size_, 0);
+    }
+  }
+
+  OffsetAllocator::Allocation OffsetAllocator::Allocate(uint32_t size)
+  {
+    FWOG_ASSERT(size > 0);
+
+    // Round up to the bin index to ensure that any node in the found bin is at least as large as the allocation
+    const uint32_t minBinIndex = UintToFloatRoundUp(size);
+    const uint32_t minTopBinIndex = minBinIndex >> TOP_BINS_INDEX_SHIFT;
+    const uint32_t minLeafBinIndex = minBinIndex & LEAF_BINS_INDEX_MASK;
+
+    uint32_t topBinIndex = minTopBinIndex;
+    uint32_t leafBinIndex = NO_SPACE;
+
+    // If the top bin exists, scan its leaf bins. This can fail
+    if (topBinIndex < NUM_TOP_BINS && (usedBinsTop_ & (1u << topBinIndex)))
+    {
+      leafBinIndex = FindLowestSetBitAfter(usedBins_[topBinIndex], minLeafBinIndex);
+    }
+
+    // If we didn't find space in the top bin, search the top bins that follow. Any leaf bin in those will do
+    if (leafBinIndex == NO_SPACE)
+    {
+      topBinIndex = FindLowestSetBitAfter(usedBinsTop_, minTopBinIndex + 1);
+      if (topBinIndex == NO_SPACE)
+      {
+        return {};
+      }
+
+      leafBinIndex = static_cast<uint32_t>(std::countr_zero(static_cast<uint32_t>(usedBins_[topBinIndex])));
+    }
+
+    const uint32_t binIndex = (topBinIndex << TOP_BINS_INDEX_SHIFT) | leafBinIndex;
+
+    // Pop the top node of the bin. The bin top is always the most recently freed node
+    const uint32_t nodeIndex = binIndices_[binIndex];
+    Node& node = nodes_[nodeIndex];
+    const uint32_t nodeTotalSize = node.dataSize;
+    node.dataSize = size;
+    node.used = true;
+    binIndices_[binIndex] = node.binListNext;
+    if (node.binListNext != UNUSED)
+    {
+      nodes_[node.binListNext].binListPrev = UNUSED;
+    }
+    freeStorage_ -= nodeTotalSize;
+
+    // Bin empty?
+    if (binIndices_[binIndex] == UNUSED)
+    {
+      usedBins_[topBinIndex] &= static_cast<uint8_t>(~(1u << leafBinIndex));
+      if (usedBins_[topBinIndex] == 0)
+      {
+        usedBinsTop_ &= ~(1u << topBinIndex);
+      }
+    }
+
+    // Push the remainder back into the bins and link it as the allocated node's neighbor
+    const uint32_t reminderSize = nodeTotalSize - size;
+    if (reminderSize > 0)
+    {
+      const uint32_t dataOffset = nodes_[nodeIndex].dataOffset;
+      const uint32_t newNodeIndex = InsertNodeIntoBin(reminderSize, dataOffset + size);
+
+      // Inserting may reallocate the node storage, so nodes must be looked up again
+      const uint32_t neighborNext = nodes_[nodeIndex].neighborNext;
+      if (neighborNext != UNUSED)
+      {
+        nodes_[neighborNext].neighborPrev = newNodeIndex;
+      }
+      nodes_[newNodeIndex].neighborPrev = nodeIndex;
+      nodes_[newNodeIndex].neighborNext = neighborNext;
+      nodes_[nodeIndex].neighborNext = newNodeIndex;
+    }
+
+    allocationCount_++;
+    return {.offset = nodes_[nodeIndex].dataOffset, .node = nodeIndex};
+  }
+
+  void OffsetAllocator::Free(Allocation allocation)
+  {
+    FWOG_ASSERT(allocation.node != NO_SPACE);
+    FWOG_ASSERT(nodes_[allocation.node].used && "Double free");
+
+    const uint32_t nodeIndex = allocation.node;
+    uint32_t offset = nodes_[nodeIndex].dataOffset;
+    uint32_t size = nodes_[nodeIndex].dataSize;
+
+    // Merge with the previous free neighbor
+    if (const uint32_t prevIndex = nodes_[nodeIndex].neighborPrev; prevIndex != UNUSED && !nodes_[prevIndex].used)
+    {
+      offset = nodes_[prevIndex].dataOffset;
+      size += nodes_[prevIndex].dataSize;
+      RemoveNodeFromBin(prevIndex);
+      nodes_[nodeIndex].neighborPrev = nodes_[prevIndex].neighborPrev;
+    }
+
+    // Merge with the next free neighbor
+    if (const uint32_t nextIndex = nodes_[nodeIndex].neighborNext; nextIndex != UNUSED && !nodes_[nextIndex].used)
+    {
+      size += nodes_[nextIndex].dataSize;
+      RemoveNodeFromBin(nextIndex);
+      nodes_[nodeIndex].neighborNext = nodes_[nextIndex].neighborNext;
+    }
+
+    const uint32_t neighborNext = nodes_[nodeIndex].neighborNext;
+    const uint32_t neighborPrev = nodes_[nodeIndex].neighborPrev;
+
+    nodes_[nodeIndex] = {};
+    freeNodes_.push_back(nodeIndex);
+
+    const uint32_t combinedNodeIndex = InsertNodeIntoBin(size, offset);
+
+    if (neighborNext != UNUSED)
+    {
+      nodes_[combinedNodeIndex].neighborNext = neighborNext;
+      nodes_[neighborNext].neighborPrev = combinedNodeIndex;
+    }
+    if (neighborPrev != UNUSED)
+    {
+      nodes_[combinedNodeIndex].neighborPrev = neighborPrev;
+      nodes_[neighborPrev].neighborNext = combinedNodeIndex;
+    }
+
+    allocationCount_--;
+  }
+
+  uint32_t OffsetAllocator::AllocationSize(Allocation allocation) const
+  {
+    FWOG_ASSERT(allocation.node != NO_SPACE && nodes_[allocation.node].used);
+    return nodes_[allocation.node].dataSize;
+  }
+
+  OffsetAllocator::Stats OffsetAllocator::GetStats() const
+  {
+    Stats stats{.totalFree = freeStorage_, .allocationCount = allocationCount_};
+
+    for (uint32_t binIndex = 0; binIndex < NUM_LEAF_BINS; binIndex++)
+    {
+      for (uint32_t nodeIndex = binIndices_[binIndex]; nodeIndex != UNUSED; nodeIndex = nodes_[nodeIndex].binListNext)
+      {
+        stats.freeRegionCount++;
+        stats.largestFreeRegion = std::max(stats.largestFreeRegion, nodes_[nodeIndex].dataSize);
+      }
+    }
+
+    return stats;
+  }
+
+  std::vector<OffsetAllocator::Allocation> OffsetAllocator::GetAllocations() const
+  {
+    std::vector<Allocation> allocations;
+    allocations.reserve(allocationCount_);
+
+    for (uint32_t nodeIndex = 0; nodeIndex < nodes_.size(); nodeIndex++)
+    {
+      if (nodes_[nodeIndex].used)
+      {
+        allocations.push_back({.offset = nodes_[nodeIndex].dataOffset, .node = nodeIndex});
+      }
+    }
+
+    std::ranges::sort(allocations, {}, &Allocation::offset);
+    return allocations;
+  }
+
+  uint32_t OffsetAllocator::InsertNodeIntoBin(uint32_t size, uint32_t dataOffset)
+  {
+    // Round down to bin index to ensure that bin >= alloc
+    const uint32_t binIndex = UintToFloatRoundDown(size);
+    const uint32_t topBinIndex = binIndex >> TOP_BINS_INDEX_SHIFT;
+    const uint32_t leafBinIndex = binIndex & LEAF_BINS_INDEX_MASK;
+
+    // Bin was empty before?
+    if (binIndices_[binIndex] == UNUSED)
+    {
+      usedBins_[topBinIndex] |= static_cast<uint8_t>(1u << leafBinIndex);
+      usedBinsTop_ |= 1u << topBinIndex;
+    }
+
+    // Take a node from the pool and insert it at the head of the bin's linked list
+    const uint32_t topNodeIndex = binIndices_[binIndex];
+    const uint32_t nodeIndex = AcquireNode();
+    nodes_[nodeIndex] = {.dataOffset = dataOffset, .dataSize = size, .binListNext = topNodeIndex};
+    if (topNodeIndex != UNUSED)
+    {
+      nodes_[topNodeIndex].binListPrev = nodeIndex;
+    }
+    binIndices_[binIndex] = nodeIndex;
+
+    freeStorage_ += size;
+    return nodeIndex;
+  }
+
+  void OffsetAllocator::RemoveNodeFromBin(uint32_t nodeIndex)
+  {
+    const Node& node = nodes_[nodeIndex];
+
+    if (node.binListPrev != UNUSED)
+    {
+      // Easy case: we have a previous node, so just remove this node from the middle of the list
+      nodes_[node.binListPrev].binListNext = node.binListNext;
+      if (node.binListNext != UNUSED)
+      {
+        nodes_[node.binListNext].binListPrev = node.binListPrev;
+      }
+    }
+    else
+    {
+      // Hard case: we are the first node in a bin. Find the bin
+      const uint32_t binIndex = UintToFloatRoundDown(node.dataSize);
+      const uint32_t topBinIndex = binIndex >> TOP_BINS_INDEX_SHIFT;
+      const uint32_t leafBinIndex = binIndex & LEAF_BINS_INDEX_MASK;
+
+      binIndices_[binIndex] = node.binListNext;
+      if (node.binListNext != UNUSED)
+      {
+        nodes_[node.binListNext].binListPrev = UNUSED;
+      }
+
+      // Bin empty?
+      if (binIndices_[binIndex] == UNUSED)
+      {
+        usedBins_[topBinIndex] &= static_cast<uint8_t>(~(1u << leafBinIndex));
+        if (usedBins_[topBinIndex] == 0)
+        {
+          usedBinsTop_ &= ~(1u << topBinIndex);
+        }
+      }
+    }
+
+    freeNodes_.push_back(nodeIndex);
+    freeStorage_ -= node.dataSize;
+  }
+
+  uint32_t OffsetAllocator::AcquireNode()
+  {
+    if (!freeNodes_.empty())
+    {
+      const uint32_t nodeIndex = freeNodes_.back();
+      freeNodes_.pop_back();
+      return nodeIndex;
+    }
+
+    nodes_.emplace_back();
+    return static_cast<uint32_t>(nodes_.size() - 1);
+  }
+} // namespace Fwog::detail
@@ -0,0 +1,152 @@
+#include "Fwog/detail/ResourceRegistry.h"
+#include "Fwog/detail/ApiToEnum.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+namespace Fwog::detail
+{
+  namespace
+  {
+    uint32_t GetTexelSize(Format format)
+    {
+      switch (format)
+      {
+      case Format::R3G3B2_UNORM:
+      case Format::R8_UNORM:
+      case Format::R8_SNORM:
+      case Format::R8_SINT:
+      case Format::R8_UINT: return 1;
+      case Format::R4G4B4_UNORM:
+      case Format::R5G5B5_UNORM:
+      case Format::R4G4B4A4_UNORM:
+      case Format::R5G5B5A1_UNORM:
+      case Format::R2G2B2A2_UNORM:
+      case Format::R8G8_UNORM:
+      case Format::R8G8_SNORM:
+      case Format::R8G8_SINT:
+      case Format::R8G8_UINT:
+      case Format::R16_UNORM:
+      case Format::R16_SNORM:
+      case Format::R16_FLOAT:
+      case Format::R16_SINT:
+      case Format::R16_UINT:
+      case Format::D16_UNORM: return 2;
+      case Format::R8G8B8_UNORM:
+      case Format::R8G8B8_SNORM:
+      case Format::R8G8B8_SRGB:
+      case Format::R8G8B8_SINT:
+      case Format::R8G8B8_UINT: return 3;
+      case Format::R16G16B16_SNORM:
+      case Format::R16G16B16_FLOAT:
+      case Format::R16G16B16_SINT:
+      case Format::R16G16B16_UINT:
+      case Format::R12G12B12_UNORM: return 6;
+      case Format::R16G16B16A16_UNORM:
+      case Format::R16G16B16A16_SNORM:
+      case Format::R16G16B16A16_FLOAT:
+      case Format::R16G16B16A16_SINT:
+      case Format::R16G16B16A16_UINT:
+      case Format::R12G12B12A12_UNORM:
+      case Format::R32G32_FLOAT:
+      case Format::R32G32_SINT:
+      case Format::R32G32_UINT:
+      case Format::D32_FLOAT_S8_UINT: return 8;
+      case Format::R32G32B32_FLOAT:
+      case Format::R32G32B32_SINT:
+      case Format::R32G32B32_UINT: return 12;
+      case Format::R32G32B32A32_FLOAT:
+      case Format::R32G32B32A32_SINT:
+      case Format::R32G32B32A32_UINT: return 16;
+      default: return 4;
+      }
+    }
+  } // namespace
+
+  uint64_t EstimateTextureSize(const TextureCreateInfo& createInfo)
+  {
+    // Cube map arrays store six layer-faces per layer, which are already counted by arrayLayers
+    const auto is3D = createInfo.imageType == ImageType::TEX_3D;
+    const uint64_t layers = createInfo.imageType == ImageType::TEX_CUBEMAP ? 6 : std::max(createInfo.arrayLayers, 1u);
+    const uint64_t samples = std::max(static_cast<uint64_t>(createInfo.sampleCount), uint64_t(1));
+
+    uint64_t size = 0;
+    for (uint32_t level = 0; level < std::max(createInfo.mipLevels, 1u); level++)
+    {
+      const auto width = std::max(createInfo.extent.width >> level, 1u);
+      const auto height = std::max(createInfo.extent.height >> level, 1u);
+      const auto depth = is3D ? std::max(createInfo.extent.depth >> level, 1u) : 1u;
+      if (IsBlockCompressedFormat(createInfo.format))
+      {
+        size += GetBlockCompressedImageSize(createInfo.format, width, height, depth) * layers;
+      }
+      else
+      {
+        size += uint64_t(width) * height * depth * layers * samples * GetTexelSize(createInfo.format);
+      }
+    }
+
+    return size;
+  }
+
+  void ResourceRegistry::AddBuffer(uint32_t id, uint64_t bytes, std::string_view name)
+  {
+    buffers_.insert_or_assign(id, Resource{ResourceCategory::BUFFER, bytes, std::string(name)});
+  }
+
+  void ResourceRegistry::AddTexture(uint32_t id, ResourceCategory category, uint64_t bytes, std::string_view name)
+  {
+    textures_.insert_or_assign(id, Resource{category, bytes, std::string(name)});
+  }
+
+  void ResourceRegistry::RemoveBuffer(uint32_t id)
+  {
+    buffers_.erase(id);
+  }
+
+  void ResourceRegistry::RemoveTexture(uint32_t id)
+  {
+    textures_.erase(id);
+  }
+
+  MemoryUsage ResourceRegistry::GetUsage() const
+  {
+    MemoryUsage usage;
+    std::map<std::pair<ResourceCategory, std::string_view>, size_t> indexOfGroup;
+
+    auto addResources = [&](const std::unordered_map<uint32_t, Resource>& resources)
+    {
+      for (const auto& [id, resource] : resources)
+      {
+        switch (resource.category)
+        {
+        case ResourceCategory::BUFFER:
+          usage.bufferCount++;
+          usage.bufferBytes += resource.bytes;
+          break;
+        case ResourceCategory::TEXTURE:
+          usage.textureCount++;
+          usage.textureBytes += resource.bytes;
+          break;
+        case ResourceCategory::TEXTURE_VIEW: usage.textureViewCount++; break;
+        }
+
+        auto [it, inserted] = indexOfGroup.try_emplace({resource.category, resource.name}, usage.resources.size());
+        if (inserted)
+        {
+          usage.resources.push_back({.category = resource.category, .name = resource.name});
+        }
+        auto& group = usage.resources[it->second];
+        group.count++;
+        group.bytes += resource.bytes;
+      }
+    };
+
+    addResources(buffers_);
+    addResources(textures_);
+
+    std::ranges::stable_sort(usage.resources, std::ranges::greater{}, &ResourceUsage::bytes);
+    return usage;
+  }
+} // namespace Fwog::detail
@@ -0,0 +1,93 @@
+#include "Fwog/detail/TextureViewCache.h"
+#include "Fwog/detail/ContextState.h"
+#include FWOG_OPENGL_HEADER
+
+namespace Fwog::detail
+{
+  std::optional<uint32_t> TextureViewCache::Acquire(uint32_t parentId, const TextureViewCreateInfo& viewInfo)
+  {
+    auto it = viewsOfParent_.find(parentId);
+    if (it == viewsOfParent_.end())
+    {
+      return std::nullopt;
+    }
+
+    for (auto viewId : it->second)
+    {
+      auto& view = views_.at(viewId);
+      if (view.viewInfo == viewInfo)
+      {
+        view.refCount++;
+        return viewId;
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  void TextureViewCache::Insert(uint32_t parentId, const TextureViewCreateInfo& viewInfo, uint32_t viewId)
+  {
+    views_.emplace(viewId, View{.viewInfo = viewInfo, .refCount = 1, .isOrphaned = false});
+    viewsOfParent_[parentId].push_back(viewId);
+  }
+
+  void TextureViewCache::Release(uint32_t viewId)
+  {
+    auto& view = views_.at(viewId);
+    FWOG_ASSERT(view.refCount > 0);
+    if (--view.refCount == 0 && view.isOrphaned)
+    {
+      Destroy(viewId);
+    }
+  }
+
+  void TextureViewCache::RemoveParent(uint32_t parentId)
+  {
+    auto it = viewsOfParent_.find(parentId);
+    if (it == viewsOfParent_.end())
+    {
+      return;
+    }
+
+    // Destroying a view removes the views of it, which would invalidate the iterator
+    const auto viewIds = std::move(it->second);
+    viewsOfParent_.erase(it);
+
+    for (auto viewId : viewIds)
+    {
+      auto& view = views_.at(viewId);
+      view.isOrphaned = true;
+      if (view.refCount == 0)
+      {
+        Destroy(viewId);
+      }
+    }
+  }
+
+  void TextureViewCache::Destroy(uint32_t viewId)
+  {
+    views_.erase(viewId);
+    RemoveParent(viewId);
+
+    if (TryDeferDestruction(DeferredDestruction::Type::TEXTURE, viewId))
+    {
+      return;
+    }
+
+    context->fboCache.RemoveTextures({&viewId, 1});
+    glDeleteTextures(1, &viewId);
+    context->resourceRegistry.RemoveTexture(viewId);
+  }
+
+  void TextureViewCache::Clear()
+  {
+    // Only called when the context is destroyed, at which point nothing can reference the views
+    for (const auto& [viewId, view] : views_)
+    {
+      glDeleteTextures(1, &viewId);
+    }
+
+    views_.clear();
+    viewsOfParent_.clear();
+  }
+} // namespace Fwog::detail